@@ -20,7 +20,10 @@
 #ifndef _SP_DIRECT_H_
 #define _SP_DIRECT_H_
 
+#include <stdio.h>
+
 #include "sp_matrix.h"
+#include "sp_perm.h"
 
 /*
  * Symbolic infromation of the sparse matrix
@@ -37,12 +40,241 @@ typedef struct
   int* crs_offsets;             /* row offsets - beginning of row for CRS */
   int* ccs_indicies;            /* row indicies for CCS format of L */
   int* ccs_offsets;             /* column offsets - beginning of column */
+  int* perm;                    /* fill-reducing ordering P or 0 if natural:
+                                 * row/column perm[k] of A is k-th in PAP' */
+  int* pinv;                    /* inverse of perm or 0 */
 } sp_chol_symbolic;
 typedef sp_chol_symbolic* sp_chol_symbolic_ptr;
 
+/*
+ * Default rate of floating point operations per second used to
+ * estimate the time of the Cholesky decomposition
+ */
+#define SP_CHOL_FLOPS_RATE 1e9
+
+/*
+ * Estimates of resources needed by the Cholesky decomposition
+ * calculated from the symbolic analysis before the numeric one.
+ * Memory sizes are of the initialized objects; temporaries of the
+ * ordering and the symbolic analysis freed before the initialization
+ * returns are not included, so the peak memory usage is higher
+ */
+typedef struct
+{
+  size_t factor_bytes;          /* memory for the factor L */
+  size_t resident_bytes;        /* memory of sp_chol_factor besides L */
+  size_t mixed_bytes;           /* memory of sp_chol_mixed */
+  double flops;                 /* operations in numeric decomposition */
+  double solve_flops;           /* operations in one solve */
+  double time_numeric;          /* seconds for sp_chol_factor */
+  double time_ldl;              /* seconds for sp_ldl_factor */
+  double time_mixed;            /* seconds for sp_chol_mixed */
+  double time_solve;            /* seconds for one solve */
+} sp_chol_estimate;
+typedef sp_chol_estimate* sp_chol_estimate_ptr;
+
+/*
+ * Level schedule of the triangular matrix for the parallel
+ * triangular solvers: rows of the same level are independent and
+ * could be calculated simultaneously in forward solve (by increasing
+ * levels) and in backward solve with the transposed matrix
+ * (by decreasing levels).
+ * The schedule depends only on the portrait of the matrix, therefore
+ * it is calculated once and used with any values
+ */
+typedef struct
+{
+  int rows_count;
+  int levels_count;
+  int* levels;                  /* levels_count+1 offsets in rows */
+  int* rows;                    /* rows sorted by levels */
+  int* offsets;                 /* transposed portrait: offsets */
+  int* indicies;                /* transposed portrait: indicies */
+  int* positions;               /* position of every element of the
+                                 * transposed portrait in the matrix */
+} sp_level_schedule;
+typedef sp_level_schedule* sp_level_schedule_ptr;
+
+/* minimum number of rows in the level to be calculated in parallel */
+#define SP_SCHEDULE_PARALLEL_MIN 64
+
+/*
+ * Number of right-hand sides solved together in the block solver
+ */
+#define SP_CHOL_BLOCK_RHS 8
+
+/*
+ * Cholesky decomposition of the matrix keeping the symbolic analysis,
+ * the factor L and all workspaces between numeric refactorizations
+ * of matrices with the same portrait
+ */
+typedef struct
+{
+  sp_chol_symbolic symb;        /* symbolic analysis */
+  sp_matrix_yale L;             /* Cholesky factor of the matrix PAP' */
+  sp_matrix_yale C;             /* reordered matrix PAP' in CCS format */
+  sparse_storage_type storage_type; /* storage type of the matrix A */
+  int* offsets;                 /* portrait of A: offsets */
+  int* indicies;                /* portrait of A: indicies */
+  int* amap;                    /* position of every element of A in C */
+  int* workspace;               /* workspace of rows_count+1 elements */
+  double* x;                    /* workspace of rows_count elements */
+  double* y;                    /* workspace of rows_count elements */
+  sp_level_schedule schedule;   /* level schedule of L */
+  sp_level_schedule symb_schedule; /* level schedule of the portrait
+                                 * from the symbolic analysis, kept
+                                 * while the portrait of L is extended
+                                 * by updates */
+  double* block;                /* workspace of rows_count*
+                                 * SP_CHOL_BLOCK_RHS elements */
+  int* reach;                   /* workspace of rows_count elements */
+  char* marker;                 /* workspace of rows_count elements,
+                                 * zero between calls */
+} sp_chol_factor;
+typedef sp_chol_factor* sp_chol_factor_ptr;
+
+/*
+ * LDL' decomposition of the symmetric (possibly indefinite) matrix
+ * PAP' = LDL' with static pivot perturbation: pivots less than
+ * pivot_tolerance*max|a_ij| by absolute value are replaced by
+ * +/- this threshold. The error introduced by the perturbation is
+ * compensated by the iterative refinement in the solver
+ */
+typedef struct
+{
+  sp_chol_factor chol;          /* ordering, symbolic analysis, unit
+                                 * lower triangular factor L, reordered
+                                 * matrix PAP' and workspaces */
+  double* D;                    /* diagonal of the matrix D */
+  double* b;                    /* workspace of rows_count elements */
+  double* r;                    /* workspace of rows_count elements */
+  double* dx;                   /* workspace of rows_count elements */
+  double pivot_tolerance;       /* relative pivot perturbation threshold */
+  int refinement_steps;         /* maximum number of refinement steps */
+  int perturbed;                /* number of perturbed pivots in the
+                                 * last factorization */
+  int refinement_iterations;    /* refinement steps done in the last
+                                 * solve */
+  int converged;                /* nonzero if the last solve reached
+                                 * the refinement tolerance */
+  double residual;              /* relative residual |b-Ax|/|b| of
+                                 * the last solve */
+} sp_ldl_factor;
+typedef sp_ldl_factor* sp_ldl_factor_ptr;
+
+/*
+ * Default relative residual tolerance of the iterative refinement
+ * in the mixed precision Cholesky solver
+ */
+#define SP_CHOL_MIXED_TOLERANCE 1e-12
+
+/*
+ * Mixed precision Cholesky decomposition PAP' = LL': the factor L
+ * is calculated and stored in single precision, the solution is
+ * refined by iterations with residuals calculated in double precision.
+ * If the single precision decomposition fails or the refinement
+ * stalls, the factor is recalculated in double precision
+ */
+typedef struct
+{
+  sp_chol_factor chol;          /* ordering, symbolic analysis, reordered
+                                 * matrix PAP' and workspaces; values of
+                                 * L are allocated only after fallback */
+  float* values;                /* values of L in single precision,
+                                 * 0 after fallback */
+  float* w;                     /* workspace of rows_count elements */
+  double* b;                    /* workspace of rows_count elements */
+  double* r;                    /* workspace of rows_count elements */
+  double* dx;                   /* workspace of rows_count elements */
+  double tolerance;             /* relative residual tolerance */
+  int refinement_steps;         /* maximum number of refinement steps */
+  int iterations;               /* refinement steps in the last solve */
+  int fallback;                 /* nonzero if L is in double precision */
+} sp_chol_mixed;
+typedef sp_chol_mixed* sp_chol_mixed_ptr;
+
+/*
+ * Default pivoting threshold for the LU decomposition:
+ * the diagonal element is selected as the pivot if it is not less
+ * than threshold*(maximum element in the column)
+ */
+#define SP_LU_PIVOT_TOLERANCE 0.1
+
+/*
+ * Symbolic analysis for the sparse LU decomposition
+ */
+typedef struct
+{
+  int* q;                       /* column ordering or 0 if natural:
+                                 * column q[k] of A is k-th in AQ */
+  int lnz;                      /* initial size of L (heuristic) */
+  int unz;                      /* initial size of U (heuristic) */
+} sp_lu_symbolic;
+typedef sp_lu_symbolic* sp_lu_symbolic_ptr;
+
+/*
+ * LU decomposition PAQ = LU of the square unsymmetric matrix
+ * keeping the pivot sequence between numeric refactorizations
+ * of matrices with the same portrait
+ */
+typedef struct
+{
+  sp_lu_symbolic symb;          /* symbolic analysis */
+  sp_matrix_yale L;             /* unit lower triangular matrix,
+                                 * CCS, diagonal first */
+  sp_matrix_yale U;             /* upper triangular matrix,
+                                 * CCS, diagonal last */
+  int* pinv;                    /* row pivoting: row i of A is
+                                 * pinv[i]-th row of PAQ */
+  double tolerance;             /* pivoting threshold from 0 to 1 */
+  int* offsets;                 /* portrait of A: offsets */
+  int* indicies;                /* portrait of A: indicies */
+  int* xi;                      /* workspace of 3*rows_count elements */
+  double* x;                    /* workspace of rows_count elements */
+} sp_lu_factor;
+typedef sp_lu_factor* sp_lu_factor_ptr;
+
+/*
+ * Out-of-core Cholesky decomposition PAP' = LL'.
+ * Values and row indicies of L are split to panels of consecutive
+ * columns and spilled to the scratch file as soon as the panel is
+ * factorized; panels are streamed back during the decomposition of
+ * the next panels and in the triangular solves. Only column counts
+ * of L, arrays of rows_count elements and two panels (bounded by the
+ * memory budget) are kept in memory; row indicies of the panel are
+ * constructed from row subtrees of the elimination tree
+ */
+typedef struct
+{
+  sp_chol_symbolic symb;        /* symbolic analysis: etree, column
+                                 * counts and CCS offsets only */
+  FILE* file;                   /* scratch file with panels of L */
+  char* filename;               /* name of the scratch file or 0 if
+                                 * anonymous temporary file is used */
+  size_t budget;                /* memory budget in bytes */
+  int panels_count;
+  int* panels;                  /* panels_count+1 first columns of panels */
+  int first;                    /* first column of the current panel */
+  double* panel;                /* values of the current panel */
+  int* rows;                    /* row indicies of the current panel */
+  double* stream;               /* values of the panel read from file */
+  int* stream_rows;             /* row indicies of the panel read from file */
+  char* linked;                 /* flags of previous panels updating
+                                 * the current one */
+  double* y;                    /* workspace of rows_count elements */
+  int* pos;                     /* positions of rows in the current column */
+  int* head;                    /* heads of lists of columns to update */
+  int* next;                    /* next column in the list */
+  int* cursor;                  /* position of the next row in the column */
+  int* marker;                  /* visited nodes of row subtrees */
+} sp_chol_ooc;
+typedef sp_chol_ooc* sp_chol_ooc_ptr;
+
 /*
  * Constructs the elimination tree from the matrix in Yale format
- * the matrix shall be in CCS format
+ * the matrix shall be in CCS format, or in CRS format with symmetric
+ * portrait
+ * Complexity: nearly O(nonzeros)
  * etree is the pointer to the array with rows_count elements
  * to store the elimination tree
  * returns the nonzero value if all ok
@@ -53,10 +285,15 @@ int sp_matrix_yale_etree(sp_matrix_yale_ptr self, int* etree);
 /*
  * Constructs the nonzero portrait of the kth row of the L matrix in
  * LL^T Cholesky decomposition
+ * The matrix shall be in CCS format, or in CRS format with symmetric
+ * portrait. The etree is not modified.
+ * Complexity: O(number of nonzeros in the row of L) besides the
+ * allocation of the workspace of rows_count elements
  * out - output array with allocated size self->rows_count
- * returns the number of first meaningfull elements in out array
+ * returns the number of first meaningfull elements in out array,
+ * sorted in ascending order and including k
  * Example: if the resulting array (out) is
- * 2 7 9 10 -1 -1 -1 -1 -1 -1 -1
+ * 2 7 9 10 ...
  * then the return value is 4
  */
 int sp_matrix_yale_ereach(sp_matrix_yale_ptr self,
@@ -64,11 +301,27 @@ int sp_matrix_yale_ereach(sp_matrix_yale_ptr self,
                           int k,
                           int* out);
 
+/*
+ * The same as sp_matrix_yale_ereach with the workspace supplied by
+ * the caller, for the construction of many rows without allocations
+ * marker - workspace of rows_count elements, initially not equal to k
+ * (i.e. filled with -1 before the first call); visited nodes are
+ * marked with k, so the same workspace serves all rows without resets
+ */
+int sp_matrix_yale_ereach_marker(sp_matrix_yale_ptr self,
+                                 const int* etree,
+                                 int k,
+                                 int* marker,
+                                 int* out);
+
 /*
  * Calculates row and column counts for the Cholesky decomposition
  * row counts - number of nonzero elements in rows
  * col counts - number of nonzero elements in columns
  * by given sparse matrix self and elimination tree etree
+ * The matrix shall have symmetric portrait, CRS or CCS format.
+ * Complexity: nearly O(nonzeros) using the skeleton matrix and
+ * least common ancestors of row subtree leaves
  * returns 0 in case of error, nonzero otherwise
  */
 int sp_matrix_yale_chol_counts(sp_matrix_yale_ptr self,
@@ -94,6 +347,96 @@ int sp_matrix_yale_lower_trans_solve(sp_matrix_yale_ptr self,
                                      double* b,
                                      double* x);
 
+/*
+ * Solves SLAE L*x = b with sparse right-hand side b
+ * by given L sparse matrix in CCS format with nonzero diagonal
+ * (first in every column).
+ * Only the reach of b in the graph of L is visited, so the
+ * complexity is proportional to the number of operations
+ * b - nonzeros elements with indicies bi and values bx
+ * x - dense array of rows_count elements, shall be zero on entrance;
+ * on exit contains the solution, nonzero only in positions from xi
+ * xi - output array of rows_count elements: the nonzero portrait of
+ * the solution in the topological order
+ * workspace - array of 2*rows_count elements, the second half shall
+ * be zero on entrance and is zero on exit
+ * count - output number of elements in the portrait xi
+ * Returns nonzero if successfull
+ */
+int sp_matrix_yale_lower_solve_sparse(sp_matrix_yale_ptr self,
+                                      int nonzeros,
+                                      int* bi,
+                                      double* bx,
+                                      double* x,
+                                      int* xi,
+                                      int* workspace,
+                                      int* count);
+
+/*
+ * Creates the level schedule of the lower triangular matrix
+ * with n rows by its portrait in CRS or CCS format.
+ * Elements on and above the diagonal are ignored
+ * Complexity: O(nonzeros)
+ * Returns nonzero if successfull
+ */
+int sp_level_schedule_init(sp_level_schedule_ptr self,
+                           int n,
+                           int* offsets,
+                           int* indicies,
+                           sparse_storage_type type);
+
+/*
+ * Deallocates the level schedule values
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_level_schedule_free(sp_level_schedule_ptr self);
+
+/*
+ * Solves the SLAE with triangular matrix by the level schedule.
+ * offsets, indicies - portrait of rows of the matrix, i.e. the
+ * portrait used to create the schedule or its transposed portrait
+ * from the schedule
+ * positions - positions of elements of the portrait in values, or 0
+ * if values are in the same order as the portrait
+ * diag - diagonal of the matrix or 0 if the diagonal is in portrait,
+ * absent diagonal elements are considered unit
+ * forward - nonzero for the lower triangular matrix (elements
+ * j < i of the row i are used), 0 for the upper (j > i).
+ * Rows of the same level are calculated in parallel if compiled with
+ * OpenMP support
+ * Returns nonzero if successfull
+ */
+int sp_level_schedule_solve(sp_level_schedule_ptr self,
+                            int* offsets,
+                            int* indicies,
+                            int* positions,
+                            double* values,
+                            double* diag,
+                            int forward,
+                            double* b,
+                            double* x);
+
+/*
+ * Solves SLAE L*x = b by given L sparse matrix with nonzero diagonal
+ * and its level schedule
+ * Returns nonzero if successfull
+ */
+int sp_matrix_yale_lower_solve_scheduled(sp_matrix_yale_ptr self,
+                                         sp_level_schedule_ptr schedule,
+                                         double* b,
+                                         double* x);
+
+/*
+ * Solves SLAE L^T*x = b by given L sparse matrix with nonzero diagonal
+ * and its level schedule
+ * Returns nonzero if successfull
+ */
+int sp_matrix_yale_lower_trans_solve_scheduled(sp_matrix_yale_ptr self,
+                                               sp_level_schedule_ptr schedule,
+                                               double* b,
+                                               double* x);
+
 
 /*
  * Performs the symbolic analysis used in Cholesky decomposition
@@ -101,6 +444,20 @@ int sp_matrix_yale_lower_trans_solve(sp_matrix_yale_ptr self,
  */
 int sp_matrix_yale_chol_symbolic(sp_matrix_yale_ptr self,
                                  sp_chol_symbolic_ptr symb);
+
+/*
+ * Performs the symbolic analysis used in Cholesky decomposition
+ * of the reordered matrix PAP' where P is the fill-reducing
+ * ordering of given type.
+ * The ordering is stored in the symb->perm and symb->pinv and
+ * all other symbolic data is related to the reordered matrix.
+ * Numeric decomposition and solvers take the ordering
+ * into account automatically
+ * Returns nonzero if succesfull
+ */
+int sp_matrix_yale_chol_symbolic_ordered(sp_matrix_yale_ptr self,
+                                         sp_chol_symbolic_ptr symb,
+                                         sp_ordering_type ordering);
 /*
  * Deallocates Cholesky symbolic analysis structure values
  * This function doesn't deallocate memory for the struture itself,
@@ -108,10 +465,24 @@ int sp_matrix_yale_chol_symbolic(sp_matrix_yale_ptr self,
  */
 void sp_matrix_yale_symbolic_free(sp_chol_symbolic_ptr symb);
 
+/*
+ * Estimates memory, number of operations and time of the numeric
+ * Cholesky decomposition of the matrix self by the symbolic analysis
+ * symb without allocating anything.
+ * flops_rate - operations per second of the target machine;
+ * if not positive SP_CHOL_FLOPS_RATE is used
+ */
+void sp_matrix_yale_chol_estimate(sp_matrix_yale_ptr self,
+                                  sp_chol_symbolic_ptr symb,
+                                  double flops_rate,
+                                  sp_chol_estimate_ptr estimate);
+
 
 /*
  * Finds the numeric Cholesky decomposition of the given matrix.
  * Symbolic Cholesky decomposition shall already be found.
+ * If the symbolic analysis contains the ordering, L is
+ * the Cholesky factor of the reordered matrix PAP'
  * Returns nonzero if succesfull 
  */
 int sp_matrix_yale_chol_numeric(sp_matrix_yale_ptr self,
@@ -143,6 +514,8 @@ int sp_matrix_yale_chol_symbolic_solve(sp_matrix_yale_ptr self,
 /*
  * Solves the SLAE LL'*x=b with given matrix L from the 
  * preliminary calculated Cholesky numeric decomposition
+ * If the ordering was used in symbolic analysis, b and x shall be
+ * permuted with sp_perm_vector/sp_perm_inverse_vector
  * b and x sizes are the same as number of rows in self
  * Returns nonzero if successfull
  */
@@ -150,6 +523,323 @@ int sp_matrix_yale_chol_numeric_solve(sp_matrix_yale_ptr L,
                                       double* b,
                                       double* x);
 
+/*
+ * Creates the Cholesky decomposition object for the
+ * symmetric positive-definite matrix A (in CRS or CCS format)
+ * using given fill-reducing ordering and finds the decomposition
+ * Returns nonzero if successfull
+ */
+int sp_chol_factor_init(sp_chol_factor_ptr self,
+                        sp_matrix_yale_ptr A,
+                        sp_ordering_type ordering);
+
+/*
+ * Finds the numeric Cholesky decomposition of the matrix A
+ * overwriting the factor L inplace without memory allocations.
+ * If the portrait of L was extended by sp_chol_factor_updown, the
+ * portrait from the symbolic analysis is restored inside the arrays
+ * of the extended L and the kept level schedule is used again.
+ * Portrait of the matrix A shall be the same as the portrait
+ * of the matrix used in sp_chol_factor_init
+ * Returns nonzero if successfull, 0 if portraits are different or
+ * the matrix is not positive-definite
+ */
+int sp_chol_factor_refactor(sp_chol_factor_ptr self,
+                            sp_matrix_yale_ptr A);
+
+/*
+ * Solves the SLAE A*x=b using the Cholesky decomposition object.
+ * Doesn't allocate memory.
+ * b and x could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_chol_factor_solve(sp_chol_factor_ptr self,
+                         double* b,
+                         double* x);
+
+/*
+ * Solves the SLAEs A*X=B with nrhs right-hand sides using the
+ * Cholesky decomposition object. B and X are nrhs columns of
+ * rows_count elements stored one after another.
+ * Right-hand sides are processed in blocks of SP_CHOL_BLOCK_RHS,
+ * reading L once per block; both triangular solves use the level
+ * schedule of L as sp_chol_factor_solve does.
+ * Doesn't allocate memory.
+ * B and X could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_chol_factor_solve_block(sp_chol_factor_ptr self,
+                               int nrhs,
+                               double* B,
+                               double* X);
+
+/*
+ * Solves the SLAE A*x=b with sparse right-hand side b using the
+ * Cholesky decomposition object: b has nonzeros elements with
+ * indicies bi and values bx. The forward substitution is performed
+ * only by the reach of bi in the elimination tree.
+ * x - dense solution of rows_count elements
+ * Doesn't allocate memory.
+ * Returns nonzero if successfull
+ */
+int sp_chol_factor_solve_sparse(sp_chol_factor_ptr self,
+                                int nonzeros,
+                                int* bi,
+                                double* bx,
+                                double* x);
+
+/*
+ * Rank-k update (sigma = 1) or downdate (sigma = -1) of the
+ * Cholesky factor: replaces L with the Cholesky factor of
+ * LL' + sigma*WW'
+ * L - Cholesky factor in CCS format with sorted rows, as found by
+ * sp_matrix_yale_chol_numeric
+ * W - sparse matrix with rows_count rows in CCS format, rows in
+ * terms of the factorized (reordered) matrix
+ * If W introduces new nonzeros, the portrait of L is extended
+ * (and its arrays are reallocated)
+ * Complexity: O(number of nonzeros in columns of L on paths
+ * from the first rows of columns of W to the root of the
+ * elimination tree)
+ * Returns nonzero if successfull, 0 if the downdated matrix is not
+ * positive-definite
+ */
+int sp_matrix_yale_chol_updown(sp_matrix_yale_ptr L,
+                               int sigma,
+                               sp_matrix_yale_ptr W);
+
+/*
+ * Rank-k update (sigma = 1) or downdate (sigma = -1) of the
+ * Cholesky decomposition object: the decomposition of A+sigma*WW'
+ * W - sparse matrix with rows_count rows in CCS format,
+ * in terms of the original matrix A
+ * If the portrait of L was extended, L and its level schedule are
+ * reallocated here; the next refactorization restores the portrait
+ * from the symbolic analysis without allocations
+ * Returns nonzero if successfull
+ */
+int sp_chol_factor_updown(sp_chol_factor_ptr self,
+                          int sigma,
+                          sp_matrix_yale_ptr W);
+
+/*
+ * Deallocates the Cholesky decomposition object values
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_chol_factor_free(sp_chol_factor_ptr self);
+
+/*
+ * Creates the LDL' decomposition object for the symmetric, possibly
+ * indefinite, matrix A (in CRS or CCS format) using given
+ * fill-reducing ordering and finds the decomposition.
+ * The symbolic analysis is the same as for Cholesky decomposition
+ * Returns nonzero if successfull
+ */
+int sp_ldl_factor_init(sp_ldl_factor_ptr self,
+                       sp_matrix_yale_ptr A,
+                       sp_ordering_type ordering);
+
+/*
+ * Finds the numeric LDL' decomposition of the matrix A inplace
+ * without memory allocations. Portrait of the matrix A shall be
+ * the same as the portrait of the matrix used in sp_ldl_factor_init.
+ * Number of perturbed pivots is stored in self->perturbed
+ * Returns nonzero if successfull
+ */
+int sp_ldl_factor_refactor(sp_ldl_factor_ptr self,
+                           sp_matrix_yale_ptr A);
+
+/*
+ * Solves the SLAE A*x=b using the LDL' decomposition object
+ * with up to self->refinement_steps steps of iterative refinement.
+ * The refinement stops when the relative residual is less than 1e-14
+ * or doesn't decrease; the relative residual, the number of steps
+ * done and whether the tolerance was reached are stored in
+ * self->residual, self->refinement_iterations and self->converged.
+ * After perturbation of pivots of the nearly singular matrix the
+ * solution could be inaccurate even if the function succeeds, so
+ * self->converged or self->residual shall be checked.
+ * Doesn't allocate memory.
+ * b and x could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_ldl_factor_solve(sp_ldl_factor_ptr self,
+                        double* b,
+                        double* x);
+
+/*
+ * Deallocates the LDL' decomposition object values
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_ldl_factor_free(sp_ldl_factor_ptr self);
+
+/*
+ * Solves the SLAE self*x=b using the LDL' decomposition
+ * with nested dissection ordering.
+ * self shall be symmetric, possibly indefinite
+ * Returns nonzero if successfull
+ */
+int sp_matrix_yale_ldl_solve(sp_matrix_yale_ptr self,
+                             double* b,
+                             double* x);
+
+/*
+ * Creates the mixed precision Cholesky decomposition object for the
+ * symmetric positive definite matrix A with fill-reducing ordering
+ * of given type and finds the decomposition in single precision.
+ * tolerance - relative residual |b-Ax|/|b| to refine the solution to
+ * (see SP_CHOL_MIXED_TOLERANCE)
+ * Returns nonzero if successfull
+ */
+int sp_chol_mixed_init(sp_chol_mixed_ptr self,
+                       sp_matrix_yale_ptr A,
+                       sp_ordering_type ordering,
+                       double tolerance);
+
+/*
+ * Performs the numeric decomposition of the matrix A with the same
+ * portrait as the matrix used in sp_chol_mixed_init, in single precision
+ * unless the object already fell back to double precision.
+ * Returns nonzero if successfull
+ */
+int sp_chol_mixed_refactor(sp_chol_mixed_ptr self,
+                           sp_matrix_yale_ptr A);
+
+/*
+ * Solves the SLAE A*x=b using the mixed precision decomposition
+ * with iterative refinement to the tolerance. If the refinement
+ * stalls, the object falls back to the decomposition in double
+ * precision (which allocates memory for it once).
+ * b and x could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_chol_mixed_solve(sp_chol_mixed_ptr self,
+                        double* b,
+                        double* x);
+
+/*
+ * Deallocates the mixed precision Cholesky decomposition object values
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_chol_mixed_free(sp_chol_mixed_ptr self);
+
+/*
+ * Performs the symbolic analysis used in LU decomposition:
+ * column preordering of given type found by the portrait of A+A'
+ * and initial sizes of factors.
+ * The portraits of L and U depend on the row pivoting, so they are
+ * not analysed: lnz and unz are the heuristic 4*nonzeros+rows_count,
+ * not an upper bound. The numeric decomposition in sp_lu_factor_init
+ * reallocates L and U when they grow larger and shrinks them to the
+ * actual size at the end; only sp_lu_factor_refactor works without
+ * allocations.
+ * The matrix shall be square in CCS format
+ * Returns nonzero if succesfull
+ */
+int sp_matrix_yale_lu_symbolic(sp_matrix_yale_ptr self,
+                               sp_lu_symbolic_ptr symb,
+                               sp_ordering_type ordering);
+
+/*
+ * Deallocates LU symbolic analysis structure values
+ */
+void sp_matrix_yale_lu_symbolic_free(sp_lu_symbolic_ptr symb);
+
+/*
+ * Creates the LU decomposition object for the square matrix A in CCS
+ * format using given column preordering and finds the decomposition
+ * by the left-looking Gilbert-Peierls algorithm with threshold
+ * partial pivoting. tolerance - pivoting threshold:
+ * 1 - partial pivoting, less values prefer diagonal pivots
+ * (see SP_LU_PIVOT_TOLERANCE)
+ * Returns nonzero if successfull, 0 if the matrix is singular
+ */
+int sp_lu_factor_init(sp_lu_factor_ptr self,
+                      sp_matrix_yale_ptr A,
+                      sp_ordering_type ordering,
+                      double tolerance);
+
+/*
+ * Finds the numeric LU decomposition of the matrix A inplace
+ * with the pivot sequence of the sp_lu_factor_init, without memory
+ * allocations. Portrait of the matrix A shall be the same as the
+ * portrait of the matrix used in sp_lu_factor_init
+ * Returns nonzero if successfull, 0 if portraits are different or
+ * the zero pivot found; in this case sp_lu_factor_init shall
+ * be used to find new pivots
+ */
+int sp_lu_factor_refactor(sp_lu_factor_ptr self,
+                          sp_matrix_yale_ptr A);
+
+/*
+ * Solves the SLAE A*x=b using the LU decomposition object.
+ * Doesn't allocate memory.
+ * b and x could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_lu_factor_solve(sp_lu_factor_ptr self,
+                       double* b,
+                       double* x);
+
+/*
+ * Deallocates the LU decomposition object values
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_lu_factor_free(sp_lu_factor_ptr self);
+
+/*
+ * Solves the SLAE self*x=b using the LU decomposition
+ * with nested dissection column preordering.
+ * self shall be square in CCS format
+ * Returns nonzero if successfull
+ */
+int sp_matrix_yale_lu_solve(sp_matrix_yale_ptr self,
+                            double* b,
+                            double* x);
+
+/*
+ * Creates the out-of-core Cholesky decomposition object for the
+ * symmetric positive definite matrix A with fill-reducing ordering
+ * of given type.
+ * budget - memory in bytes for the decomposition: the reordered
+ * matrix, arrays of rows_count elements and two panels of values and
+ * row indicies of L; the half of the rest is the size of the panel.
+ * Temporaries of the fill-reducing ordering are not counted.
+ * Fails if the budget is less than arrays of rows_count elements or
+ * the column of L doesn't fit in the panel.
+ * filename - scratch file for values of L, removed by
+ * sp_chol_ooc_free; if 0 anonymous temporary file is used
+ * Returns nonzero if successfull, 0 if the matrix is not positive
+ * definite or in case of I/O error
+ */
+int sp_chol_ooc_init(sp_chol_ooc_ptr self,
+                     sp_matrix_yale_ptr A,
+                     sp_ordering_type ordering,
+                     size_t budget,
+                     const char* filename);
+
+/*
+ * Solves the SLAE A*x=b using the out-of-core Cholesky decomposition
+ * streaming panels of L from the scratch file.
+ * Doesn't allocate memory.
+ * b and x could point to the same array
+ * Returns nonzero if successfull
+ */
+int sp_chol_ooc_solve(sp_chol_ooc_ptr self,
+                      double* b,
+                      double* x);
+
+/*
+ * Deallocates the out-of-core Cholesky decomposition object values
+ * and removes the scratch file.
+ * This function doesn't deallocate memory for the struture itself,
+ * only for its structures
+ */
+void sp_chol_ooc_free(sp_chol_ooc_ptr self);
 
 
 #endif /* _SP_DIRECT_H_ */
@@ -22,6 +22,7 @@
 #define _SP_ITER_H_
 
 #include "sp_matrix.h"
+#include "sp_direct.h"
 
 /*
  * ILU decomposition of the sparse matrix in Skyline (CSLR) format
@@ -33,9 +34,173 @@ typedef struct
   double *ilu_diag;              /* U matrix diagonal */
   double *ilu_lowertr;           /* nonzero elements of the lower(L) matrix */
   double *ilu_uppertr;           /* nonzero elements of the upper(U) matrix */
+  sp_level_schedule schedule;    /* level schedule of the portrait */
 } sp_matrix_skyline_ilu;
 typedef sp_matrix_skyline_ilu* sp_matrix_skyline_ilu_ptr;
 
+/*
+ * ILU(0) or ILUT decomposition of the sparse matrix in Yale CRS
+ * format: factors L (unit diagonal not stored) and U are kept together
+ * in rows of the matrix, ordered by columns
+ */
+typedef struct
+{
+  sp_matrix_yale LU;             /* L below and U on and above diagonal */
+  int* diag;                     /* positions of diagonal elements */
+  sp_level_schedule lower;       /* level schedule of L */
+  sp_level_schedule upper;       /* level schedule of U */
+} sp_matrix_yale_ilu;
+typedef sp_matrix_yale_ilu* sp_matrix_yale_ilu_ptr;
+
+/*
+ * Incomplete Cholesky decomposition A ~ L*L' of the symmetric
+ * positive definite matrix: only the factor L is stored
+ */
+typedef struct
+{
+  sp_matrix_yale L;              /* CCS, diagonal first in columns */
+  sp_level_schedule schedule;    /* level schedule of L */
+  double* y;                     /* workspace of rows_count elements */
+} sp_matrix_yale_ic;
+typedef sp_matrix_yale_ic* sp_matrix_yale_ic_ptr;
+
+/* Maximal number of levels of the algebraic multigrid */
+#define SP_AMG_MAX_LEVELS 20
+
+/*
+ * Size of the operator of the algebraic multigrid solved
+ * by the Cholesky decomposition as the coarsest level
+ */
+#define SP_AMG_COARSE_SIZE 200
+
+/* Smoothers of the algebraic multigrid */
+typedef enum
+{
+  AMG_SMOOTHER_JACOBI = 0,       /* damped Jacobi */
+  AMG_SMOOTHER_CHEBYSHEV         /* Chebyshev polynomial of D^{-1}A */
+} sp_amg_smoother_type;
+
+/* Level of the algebraic multigrid */
+typedef struct
+{
+  sp_matrix_yale A;              /* operator of the level, CRS */
+  sp_matrix_yale P;              /* prolongation from the next level */
+  sp_matrix_yale R;              /* restriction to the next level, P' */
+  double* dinv;                  /* inverted diagonal of A */
+  double lambda;                 /* estimate of max eigenvalue of D^{-1}A */
+  double* b;                     /* right-hand side (coarse levels) */
+  double* x;                     /* solution (coarse levels) */
+  double* r;                     /* workspaces of rows_count elements */
+  double* d;
+  double* w;
+} sp_amg_level;
+
+/*
+ * Smoothed aggregation algebraic multigrid for the symmetric
+ * positive definite matrix: hierarchy of levels with the
+ * Cholesky decomposition of the coarsest one
+ */
+typedef struct
+{
+  int levels_count;
+  sp_amg_level levels[SP_AMG_MAX_LEVELS];
+  sp_chol_factor coarse;         /* decomposition of the coarsest level */
+  sp_amg_smoother_type smoother;
+  int sweeps;                    /* Jacobi sweeps or Chebyshev degree */
+} sp_amg;
+typedef sp_amg* sp_amg_ptr;
+
+/* Orthogonalization of the Krylov basis in GMRES */
+typedef enum
+{
+  GMRES_MGS = 0,                 /* modified Gram-Schmidt */
+  GMRES_CGS2                     /* classical Gram-Schmidt applied twice */
+} sp_gmres_orthogonalization;
+
+/*
+ * Preconditioner callback for iterative solvers:
+ * calculates z = M^{-1}*r, shall not modify r
+ * data - preconditioner object
+ */
+typedef void (*sp_precond_func)(void* data, double* r, double* z);
+
+/*
+ * Preconditioner object accepted by the iterative solvers:
+ * state - opaque preconditioner data,
+ * setup - creates the preconditioner in state for the matrix A,
+ * returns nonzero if successfull; could be called again for the
+ * other matrix,
+ * apply - calculates z = M^{-1}*r,
+ * release - frees the state.
+ * setup and release could be 0 if not needed
+ */
+typedef struct
+{
+  int (*setup)(void* state, sp_matrix_yale_ptr A);
+  sp_precond_func apply;
+  void (*release)(void* state);
+  void* state;
+} sp_preconditioner;
+typedef sp_preconditioner* sp_preconditioner_ptr;
+
+/*
+ * Default period of the explicit residual recalculation
+ * in the pipelined Conjugate Gradient
+ */
+#define SP_PIPECG_REPLACEMENT 50
+
+/* Iterative methods of the solver context */
+typedef enum
+{
+  ITER_CG = 0,                   /* (preconditioned) conjugate gradient */
+  ITER_CGS,                      /* conjugate gradient squared */
+  ITER_TFQMR,                    /* transpose-free quasi-minimal residual */
+  ITER_BICGSTAB,                 /* biconjugate gradient stabilized */
+  ITER_GMRES,                    /* restarted GMRES(m) */
+  ITER_PIPECG                    /* pipelined conjugate gradient */
+} sp_iter_method;
+
+/* Options of the iterative solver context */
+typedef struct
+{
+  int max_iter;                  /* maximum number of iterations */
+  double tolerance;              /* desired norm of the residual */
+  int restart;                   /* dimension of the Krylov subspace of GMRES */
+  sp_gmres_orthogonalization orthogonalization; /* basis of GMRES */
+  int replacement;               /* period of the residual replacement in
+                                  * pipelined CG, 0 - no replacement */
+} sp_iter_options;
+
+/* Statistics of the iterative solver context */
+typedef struct
+{
+  int iterations;                /* iterations of the last solve */
+  double residual;               /* residual norm of the last solve */
+  int converged;                 /* nonzero if the last solve converged */
+  int solves;                    /* number of solves */
+  long total_iterations;         /* iterations of all solves */
+} sp_iter_stats;
+
+/*
+ * Iterative solver context: keeps options, statistics and the
+ * workspace vectors aligned to the cache line. The workspace is
+ * allocated once and reused, so repeated solves of systems not
+ * larger than the first one don't allocate memory
+ */
+typedef struct
+{
+  sp_iter_method method;
+  sp_iter_options options;       /* could be changed between solves */
+  sp_iter_stats stats;
+  int size;                      /* maximal size of the system */
+  int ld;                        /* distance between workspace vectors */
+  int vectors_count;             /* number of workspace vectors */
+  double* workspace;             /* vectors_count vectors of ld elements */
+  int small_count;               /* number of elements in small */
+  double* small;                 /* Hessenberg matrix and rotations of GMRES */
+} sp_iter_solver;
+typedef sp_iter_solver* sp_iter_solver_ptr;
+
 
 /*
  * Conjugate Gradient solver
@@ -55,6 +220,82 @@ void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
                              double* tolerance,
                              double* x);
 
+/*
+ * Preconditioned Conjugate Gradient solver
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * b - right-part vector
+ * x0 - first approximation of the solution
+ * max_iter - pointer to maximum number of iterations, shall not be zero;
+ * will contain a number of iterations passed
+ * tolerance - pointer to desired tolerance value;
+ * will contain norm of the residual at the end of iteration
+ * x - output vector
+ */
+void sp_matrix_yale_solve_pcg(sp_matrix_yale_ptr self,
+                              sp_preconditioner_ptr precond,
+                              double* b,
+                              double* x0,
+                              int* max_iter,
+                              double* tolerance,
+                              double* x);
+
+/*
+ * Pipelined (Ghysels-Vanroose) Preconditioned Conjugate Gradient
+ * solver. Recurrences for A*p, M^{-1}*A*p and A*M^{-1}*A*p allow to
+ * calculate all scalar products of the iteration in one sweep
+ * together with vector updates, so the iteration has one global
+ * reduction instead of two and the reduction doesn't wait for the
+ * matrix-vector product. The residual is recalculated explicitly
+ * every SP_PIPECG_REPLACEMENT iterations to keep the accuracy
+ * (see sp_iter_options for the solver context) until it is
+ * reduced by sqrt(DBL_EPSILON) times.
+ * Needs 9 vectors instead of 4 of PCG
+ * Parameters are the same as in sp_matrix_yale_solve_pcg
+ */
+void sp_matrix_yale_solve_pipecg(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x);
+
+/*
+ * Block Preconditioned Conjugate Gradient solver for nrhs
+ * right-hand sides A*X = B solved together: all columns share the
+ * block Krylov subspace and matrix-vector products are calculated
+ * for all search directions at once. Linearly dependent search
+ * directions are dropped, converged columns are not updated
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * nrhs - number of right-hand sides
+ * B - right-hand sides, nrhs columns of rows_count elements stored
+ * one after another
+ * X0 - first approximations of solutions stored as B
+ * max_iter - pointer to maximum number of iterations, shall not be
+ * zero; will contain a number of iterations passed
+ * tolerance - desired tolerance for every column
+ * iterations - array of nrhs elements, will contain numbers of
+ * iterations after which columns converged
+ * residuals - array of nrhs elements, will contain norms of
+ * residuals of columns
+ * X - output solutions stored as B
+ * Returns nonzero if all columns converged
+ */
+int sp_matrix_yale_solve_block_cg(sp_matrix_yale_ptr self,
+                                  sp_preconditioner_ptr precond,
+                                  int nrhs,
+                                  double* B,
+                                  double* X0,
+                                  int* max_iter,
+                                  double tolerance,
+                                  int* iterations,
+                                  double* residuals,
+                                  double* X);
+
 /*
  * Preconditioned Conjugate Grade solver
  * Preconditioner in form of the ILU decomposition
@@ -75,6 +316,45 @@ void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
                                   double* tolerance,
                                   double* x);
 
+/*
+ * Preconditioned Conjugate Gradient solver
+ * Preconditioner in form of the ILU(0) decomposition in Yale format
+ * Parameters are the same as in sp_matrix_yale_solve_pcg_ilu
+ */
+void sp_matrix_yale_solve_pcg_ilu0(sp_matrix_yale_ptr self,
+                                   sp_matrix_yale_ilu_ptr ilu,
+                                   double* b,
+                                   double* x0,
+                                   int* max_iter,
+                                   double* tolerance,
+                                   double* x);
+
+/*
+ * Preconditioned Conjugate Gradient solver
+ * Preconditioner in form of the incomplete Cholesky decomposition
+ * Parameters are the same as in sp_matrix_yale_solve_pcg_ilu
+ */
+void sp_matrix_yale_solve_pcg_ic(sp_matrix_yale_ptr self,
+                                 sp_matrix_yale_ic_ptr ic,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x);
+
+/*
+ * Preconditioned Conjugate Gradient solver
+ * Preconditioner in form of the V-cycle of the algebraic multigrid
+ * Parameters are the same as in sp_matrix_yale_solve_pcg_ilu
+ */
+void sp_matrix_yale_solve_pcg_amg(sp_matrix_yale_ptr self,
+                                  sp_amg_ptr amg,
+                                  double* b,
+                                  double* x0,
+                                  int* max_iter,
+                                  double* tolerance,
+                                  double* x);
+
 /*
  * Creates ILU decomposition of the sparse matrix 
  */
@@ -93,6 +373,177 @@ void sp_matrix_skyline_ilu_copy_init(sp_matrix_skyline_ilu_ptr self,
 /* Free the sparse matrix skyline & ilu decomposition structure */
 void sp_matrix_skyline_ilu_free(sp_matrix_skyline_ilu_ptr self);
 
+/*
+ * Creates ILU(0) decomposition of the matrix A in Yale format
+ * (CCS matrix is converted to CRS).
+ * Every row shall contain the diagonal element.
+ * Complexity: O(sum of squares of row nonzeros)
+ * Returns nonzero if successfull, 0 if zero pivot found
+ */
+int sp_matrix_yale_ilu_init(sp_matrix_yale_ilu_ptr self,
+                            sp_matrix_yale_ptr A);
+
+/*
+ * Creates ILUT(p,tau) decomposition of the matrix A in Yale format
+ * (CCS matrix is converted to CRS) with the dual dropping:
+ * elements of the row i of L and U less than tau*norm2(A(i,:)) are
+ * dropped, then only fill largest elements are kept in the row of L
+ * and in the row of U. Zero pivots are replaced by
+ * (1e-4+tau)*norm2(A(i,:)).
+ * The result could be used as ILU(0) decomposition.
+ * Returns nonzero if successfull, 0 if A has zero row
+ */
+int sp_matrix_yale_ilut_init(sp_matrix_yale_ilu_ptr self,
+                             sp_matrix_yale_ptr A,
+                             double tau,
+                             int fill);
+
+/*
+ * by given L,U - ILU(0) or ILUT decomposition of the matrix A
+ * Solves SLAE L*U*x = b using level schedules of L and U
+ * b and x could point to the same array
+ */
+void sp_matrix_yale_ilu_solve(sp_matrix_yale_ilu_ptr self,
+                              double* b,
+                              double* x);
+
+/*
+ * Preconditioner function (sp_precond_func) for the ILU(0) or ILUT
+ * decomposition data: z = (L*U)^{-1}*r
+ */
+void sp_matrix_yale_ilu_precond(void* data, double* r, double* z);
+
+/* Free the ILU(0) decomposition structure */
+void sp_matrix_yale_ilu_free(sp_matrix_yale_ilu_ptr self);
+
+/*
+ * Creates IC(0) decomposition of the symmetric positive definite
+ * matrix A in Yale format: L has the portrait of the lower
+ * triangle of A
+ * Returns nonzero if successfull, 0 if nonpositive pivot found
+ */
+int sp_matrix_yale_ic0_init(sp_matrix_yale_ic_ptr self,
+                            sp_matrix_yale_ptr A);
+
+/*
+ * Creates dual-threshold incomplete Cholesky decomposition IC(tau)
+ * of the symmetric positive definite matrix A in Yale format:
+ * fill-in is allowed, then elements of the column of L less than
+ * tau*norm2(A(j:n,j)) are dropped, and only the largest
+ * fill + (number of nonzeros of the A(j+1:n,j)) elements are kept.
+ * Returns nonzero if successfull, 0 if nonpositive pivot found
+ */
+int sp_matrix_yale_ict_init(sp_matrix_yale_ic_ptr self,
+                            sp_matrix_yale_ptr A,
+                            double tau,
+                            int fill);
+
+/*
+ * by given L - incomplete Cholesky decomposition of the matrix A
+ * Solves SLAE L*L'*x = b using the level schedule of L
+ * b and x could point to the same array
+ */
+void sp_matrix_yale_ic_solve(sp_matrix_yale_ic_ptr self,
+                             double* b,
+                             double* x);
+
+/*
+ * Preconditioner function (sp_precond_func) for the incomplete
+ * Cholesky decomposition data: z = (L*L')^{-1}*r
+ */
+void sp_matrix_yale_ic_precond(void* data, double* r, double* z);
+
+/* Free the incomplete Cholesky decomposition structure */
+void sp_matrix_yale_ic_free(sp_matrix_yale_ic_ptr self);
+
+/*
+ * Creates the smoothed aggregation algebraic multigrid hierarchy
+ * for the symmetric positive definite matrix A in Yale format.
+ * Nodes i and j are strongly connected if
+ * a_ij^2 >= theta^2*a_ii*a_jj (typical theta is 0.08); aggregates
+ * of strongly connected nodes are the nodes of the next level.
+ * Prolongation is the tentative one smoothed by the Jacobi step,
+ * coarse operators are R*A*P. Levels are created until the size
+ * is not greater than SP_AMG_COARSE_SIZE.
+ * smoother - smoother of the V-cycle, sweeps - number of Jacobi
+ * sweeps or degree of Chebyshev polynomial
+ * The hierarchy could be used for any number of right-hand sides.
+ * Returns nonzero if successfull, 0 if nonpositive diagonal element
+ * found or the coarsest level is not positive definite
+ */
+int sp_amg_init(sp_amg_ptr self,
+                sp_matrix_yale_ptr A,
+                double theta,
+                sp_amg_smoother_type smoother,
+                int sweeps);
+
+/*
+ * Applies one V-cycle of the algebraic multigrid with the zero
+ * initial approximation: x ~ A^{-1}*b
+ * Doesn't allocate memory. b and x shall be different arrays
+ */
+void sp_amg_solve(sp_amg_ptr self, double* b, double* x);
+
+/*
+ * Preconditioner function (sp_precond_func) for the algebraic
+ * multigrid data: z = V-cycle(r)
+ */
+void sp_amg_precond(void* data, double* r, double* z);
+
+/* Free the algebraic multigrid structure */
+void sp_amg_free(sp_amg_ptr self);
+
+/*
+ * Preconditioner objects: constructors set the functions and
+ * parameters of the preconditioner, sp_preconditioner_setup creates
+ * it for the given matrix. The same object could be used by any
+ * solver and set up again for the matrix with other values
+ */
+
+/* Jacobi preconditioner M = diag(A) */
+void sp_preconditioner_jacobi_init(sp_preconditioner_ptr self);
+
+/* ILU(0) preconditioner, see sp_matrix_yale_ilu_init */
+void sp_preconditioner_ilu0_init(sp_preconditioner_ptr self);
+
+/* ILUT(p,tau) preconditioner, see sp_matrix_yale_ilut_init */
+void sp_preconditioner_ilut_init(sp_preconditioner_ptr self,
+                                 double tau,
+                                 int fill);
+
+/* IC(0) preconditioner, see sp_matrix_yale_ic0_init */
+void sp_preconditioner_ic0_init(sp_preconditioner_ptr self);
+
+/* IC(tau) preconditioner, see sp_matrix_yale_ict_init */
+void sp_preconditioner_ict_init(sp_preconditioner_ptr self,
+                                double tau,
+                                int fill);
+
+/* Algebraic multigrid preconditioner, see sp_amg_init */
+void sp_preconditioner_amg_init(sp_preconditioner_ptr self,
+                                double theta,
+                                sp_amg_smoother_type smoother,
+                                int sweeps);
+
+/*
+ * User preconditioner given by the function apply and its data
+ * which is owned by the user: setup does nothing, release doesn't
+ * free data. Doesn't allocate memory
+ */
+void sp_preconditioner_user_init(sp_preconditioner_ptr self,
+                                 sp_precond_func apply,
+                                 void* data);
+
+/*
+ * Creates the preconditioner for the matrix A
+ * Returns nonzero if successfull
+ */
+int sp_preconditioner_setup(sp_preconditioner_ptr self,
+                            sp_matrix_yale_ptr A);
+
+/* Free the preconditioner object */
+void sp_preconditioner_free(sp_preconditioner_ptr self);
+
 /*
  * by given L,U - ILU decomposition of the matrix A
  * calculates L*x = y
@@ -111,7 +562,7 @@ void sp_matrix_skyline_ilu_upper_mv(sp_matrix_skyline_ilu_ptr self,
 /*
  * by given L,U - ILU decomposition of the matrix A
  * Solves SLAE L*x = b
- * Warning! Side-Effect: modifies b
+ * using the level schedule of the decomposition
  */
 void sp_matrix_skyline_ilu_lower_solve(sp_matrix_skyline_ilu_ptr self,
                                        double* b,
@@ -120,11 +571,27 @@ void sp_matrix_skyline_ilu_lower_solve(sp_matrix_skyline_ilu_ptr self,
 /*
  * by given L,U - ILU decomposition of the matrix A
  * Solves SLAE U*x = b
- * Warning! Side-Effect: modifies b 
+ * using the level schedule of the decomposition
  */
 void sp_matrix_skyline_ilu_upper_solve(sp_matrix_skyline_ilu_ptr self,
                                        double* b,
                                        double* x);
+/*
+ * Transpose-Free Quasi-Minimal Residual solver with the right
+ * preconditioner
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * other parameters are the same as in sp_matrix_yale_solve_tfqmr
+ */
+void sp_matrix_yale_solve_ptfqmr(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x);
+
 /*
  * Transpose-Free Quasi-Minimal Residual solver
  * self - matrix in Yale format
@@ -165,5 +632,139 @@ void sp_matrix_yale_solve_cgs(sp_matrix_yale_ptr self,
                               double* tolerance,
                               double* x);
 
+/*
+ * Conjugate Gradient Squared solver with the right preconditioner
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * other parameters are the same as in sp_matrix_yale_solve_cgs
+ */
+void sp_matrix_yale_solve_pcgs(sp_matrix_yale_ptr self,
+                               sp_preconditioner_ptr precond,
+                               double* b,
+                               double* x0,
+                               int* max_iter,
+                               double* tolerance,
+                               double* x);
+
+/*
+ * Biconjugate Gradient Stabilized solver with the right
+ * preconditioner
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * other parameters are the same as in sp_matrix_yale_solve_bicgstab
+ */
+void sp_matrix_yale_solve_pbicgstab(sp_matrix_yale_ptr self,
+                                    sp_preconditioner_ptr precond,
+                                    double* b,
+                                    double* x0,
+                                    int* max_iter,
+                                    double* tolerance,
+                                    double* x);
+
+/*
+ * Biconjugate Gradient Stabilized solver
+ * self - matrix in Yale format
+ * b - right-part vector
+ * x0 - first approximation of the solution
+ * max_iter - pointer to maximum number of iterations, shall not be zero;
+ * will contain a number of iterations passed
+ * tolerance - pointer to desired tolerance value;
+ * will contain norm of the residual at the end of iteration
+ * x - output vector
+ */
+void sp_matrix_yale_solve_bicgstab(sp_matrix_yale_ptr self,
+                                   double* b,
+                                   double* x0,
+                                   int* max_iter,
+                                   double* tolerance,
+                                   double* x);
+
+/*
+ * Restarted Generalized Minimal Residual solver GMRES(m) with the
+ * right preconditioner
+ * self - matrix in Yale format
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * restart - dimension m of the Krylov subspace
+ * type - orthogonalization of the Krylov basis
+ * max_iter - pointer to maximum number of iterations (matrix-vector
+ * products) by all restarts, shall not be zero;
+ * will contain a number of iterations passed
+ * other parameters are the same as in sp_matrix_yale_solve_gmres
+ * The Krylov basis is stored in one block aligned to the cache line
+ */
+void sp_matrix_yale_solve_pgmres(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 int restart,
+                                 sp_gmres_orthogonalization type,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x);
+
+/*
+ * Restarted Generalized Minimal Residual solver GMRES(m)
+ * with modified Gram-Schmidt orthogonalization
+ * self - matrix in Yale format
+ * restart - dimension m of the Krylov subspace
+ * b - right-part vector
+ * x0 - first approximation of the solution
+ * max_iter - pointer to maximum number of iterations, shall not be zero;
+ * will contain a number of iterations passed
+ * tolerance - pointer to desired tolerance value;
+ * will contain norm of the residual at the end of iteration
+ * x - output vector
+ */
+void sp_matrix_yale_solve_gmres(sp_matrix_yale_ptr self,
+                                int restart,
+                                double* b,
+                                double* x0,
+                                int* max_iter,
+                                double* tolerance,
+                                double* x);
+
+/*
+ * Sets default options of the iterative solver context:
+ * 10000 iterations, tolerance 1e-10, GMRES(30) with
+ * modified Gram-Schmidt orthogonalization, residual replacement
+ * in pipelined CG every 50 iterations
+ */
+void sp_iter_options_default(sp_iter_options* options);
+
+/*
+ * Creates the iterative solver context
+ * method - iterative method
+ * size - size of systems to solve
+ * options - options of the solver or 0 for the default ones
+ * Returns nonzero if successfull
+ */
+int sp_iter_solver_init(sp_iter_solver_ptr self,
+                        sp_iter_method method,
+                        int size,
+                        sp_iter_options* options);
+
+/*
+ * Solves the system A*x = b by the solver context
+ * precond - preconditioner object or 0 for the method without
+ * preconditioner
+ * x0 - first approximation of the solution
+ * x - output vector
+ * Number of iterations and the residual norm are stored in the
+ * statistics of the context. The workspace is enlarged only if
+ * A is larger than previous systems or options require more vectors
+ * Returns nonzero if the method converged
+ */
+int sp_iter_solver_solve(sp_iter_solver_ptr self,
+                         sp_matrix_yale_ptr A,
+                         sp_preconditioner_ptr precond,
+                         double* b,
+                         double* x0,
+                         double* x);
+
+/* Free the iterative solver context */
+void sp_iter_solver_free(sp_iter_solver_ptr self);
 
 #endif /* _SP_ITER_H_ */
@@ -258,6 +258,18 @@ void sp_matrix_yale_mvsum(sp_matrix_yale_ptr self,
                           double* x2,
                           double* y);
 
+/*
+ * Matrix-vector multiplication for k vectors at once
+ * Y = A*X, where X and Y are stored by rows: element c of the row i
+ * is X[i*k+c]. Every element of the matrix is read once for all
+ * k vectors
+ * Used in sp_matrix_yale_solve_block_cg
+ */
+void sp_matrix_yale_mv_block(sp_matrix_yale_ptr self,
+                             int k,
+                             double* X,
+                             double* Y);
+
 
 /*
  * Transposes the matrix in Yale format
@@ -283,8 +295,10 @@ int sp_matrix_yale_convert_inplace(sp_matrix_yale_ptr self,
 /*
  * Calculates the permuted matrix C = P*A*Q
  * by given vector of inverse row permutation pinv:
- * row i becomes row k if pinv[k] = i
- * and vector of column permutation q
+ * row i becomes row pinv[i]
+ * and vector of inverse column permutation q:
+ * column j becomes column q[j]
+ * Complexity: O(nonzeros)
  * returns 0 in case of error, nonzero otherwise
  */
 int sp_matrix_yale_permute(sp_matrix_yale_ptr self,
@@ -292,9 +306,34 @@ int sp_matrix_yale_permute(sp_matrix_yale_ptr self,
                            int* pinv,
                            int* q);
 
+/*
+ * Calculates the sparse matrix-matrix product C = A*B
+ * A and B shall be in the same format (CRS or CCS), C is created
+ * in this format and shall be uninitialized.
+ * Indicies in rows/columns of C are sorted.
+ * Complexity: O(number of multiplications + nonzeros(C)*log)
+ * returns 0 in case of incompatible matricies, nonzero otherwise
+ */
+int sp_matrix_yale_mm(sp_matrix_yale_ptr A,
+                      sp_matrix_yale_ptr B,
+                      sp_matrix_yale_ptr C);
+
 /* determines the matrix properties */
 matrix_properties sp_matrix_yale_properites(sp_matrix_yale_ptr self);
 
+/*
+ * Calculates the bandwidth of the matrix:
+ * maximum |i-j| for nonzero elements a_ij
+ */
+int sp_matrix_yale_bandwidth(sp_matrix_yale_ptr self);
+
+/*
+ * Calculates the profile (envelope size) of the lower triangle:
+ * sum of i - f_i by all rows i, where f_i is the column of the
+ * first nonzero element in the row i
+ */
+long sp_matrix_yale_profile(sp_matrix_yale_ptr self);
+
 /* compare 2 matricies in the same format */
 matrix_comparison sp_matrix_yale_cmp(sp_matrix_yale_ptr mtx1,
                                      sp_matrix_yale_ptr mtx2);
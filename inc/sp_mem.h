@@ -20,11 +20,29 @@
 
 size_t spallocated();
 
+/*
+ * High-water mark of spallocated() since the start of the program
+ * or the last call of spallocated_reset_peak(), which sets it to
+ * the current value of spallocated()
+ */
+size_t spallocated_peak();
+void spallocated_reset_peak();
+
 void* spalloc(size_t size);
 void* spcalloc(size_t nmemb, size_t size);
 void* sprealloc(void* ptr, size_t size);
 void spfree(void* ptr);
 
+/* Alignment of blocks allocated by spalloc_aligned: cache line size */
+#define SP_MEM_ALIGNMENT 64
+
+/*
+ * Allocates the memory block of size bytes aligned by
+ * SP_MEM_ALIGNMENT bytes. The block shall be freed by spfree_aligned
+ */
+void* spalloc_aligned(size_t size);
+void spfree_aligned(void* ptr);
+
 /*
  * Allocates the memory block of size bytes and copy the
  * appropriate memory block pointed by src
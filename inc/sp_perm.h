@@ -21,6 +21,16 @@
 #ifndef _SP_PERM_H_
 #define _SP_PERM_H_
 
+#include "sp_matrix.h"
+
+/* Ordering methods for the sparse matrix */
+typedef enum
+{
+  ORDER_NATURAL = 0,            /* no reordering */
+  ORDER_NESTED_DISSECTION,      /* nested dissection */
+  ORDER_REVERSE_CUTHILL_MCKEE   /* reverse Cuthill-McKee */
+} sp_ordering_type;
+
 /*
  * This function finds the inverse permutation by given
  * permutation perm of size n and writes it to the array pointed 
@@ -28,5 +38,54 @@
  */
 void sp_perm_inverse(int* perm, int n, int* pinv);
 
+/*
+ * Applies the permutation perm of size n to the vector x:
+ * y[k] = x[perm[k]]
+ */
+void sp_perm_vector(int* perm, int n, double* x, double* y);
+
+/*
+ * Applies the inverse of the permutation perm of size n
+ * to the vector x: y[perm[k]] = x[k]
+ */
+void sp_perm_inverse_vector(int* perm, int n, double* x, double* y);
+
+/*
+ * Finds the nested dissection ordering of the matrix self.
+ * Only the portrait of the A+A^T is used, so the matrix
+ * could be in CRS or CCS format.
+ * The graph of the matrix is bisected recursively by the multilevel
+ * algorithm (heavy edge matching, graph growing partition and
+ * boundary refinement); small subgraphs are ordered by the
+ * minimum degree algorithm.
+ * perm - output array of rows_count elements: perm[k] = i means
+ * row/column i of the matrix becomes row/column k
+ * returns nonzero if successfull
+ */
+int sp_matrix_yale_nested_dissection(sp_matrix_yale_ptr self, int* perm);
+
+/*
+ * Finds the reverse Cuthill-McKee ordering of the matrix self
+ * reducing its bandwidth and profile.
+ * Only the portrait of the A+A^T is used, so the matrix
+ * could be in CRS or CCS format.
+ * Every connected component is started from the pseudo-peripheral
+ * vertex found by the George-Liu algorithm.
+ * perm - output array of rows_count elements: perm[k] = i means
+ * row/column i of the matrix becomes row/column k
+ * returns nonzero if successfull
+ */
+int sp_matrix_yale_rcm(sp_matrix_yale_ptr self, int* perm);
+
+/*
+ * Finds the ordering of the matrix self of given type
+ * perm - output array of rows_count elements: perm[k] = i means
+ * row/column i of the matrix becomes row/column k
+ * returns nonzero if successfull
+ */
+int sp_matrix_yale_ordering(sp_matrix_yale_ptr self,
+                            sp_ordering_type type,
+                            int* perm);
+
 
 #endif /* _SP_PERM_H_ */
@@ -79,6 +79,7 @@ void tree_postorder_perm(int* tree, int size, int* postorder);
  *      2
  *
  * Levels arrays shall look like: [1;2;1;0]
+ * Complexity: O(size)
  */
 void tree_node_levels(int* tree, int size, int* level);
 
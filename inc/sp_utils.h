@@ -33,6 +33,16 @@
 #define DBL_EPSILON 2.2204460492503131e-16
 #endif
 #define FMAX(x,y) ((x) > (y) ? (x) : (y))
+
+/*
+ * OpenMP pragma: expands to _Pragma(x) if compiled with OpenMP
+ * support (see OPENMP variable in Makefile), to nothing otherwise
+ */
+#ifdef _OPENMP
+#define SP_OMP(x) _Pragma(#x)
+#else
+#define SP_OMP(x)
+#endif
 #define EQL(x,y) ((fabs((x)-(y))<= DBL_EPSILON*2) ? 1:0)
 
 enum
@@ -25,6 +25,9 @@
 
 #include <time.h>
 #include <sys/time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 #include "sp_matrix.h"
@@ -102,6 +105,719 @@ static void print_error(const double* x, const double* x0, int size)
   printf("%e\n",err);
 }
 
+/*
+ * Cholesky decomposition of the matrix reordered by the given
+ * fill-reducing ordering; prints timings, fill-in and error
+ */
+static void cholesky_ordered(sp_matrix_yale_ptr mtx,
+                             sp_ordering_type ordering,
+                             const char* name,
+                             const double* x0,
+                             double* b)
+{
+  sp_chol_symbolic symb;
+  sp_chol_estimate estimate;
+  sp_matrix_yale L;
+  struct timespec t1,t2;
+  int n = mtx->rows_count;
+  double *pb, *px, *x;
+  portable_gettime(&t1);
+  if (!sp_matrix_yale_chol_symbolic_ordered(mtx,&symb,ordering))
+  {
+    printf("Unable to create symbolic Cholesky decomposition with %s\n",
+           name);
+    return;
+  }
+  portable_gettime(&t2);
+  printf("Cholesky symbolic decomposition with %s time: ",name);
+  print_time_difference(&t1,&t2);
+  /* resources estimated before the numeric decomposition */
+  sp_matrix_yale_chol_estimate(mtx,&symb,0,&estimate);
+  printf("Cholesky decomposition with %s estimates: ",name);
+  printf("factor %lu bytes, resident %lu bytes, mixed precision %lu bytes\n",
+         (unsigned long)estimate.factor_bytes,
+         (unsigned long)estimate.resident_bytes,
+         (unsigned long)estimate.mixed_bytes);
+  printf("Cholesky decomposition with %s estimates: ",name);
+  printf("%.0f flops, numeric %f s, LDL' %f s, mixed precision %f s,"
+         " solve %f s\n",estimate.flops,estimate.time_numeric,
+         estimate.time_ldl,estimate.time_mixed,estimate.time_solve);
+  if (!sp_matrix_yale_chol_numeric(mtx,&symb,&L))
+  {
+    printf("Unable to create numeric Cholesky decomposition with %s\n",
+           name);
+    sp_matrix_yale_symbolic_free(&symb);
+    return;
+  }
+  portable_gettime(&t1);
+  printf("Cholesky numeric decomposition with %s time: ",name);
+  print_time_difference(&t2,&t1);
+  printf("Nonzeros size increase with %s:",name);
+  printf("from %d to %d is %.2f %% size increase\n",
+         mtx->nonzeros,L.nonzeros,L.nonzeros/(mtx->nonzeros/100.)-100.0);
+  pb = calloc(n,sizeof(double));
+  px = calloc(n,sizeof(double));
+  x = calloc(n,sizeof(double));
+  portable_gettime(&t1);
+  sp_perm_vector(symb.perm,n,b,pb);
+  sp_matrix_yale_chol_numeric_solve(&L,pb,px);
+  sp_perm_inverse_vector(symb.perm,n,px,x);
+  portable_gettime(&t2);
+  printf("Solving SLAE using Cholesky decomposition with %s time: ",name);
+  print_time_difference(&t1,&t2);
+  printf("SLAE using Cholesky decomposition with %s max error: ",name);
+  print_error(x0,x,n);
+  free(pb);
+  free(px);
+  free(x);
+  sp_matrix_yale_free(&L);
+  sp_matrix_yale_symbolic_free(&symb);
+}
+
+/*
+ * Cholesky decomposition object: initial factorization and
+ * refactorization of the same matrix reusing the symbolic analysis
+ * and memory of the factor
+ */
+static void cholesky_refactor(sp_matrix_yale_ptr mtx,
+                              const double* x0,
+                              double* b)
+{
+  sp_chol_factor factor;
+  struct timespec t1,t2;
+  const int nrhs = 32;
+  int i, n = mtx->rows_count;
+  double *x, *B, *X;
+  portable_gettime(&t1);
+  if (!sp_chol_factor_init(&factor,mtx,ORDER_NESTED_DISSECTION))
+  {
+    printf("Unable to create Cholesky decomposition object\n");
+    return;
+  }
+  portable_gettime(&t2);
+  printf("Cholesky decomposition object creation time: ");
+  print_time_difference(&t1,&t2);
+  portable_gettime(&t1);
+  sp_chol_factor_refactor(&factor,mtx);
+  portable_gettime(&t2);
+  printf("Cholesky numeric refactorization time: ");
+  print_time_difference(&t1,&t2);
+  x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  sp_chol_factor_solve(&factor,b,x);
+  portable_gettime(&t2);
+  printf("Solving SLAE using Cholesky decomposition object time: ");
+  print_time_difference(&t1,&t2);
+  printf("SLAE using Cholesky decomposition object max error: ");
+  print_error(x0,x,mtx->rows_count);
+  /* multiple right-hand sides */
+  B = calloc(n*nrhs,sizeof(double));
+  X = calloc(n*nrhs,sizeof(double));
+  for (i = 0; i < nrhs; ++ i)
+    memcpy(B+i*n,b,n*sizeof(double));
+  portable_gettime(&t1);
+  for (i = 0; i < nrhs; ++ i)
+    sp_chol_factor_solve(&factor,B+i*n,X+i*n);
+  portable_gettime(&t2);
+  printf("Solving %d SLAEs using Cholesky decomposition object time: ",nrhs);
+  print_time_difference(&t1,&t2);
+  portable_gettime(&t1);
+  sp_chol_factor_solve_block(&factor,nrhs,B,X);
+  portable_gettime(&t2);
+  printf("Solving %d SLAEs using Cholesky block solver time: ",nrhs);
+  print_time_difference(&t1,&t2);
+  printf("SLAE using Cholesky block solver max error: ");
+  print_error(x0,X+(nrhs-1)*n,n);
+  free(B);
+  free(X);
+  free(x);
+  sp_chol_factor_free(&factor);
+}
+
+/*
+ * PCG with ILU preconditioner for the matrix reordered by the
+ * reverse Cuthill-McKee ordering; prints bandwidth and profile
+ * reduction, ILU creation time, iterations and error
+ */
+static void pcg_ilu_rcm(sp_matrix_yale_ptr mtx,
+                        const double* x0,
+                        double* b,
+                        const double* desired_tolerance,
+                        int tolerances_count,
+                        int max_iter)
+{
+  sp_matrix_yale permuted;
+  sp_matrix_skyline m;
+  sp_matrix_skyline_ilu ILU;
+  struct timespec t1,t2;
+  int n = mtx->rows_count;
+  int i, iter;
+  double tolerance;
+  int *perm = calloc(n,sizeof(int));
+  int *pinv = calloc(n,sizeof(int));
+  double *pb = calloc(n,sizeof(double));
+  double *px = calloc(n,sizeof(double));
+  double *x = calloc(n,sizeof(double));
+  portable_gettime(&t1);
+  sp_matrix_yale_rcm(mtx,perm);
+  portable_gettime(&t2);
+  printf("Reverse Cuthill-McKee ordering time: ");
+  print_time_difference(&t1,&t2);
+  sp_perm_inverse(perm,n,pinv);
+  sp_matrix_yale_permute(mtx,&permuted,pinv,pinv);
+  printf("Bandwidth: %d, with reverse Cuthill-McKee: %d\n",
+         sp_matrix_yale_bandwidth(mtx),
+         sp_matrix_yale_bandwidth(&permuted));
+  printf("Profile: %ld, with reverse Cuthill-McKee: %ld\n",
+         sp_matrix_yale_profile(mtx),
+         sp_matrix_yale_profile(&permuted));
+  portable_gettime(&t1);
+  sp_matrix_skyline_yale_init(&m,&permuted);
+  sp_matrix_skyline_ilu_copy_init(&ILU,&m);
+  portable_gettime(&t2);
+  printf("ILU decomposition with reverse Cuthill-McKee creation time: ");
+  print_time_difference(&t1,&t2);
+  sp_perm_vector(perm,n,b,pb);
+  for (i = 0; i < tolerances_count; ++ i)
+  {
+    tolerance = desired_tolerance[i];
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_pcg_ilu(&permuted,&ILU,pb,pb,&iter,&tolerance,px);
+    sp_perm_inverse_vector(perm,n,px,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using PCG-ILU method with reverse Cuthill-McKee");
+    printf(" with tolerance %e(iterations: %d) time: ",
+           tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using PCG-ILU with reverse Cuthill-McKee with tolerance");
+    printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
+    print_error(x0,x,n);
+  }
+  sp_matrix_skyline_ilu_free(&ILU);
+  sp_matrix_yale_free(&permuted);
+  free(perm);
+  free(pinv);
+  free(pb);
+  free(px);
+  free(x);
+}
+
+/*
+ * PCG with ILU(0) decomposition constructed on the Yale matrix
+ */
+static void pcg_ilu0(sp_matrix_yale_ptr mtx,
+                     const double* x0,
+                     double* b,
+                     const double* desired_tolerance,
+                     int tolerances_count,
+                     int max_iter)
+{
+  sp_matrix_yale_ilu ILU;
+  struct timespec t1,t2;
+  int i, iter;
+  double tolerance;
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  if (!sp_matrix_yale_ilu_init(&ILU,mtx))
+  {
+    printf("Unable to create ILU(0) decomposition\n");
+    free(x);
+    return;
+  }
+  portable_gettime(&t2);
+  printf("ILU(0) decomposition on Yale format creation time: ");
+  print_time_difference(&t1,&t2);
+  for (i = 0; i < tolerances_count; ++ i)
+  {
+    tolerance = desired_tolerance[i];
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_pcg_ilu0(mtx,&ILU,b,b,&iter,&tolerance,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using PCG-ILU(0) method");
+    printf(" with tolerance %e(iterations: %d) time: ",
+           tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using PCG-ILU(0) with tolerance");
+    printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
+    print_error(x0,x,mtx->rows_count);
+  }
+  sp_matrix_yale_ilu_free(&ILU);
+  free(x);
+}
+
+/*
+ * PCG with incomplete Cholesky decomposition:
+ * IC(0) if threshold is 0, IC(tau) with given tau and fill otherwise
+ */
+static void pcg_ic(sp_matrix_yale_ptr mtx,
+                   const double* x0,
+                   double* b,
+                   const double* desired_tolerance,
+                   int tolerances_count,
+                   int max_iter,
+                   int threshold,
+                   double tau,
+                   int fill)
+{
+  sp_matrix_yale_ic IC;
+  struct timespec t1,t2;
+  int i, iter, result;
+  double tolerance;
+  char name[64];
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  if (threshold)
+    sprintf(name,"IC(%g,%d)",tau,fill);
+  else
+    sprintf(name,"IC(0)");
+  portable_gettime(&t1);
+  result = threshold ? sp_matrix_yale_ict_init(&IC,mtx,tau,fill) :
+    sp_matrix_yale_ic0_init(&IC,mtx);
+  if (!result)
+  {
+    printf("Unable to create %s decomposition\n",name);
+    free(x);
+    return;
+  }
+  portable_gettime(&t2);
+  printf("%s decomposition(nonzeros: %d) creation time: ",
+         name,IC.L.nonzeros);
+  print_time_difference(&t1,&t2);
+  for (i = 0; i < tolerances_count; ++ i)
+  {
+    tolerance = desired_tolerance[i];
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_pcg_ic(mtx,&IC,b,b,&iter,&tolerance,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using PCG-%s method",name);
+    printf(" with tolerance %e(iterations: %d) time: ",
+           tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using PCG-%s with tolerance",name);
+    printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
+    print_error(x0,x,mtx->rows_count);
+  }
+  sp_matrix_yale_ic_free(&IC);
+  free(x);
+}
+
+static void pcg_amg(sp_matrix_yale_ptr mtx,
+                    const double* x0,
+                    double* b,
+                    const double* desired_tolerance,
+                    int tolerances_count,
+                    int max_iter,
+                    sp_amg_smoother_type smoother)
+{
+  sp_amg amg;
+  struct timespec t1,t2;
+  int i, iter;
+  double tolerance;
+  const char* name = smoother == AMG_SMOOTHER_JACOBI ?
+    "AMG(Jacobi)" : "AMG(Chebyshev)";
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  if (!sp_amg_init(&amg,mtx,0.08,smoother,2))
+  {
+    printf("Unable to create %s hierarchy\n",name);
+    free(x);
+    return;
+  }
+  portable_gettime(&t2);
+  printf("%s hierarchy(levels: %d, coarsest size: %d) creation time: ",
+         name,amg.levels_count,
+         amg.levels[amg.levels_count-1].A.rows_count);
+  print_time_difference(&t1,&t2);
+  for (i = 0; i < tolerances_count; ++ i)
+  {
+    tolerance = desired_tolerance[i];
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_pcg_amg(mtx,&amg,b,b,&iter,&tolerance,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using PCG-%s method",name);
+    printf(" with tolerance %e(iterations: %d) time: ",
+           tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using PCG-%s with tolerance",name);
+    printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
+    print_error(x0,x,mtx->rows_count);
+  }
+  sp_amg_free(&amg);
+  free(x);
+}
+
+/*
+ * BiCGSTAB and GMRES(30) with both orthogonalizations
+ * without preconditioner and with ILU(0) right preconditioner
+ */
+static void bicgstab_gmres(sp_matrix_yale_ptr mtx,
+                           const double* x0,
+                           double* b,
+                           double desired_tolerance,
+                           int max_iter)
+{
+  const int restart = 30;
+  const char* names[3] = {"BiCGSTAB", "GMRES(30)-MGS", "GMRES(30)-CGS2"};
+  sp_preconditioner precond;
+  struct timespec t1,t2;
+  int k, iter, ilu;
+  double tolerance;
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  sp_preconditioner_ilu0_init(&precond);
+  if (!sp_preconditioner_setup(&precond,mtx))
+  {
+    printf("Unable to create ILU(0) decomposition\n");
+    sp_preconditioner_free(&precond);
+    free(x);
+    return;
+  }
+  for (ilu = 0; ilu < 2; ++ ilu)
+    for (k = 0; k < 3; ++ k)
+    {
+      tolerance = desired_tolerance;
+      iter = max_iter;
+      portable_gettime(&t1);
+      if (k == 0)
+        sp_matrix_yale_solve_pbicgstab(mtx,ilu ? &precond : 0,
+                                       b,b,&iter,&tolerance,x);
+      else
+        sp_matrix_yale_solve_pgmres(mtx,ilu ? &precond : 0,restart,
+                                    k == 1 ? GMRES_MGS : GMRES_CGS2,
+                                    b,b,&iter,&tolerance,x);
+      portable_gettime(&t2);
+      printf("Solving SLAE using %s%s method",names[k],
+             ilu ? "-ILU(0)" : "");
+      printf(" with tolerance %e(iterations: %d) time: ",
+             tolerance,iter);
+      print_time_difference(&t1,&t2);
+      printf("SLAE using %s%s with tolerance",names[k],
+             ilu ? "-ILU(0)" : "");
+      printf(" %e(iterations: %d) max error: ",desired_tolerance,iter);
+      print_error(x0,x,mtx->rows_count);
+    }
+  sp_preconditioner_free(&precond);
+  free(x);
+}
+
+/*
+ * Conjugate Gradient versus pipelined Conjugate Gradient on the
+ * matrix in CRS format with 1..64 threads (with OPENMP=1 build).
+ * Iterations start from zero, desired_tolerance is relative to
+ * norm(b): the pipelined method calculates the true residual
+ * periodically, so it can't go below the attainable accuracy
+ */
+static void pipecg_benchmark(sp_matrix_yale_ptr mtx,
+                             const double* x0,
+                             double* b,
+                             double desired_tolerance,
+                             int max_iter)
+{
+#ifdef _OPENMP
+  const int max_threads = 64;
+#else
+  const int max_threads = 1;
+#endif
+  const char* names[2] = {"Conjugate Gradient", "pipelined CG"};
+  sp_matrix_yale crs;
+  struct timespec t1,t2;
+  int i, k, iter, threads;
+  double tolerance, norm_b = 0;
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  double *zero = calloc(mtx->rows_count,sizeof(double));
+  for (i = 0; i < mtx->rows_count; ++ i)
+    norm_b += b[i]*b[i];
+  norm_b = sqrt(norm_b);
+  sp_matrix_yale_convert(mtx,&crs,CRS);
+  for (threads = 1; threads <= max_threads; threads *= 2)
+  {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    for (k = 0; k < 2; ++ k)
+    {
+      tolerance = desired_tolerance*norm_b;
+      iter = max_iter;
+      portable_gettime(&t1);
+      if (k == 0)
+        sp_matrix_yale_solve_cg(&crs,b,zero,&iter,&tolerance,x);
+      else
+        sp_matrix_yale_solve_pipecg(&crs,0,b,zero,&iter,&tolerance,x);
+      portable_gettime(&t2);
+      printf("Solving SLAE using %s method with %d threads",
+             names[k],threads);
+      printf(" with tolerance %e(iterations: %d) time: ",
+             tolerance,iter);
+      print_time_difference(&t1,&t2);
+      printf("SLAE using %s with relative tolerance",names[k]);
+      printf(" %e(iterations: %d) max error: ",desired_tolerance,iter);
+      print_error(x0,x,mtx->rows_count);
+    }
+  }
+  sp_matrix_yale_free(&crs);
+  free(zero);
+  free(x);
+}
+
+/*
+ * Block Conjugate Gradient for nrhs right-hand sides versus
+ * sequential Conjugate Gradient solves. Iterations start from zero,
+ * desired_tolerance is relative to the norm of the first
+ * right-hand side
+ */
+static void block_cg(sp_matrix_yale_ptr mtx,
+                     double desired_tolerance,
+                     int max_iter)
+{
+  const int nrhs = 8;
+  const int n = mtx->rows_count;
+  sp_matrix_yale crs;
+  struct timespec t1,t2;
+  int i, c, iter, total = 0;
+  int iterations[8];
+  double residuals[8];
+  double tolerance, norm_b = 0;
+  double *B = calloc(n*nrhs,sizeof(double));
+  double *X = calloc(n*nrhs,sizeof(double));
+  double *X0 = calloc(n*nrhs,sizeof(double));
+  double *X_expected = calloc(n*nrhs,sizeof(double));
+  sp_matrix_yale_convert(mtx,&crs,CRS);
+  for (c = 0; c < nrhs; ++ c)
+  {
+    for (i = 0; i < n; ++ i)
+      X_expected[c*n+i] = pow(-1,(i+c)%3) * ((i*(c+1)) % 10);
+    sp_matrix_yale_mv(&crs,X_expected+c*n,B+c*n);
+  }
+  for (i = 0; i < n; ++ i)
+    norm_b += B[i]*B[i];
+  tolerance = desired_tolerance*sqrt(norm_b);
+  
+  portable_gettime(&t1);
+  for (c = 0; c < nrhs; ++ c)
+  {
+    iter = max_iter;
+    residuals[c] = tolerance;
+    sp_matrix_yale_solve_cg(&crs,B+c*n,X0+c*n,&iter,&residuals[c],X+c*n);
+    total += iter;
+  }
+  portable_gettime(&t2);
+  printf("Solving %d SLAEs using Conjugate Gradient method",nrhs);
+  printf("(total iterations: %d) time: ",total);
+  print_time_difference(&t1,&t2);
+  for (c = 0; c < nrhs; ++ c)
+  {
+    printf("SLAE %d using Conjugate Gradient max error: ",c);
+    print_error(X_expected+c*n,X+c*n,n);
+  }
+
+  iter = max_iter;
+  portable_gettime(&t1);
+  sp_matrix_yale_solve_block_cg(&crs,0,nrhs,B,X0,&iter,tolerance,
+                                iterations,residuals,X);
+  portable_gettime(&t2);
+  printf("Solving %d SLAEs using Block Conjugate Gradient method",nrhs);
+  printf("(iterations: %d) time: ",iter);
+  print_time_difference(&t1,&t2);
+  for (c = 0; c < nrhs; ++ c)
+  {
+    printf("SLAE %d using Block Conjugate Gradient", c);
+    printf("(iterations: %d, residual: %e) max error: ",
+           iterations[c],residuals[c]);
+    print_error(X_expected+c*n,X+c*n,n);
+  }
+  sp_matrix_yale_free(&crs);
+  free(B);
+  free(X);
+  free(X0);
+  free(X_expected);
+}
+
+/*
+ * Setup time of ILU(0) and ILUT(p,tau) decompositions versus
+ * iterations of preconditioned TFQMR and CGS methods
+ */
+static void ilut_benchmark(sp_matrix_yale_ptr mtx,
+                           const double* x0,
+                           double* b,
+                           double desired_tolerance,
+                           int max_iter)
+{
+  const double taus[] = {1e-2, 1e-3, 1e-4};
+  const int fills[] = {5, 10, 20};
+  sp_matrix_yale_ilu ILU;
+  sp_preconditioner precond;
+  struct timespec t1,t2;
+  int i, iter, result;
+  double tolerance;
+  char name[64];
+  double *x = calloc(mtx->rows_count,sizeof(double));
+  for (i = -1; i < (int)(sizeof(taus)/sizeof(taus[0])); ++ i)
+  {
+    portable_gettime(&t1);
+    if (i < 0)
+    {
+      sprintf(name,"ILU(0)");
+      result = sp_matrix_yale_ilu_init(&ILU,mtx);
+    }
+    else
+    {
+      sprintf(name,"ILUT(%d,%g)",fills[i],taus[i]);
+      result = sp_matrix_yale_ilut_init(&ILU,mtx,taus[i],fills[i]);
+    }
+    portable_gettime(&t2);
+    if (!result)
+    {
+      printf("Unable to create %s decomposition\n",name);
+      continue;
+    }
+    printf("%s decomposition(nonzeros: %d) creation time: ",
+           name,ILU.LU.nonzeros);
+    print_time_difference(&t1,&t2);
+    sp_preconditioner_user_init(&precond,sp_matrix_yale_ilu_precond,&ILU);
+    tolerance = desired_tolerance;
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_ptfqmr(mtx,&precond,b,b,&iter,&tolerance,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using TFQMR-%s method",name);
+    printf(" with tolerance %e(iterations: %d) time: ",tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using TFQMR-%s max error: ",name);
+    print_error(x0,x,mtx->rows_count);
+    tolerance = desired_tolerance;
+    iter = max_iter;
+    portable_gettime(&t1);
+    sp_matrix_yale_solve_pcgs(mtx,&precond,b,b,&iter,&tolerance,x);
+    portable_gettime(&t2);
+    printf("Solving SLAE using CGS-%s method",name);
+    printf(" with tolerance %e(iterations: %d) time: ",tolerance,iter);
+    print_time_difference(&t1,&t2);
+    printf("SLAE using CGS-%s max error: ",name);
+    print_error(x0,x,mtx->rows_count);
+    sp_matrix_yale_ilu_free(&ILU);
+  }
+  free(x);
+}
+
+/*
+ * LU decomposition with threshold partial pivoting and nested
+ * dissection column preordering: initial factorization and
+ * refactorization with the same pivots
+ */
+static void lu_factor(sp_matrix_yale_ptr mtx,
+                      const double* x0,
+                      double* b)
+{
+  sp_lu_factor lu;
+  struct timespec t1,t2;
+  double* x;
+  portable_gettime(&t1);
+  if (!sp_lu_factor_init(&lu,mtx,ORDER_NESTED_DISSECTION,
+                         SP_LU_PIVOT_TOLERANCE))
+  {
+    printf("Unable to create LU decomposition\n");
+    return;
+  }
+  portable_gettime(&t2);
+  printf("LU decomposition with nested dissection time: ");
+  print_time_difference(&t1,&t2);
+  printf("Nonzeros size increase with LU decomposition:");
+  printf("from %d to %d is %.2f %% size increase\n",
+         mtx->nonzeros,lu.L.nonzeros+lu.U.nonzeros,
+         (lu.L.nonzeros+lu.U.nonzeros)/(mtx->nonzeros/100.)-100.0);
+  portable_gettime(&t1);
+  sp_lu_factor_refactor(&lu,mtx);
+  portable_gettime(&t2);
+  printf("LU numeric refactorization time: ");
+  print_time_difference(&t1,&t2);
+  x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  sp_lu_factor_solve(&lu,b,x);
+  portable_gettime(&t2);
+  printf("Solving SLAE using LU decomposition time: ");
+  print_time_difference(&t1,&t2);
+  printf("SLAE using LU decomposition max error: ");
+  print_error(x0,x,mtx->rows_count);
+  free(x);
+  sp_lu_factor_free(&lu);
+}
+
+static void cholesky_mixed(sp_matrix_yale_ptr mtx,
+                           const double* x0,
+                           double* b)
+{
+  sp_chol_mixed mixed;
+  struct timespec t1,t2;
+  double* x;
+  portable_gettime(&t1);
+  if (!sp_chol_mixed_init(&mixed,mtx,ORDER_NESTED_DISSECTION,
+                          SP_CHOL_MIXED_TOLERANCE))
+  {
+    printf("Unable to create mixed precision Cholesky decomposition\n");
+    return;
+  }
+  portable_gettime(&t2);
+  printf("Mixed precision Cholesky decomposition time: ");
+  print_time_difference(&t1,&t2);
+  x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  sp_chol_mixed_solve(&mixed,b,x);
+  portable_gettime(&t2);
+  printf("Solving SLAE using mixed precision Cholesky decomposition");
+  printf("(refinement steps: %d%s) time: ",mixed.iterations,
+         mixed.fallback ? ", fallback to double precision" : "");
+  print_time_difference(&t1,&t2);
+  printf("SLAE using mixed precision Cholesky decomposition max error: ");
+  print_error(x0,x,mtx->rows_count);
+  free(x);
+  sp_chol_mixed_free(&mixed);
+}
+
+static void cholesky_out_of_core(sp_matrix_yale_ptr mtx,
+                                 const double* x0,
+                                 double* b)
+{
+  sp_chol_symbolic symb;
+  sp_chol_ooc ooc;
+  struct timespec t1,t2;
+  size_t budget;
+  double* x;
+  /*
+   * budget is 1/8 of values and row indicies of L with workspaces:
+   * two copies of the matrix and 64 bytes per row
+   */
+  if (!sp_matrix_yale_chol_symbolic_ordered(mtx,&symb,
+                                            ORDER_NESTED_DISSECTION))
+    return;
+  budget = symb.nonzeros*(sizeof(double)+sizeof(int))/8 +
+    2*(size_t)mtx->nonzeros*(sizeof(double)+sizeof(int)) +
+    64*(size_t)mtx->rows_count;
+  sp_matrix_yale_symbolic_free(&symb);
+  portable_gettime(&t1);
+  if (!sp_chol_ooc_init(&ooc,mtx,ORDER_NESTED_DISSECTION,budget,0))
+  {
+    printf("Unable to create out-of-core Cholesky decomposition\n");
+    return;
+  }
+  portable_gettime(&t2);
+  printf("Out-of-core Cholesky decomposition with budget %lu bytes",
+         (unsigned long)budget);
+  printf("(%d panels) time: ",ooc.panels_count);
+  print_time_difference(&t1,&t2);
+  x = calloc(mtx->rows_count,sizeof(double));
+  portable_gettime(&t1);
+  sp_chol_ooc_solve(&ooc,b,x);
+  portable_gettime(&t2);
+  printf("Solving SLAE using out-of-core Cholesky decomposition time: ");
+  print_time_difference(&t1,&t2);
+  printf("SLAE using out-of-core Cholesky decomposition max error: ");
+  print_error(x0,x,mtx->rows_count);
+  free(x);
+  sp_chol_ooc_free(&ooc);
+}
+
 int main(int argc, char *argv[])
 {
   int i;
@@ -159,6 +875,11 @@ int main(int argc, char *argv[])
         print_time_difference(&t1,&t2);
         printf("SLAE using Cholesky decomposition max error: ");
         print_error(x0,x,mtx.rows_count);
+        cholesky_ordered(&mtx,ORDER_NESTED_DISSECTION,"nested dissection",
+                         x0,b);
+        cholesky_ordered(&mtx,ORDER_REVERSE_CUTHILL_MCKEE,
+                         "reverse Cuthill-McKee",x0,b);
+        cholesky_refactor(&mtx,x0,b);
         /* sp_matrix_yale_convert_inplace(&mtx,CRS); */
         for (i = 0; i < 3; ++ i)
         {
@@ -201,6 +922,13 @@ int main(int argc, char *argv[])
           printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
           print_error(x0,x,mtx.rows_count);
         }
+        pcg_ilu_rcm(&mtx,x0,b,desired_tolerance,3,max_iter);
+        pcg_ilu0(&mtx,x0,b,desired_tolerance,3,max_iter);
+        pcg_ic(&mtx,x0,b,desired_tolerance,3,max_iter,0,0,0);
+        pcg_ic(&mtx,x0,b,desired_tolerance,3,max_iter,1,1e-3,10);
+        pcg_amg(&mtx,x0,b,desired_tolerance,3,max_iter,AMG_SMOOTHER_JACOBI);
+        pcg_amg(&mtx,x0,b,desired_tolerance,3,max_iter,
+                AMG_SMOOTHER_CHEBYSHEV);
         for (i = 0; i < 3; ++ i)
         {
           tolerance = desired_tolerance[i];
@@ -235,6 +963,13 @@ int main(int argc, char *argv[])
           printf(" %e(iterations: %d) max error: ",desired_tolerance[i],iter);
           print_error(x0,x,mtx.rows_count);
         }
+        bicgstab_gmres(&mtx,x0,b,desired_tolerance[1],max_iter);
+        pipecg_benchmark(&mtx,x0,b,desired_tolerance[1],max_iter);
+        block_cg(&mtx,desired_tolerance[1],max_iter);
+        ilut_benchmark(&mtx,x0,b,desired_tolerance[1],max_iter);
+        lu_factor(&mtx,x0,b);
+        cholesky_out_of_core(&mtx,x0,b);
+        cholesky_mixed(&mtx,x0,b);
 
 
         sp_matrix_skyline_ilu_free(&ILU);
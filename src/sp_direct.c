@@ -22,6 +22,7 @@
 #include <float.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "sp_direct.h"
 #include "sp_mem.h"
@@ -36,139 +37,269 @@ static int is_almost_zero(double x)
 }
 
 
+/*
+ * LDL' decomposition parameters
+ * pivot perturbation threshold relative to the max |a_ij|
+ */
+#define SP_LDL_PIVOT_TOLERANCE 1e-8
+/* maximum number of iterative refinement steps */
+#define SP_LDL_REFINEMENT_STEPS 5
+/* desired relative residual of iterative refinement */
+#define SP_LDL_REFINEMENT_TOLERANCE 1e-14
+/*
+ * Mixed precision Cholesky parameters
+ * maximum number of iterative refinement steps
+ */
+#define SP_CHOL_MIXED_REFINEMENT_STEPS 20
+/*
+ * refinement stalls if the residual norm decreases less than
+ * in this number of times per step
+ */
+#define SP_CHOL_MIXED_STALL_RATIO 2
+/*
+ * initial estimate of nonzeros in L and U factors of the LU
+ * decomposition, in number of nonzeros of the matrix; factors are
+ * reallocated by the numeric decomposition if it is exceeded
+ */
+#define SP_LU_NONZEROS_FACTOR 4
+
+static double norm2(double* x, int size)
+{
+  int i;
+  double result = 0;
+  for (i = 0; i < size; ++ i)
+    result += x[i]*x[i];
+  return sqrt(result);
+}
+
 int sp_matrix_yale_etree(sp_matrix_yale_ptr self, int* tree)
 {
-  int k,i,j,p;
-  int *parents;
-  if ( !self || self->storage_type != CCS)
+  /*
+   * Liu's algorithm: for every k traverse from every nonzero a_ik,
+   * i < k, up to the root of the current elimination tree by the
+   * ancestor array compressing the path to k, then link the root to k.
+   * Complexity: nearly O(nonzeros)
+   */
+  int k,i,p,next;
+  int *ancestor;
+  if (!self)
     return 0;
 
-  parents = spalloc(sizeof(int)*self->rows_count);
-
-  /* initialize tree */
-  for ( k = 0; k < self->rows_count; ++ k)
-    tree[k] = -1;
-  
+  ancestor = spalloc(sizeof(int)*self->rows_count);
   for ( k = 0; k < self->rows_count; ++ k) /* loop by Tk */
   {
-    /* loop by nonzero rows in the column */
-    j = 0;
+    /* initialize tree */
+    tree[k] = -1;
+    ancestor[k] = -1;
+    /*
+     * loop by nonzero rows in the column k (CCS) or
+     * nonzero columns in the row k (CRS): for symmetric
+     * portrait both are the same
+     */
     for ( p = self->offsets[k]; p < self->offsets[k+1]; ++p )
     {
-      /* store the index to i for simplicity */
-      i = self->indicies[p];
-      if ( i < k )              /* if above the diagonal */
+      /* traverse from i to the root of its subtree */
+      for ( i = self->indicies[p]; i != -1 && i < k; i = next )
       {
-        /* find the root for the i in the previous elimination tree */
-        parents[j] = tree_find(tree,self->rows_count,i);
-        /* increase the number of roots found (number of nonzeros)
-         * above diagonal*/
-        j++;
+        next = ancestor[i];
+        /* path compression */
+        ancestor[i] = k;
+        /* no parent yet: k is the parent of the root */
+        if (next == -1)
+          tree[i] = k;
       }
     }
-    /* now update - append found roots to the new root k */
-    for (i = 0; i < j; ++ i)
-      tree[parents[i]] = k;
   }
-  spfree(parents);
+  spfree(ancestor);
   
   return 1;
 }
 
 
-int sp_matrix_yale_ereach(sp_matrix_yale_ptr self, int* etree, int k, int* out)
+/* comparison function for qsort */
+static int int_compare(const void* x, const void* y)
 {
-  int i,j,p;
+  return *(const int*)x - *(const int*)y;
+}
+
+/*
+ * Constructs the nonzero portrait of the kth row of the L matrix
+ * without sorting and without modification of the etree.
+ * marker - workspace of rows_count elements, initially not equal to k:
+ * marker[i] == k means i is already visited, so no resets between
+ * rows are needed
+ * out - output array with allocated size self->rows_count
+ * Complexity: O(number of nonzeros in the row of L)
+ * returns the number of elements in the out array
+ */
+static int sp_matrix_yale_ereach_marked(sp_matrix_yale_ptr self,
+                                        const int* etree,
+                                        int k,
+                                        int* marker,
+                                        int* out)
+{
+  int i,p;
   int count = 0;
-  if ( self->storage_type != CCS)
-    return -1;
-  
-  /* clear the out */
-  for (j = 0; j < self->rows_count; ++ j)
-    out[j] = -1;
-#define OUT_MARK(i) {out[(i)] = (i); ++count; }
-  /* mark k */
-  OUT_MARK(k);
-  /* loop by nonzero rows in the column */
+  marker[k] = k;
+  out[count++] = k;
   for ( p = self->offsets[k]; p < self->offsets[k+1]; ++p )
   {
-    /* store the index to i for simplicity */
-    i = self->indicies[p];
-    if ( i < k )              /* if above the diagonal */
+    for (i = self->indicies[p]; i < k && marker[i] != k; i = etree[i])
     {
-      /* mark i */
-      if (out[i] != i)
-        OUT_MARK(i);
-      /* find the root */
-      for (j = etree[i]; j != -1 && j != etree[j]; j = etree[j])
-      {
-        if ( out[j] != j)
-        {
-          /* mark j */
-          OUT_MARK(j);
-        }
-        else                    /* marked reached */
-          break;
-      }
+      marker[i] = k;
+      out[count++] = i;
     }
   }
-#undef OUT_MARK
-  /* compress the output */
-#define SWAP_VALUES(x,y) { i = (x); x = (y); (y) = i; }
-  k = 0;
-  for ( j = 0; j < self->rows_count; ++ j)
-    if ( out[j] != -1 )
-    {
-      SWAP_VALUES(out[j],out[k]);
-      k++;
-      if  (k >= count)
-        break;
-    }
-#undef SWAP_VALUES
   return count;
 }
 
+int sp_matrix_yale_ereach_marker(sp_matrix_yale_ptr self,
+                                 const int* etree,
+                                 int k,
+                                 int* marker,
+                                 int* out)
+{
+  int count = sp_matrix_yale_ereach_marked(self,etree,k,marker,out);
+  qsort(out,count,sizeof(int),int_compare);
+  return count;
+}
 
-int sp_matrix_yale_chol_counts(sp_matrix_yale_ptr self,
-                               int* etree,
-                               int* rowcounts,
-                               int* colcounts)
+int sp_matrix_yale_ereach(sp_matrix_yale_ptr self, int* etree, int k, int* out)
+{
+  int i,count;
+  int* marker = spalloc((self->rows_count ? self->rows_count : 1)*
+                        sizeof(int));
+  for (i = 0; i < self->rows_count; ++ i)
+    marker[i] = -1;
+  count = sp_matrix_yale_ereach_marker(self,etree,k,marker,out);
+  spfree(marker);
+  return count;
+}
+
+
+/*
+ * Determines if the node j is the leaf of the ith row subtree
+ * and finds the least common ancestor of j and the previous leaf
+ * of the ith row subtree (or i if j is the first leaf).
+ * first - first descendants of nodes in the postordered tree
+ * maxfirst - the largest first[j] seen so far for the row i
+ * prevleaf - the previous leaf of the ith row subtree
+ * ancestor - disjoint sets of the nodes, compressed during search
+ * jleaf - 0 if j is not a leaf, 1 if the first leaf, 2 otherwise
+ * Returns the least common ancestor or -1 if j is not a leaf
+ * See T.A.Davis, Direct Methods for Sparse Linear Systems(2006) p.51
+ */
+static int sp_chol_leaf(int i, int j,
+                        int* first,
+                        int* maxfirst,
+                        int* prevleaf,
+                        int* ancestor,
+                        int* jleaf)
+{
+  int q,s,sparent,jprev;
+  *jleaf = 0;
+  /* j is not a leaf if there was a descendant of j in the row */
+  if (i <= j || first[j] <= maxfirst[i])
+    return -1;
+  maxfirst[i] = first[j];
+  jprev = prevleaf[i];
+  prevleaf[i] = j;
+  *jleaf = jprev == -1 ? 1 : 2;
+  if (*jleaf == 1)              /* first leaf: root of the row subtree */
+    return i;
+  /* least common ancestor of jprev and j */
+  for (q = jprev; q != ancestor[q]; q = ancestor[q]);
+  /* path compression */
+  for (s = jprev; s != q; s = sparent)
+  {
+    sparent = ancestor[s];
+    ancestor[s] = q;
+  }
+  return q;
+}
+
+/*
+ * Calculates row and column counts using the given postorder
+ * of the elimination tree.
+ * Skeleton matrix and least common ancestors are used to find
+ * both counts in nearly O(nonzeros) time, see
+ * T.A.Davis, Direct Methods for Sparse Linear Systems(2006) p.55,
+ * and J.R.Gilbert, E.G.Ng, B.W.Peyton, An efficient algorithm to
+ * compute row and column counts for sparse Cholesky factorization
+ */
+static int sp_matrix_yale_chol_counts_post(sp_matrix_yale_ptr self,
+                                           int* etree,
+                                           int* post,
+                                           int* rowcounts,
+                                           int* colcounts)
 {
-  int result = 1;
   int n = self->rows_count;
-  int j,k,p;
-  /* array to store marked nodes. nonzero means node is marked */
-  char *marked = (char*)spalloc(n);
-  memset(rowcounts,0,n*sizeof(int));
-  memset(colcounts,0,n*sizeof(int));
-#define _TREE_MARK(i) {marked[(i)] = 1; ++rowcounts[k]; }
-  for (k = 0; k < n; ++ k)      /* loop by rows */
-  {
-    memset(marked,0,n);          /* clear all marks */
-    /* loop by nonzero rows in the column, or nonzero cols in
-     * the row, depending on storage schema */
-    for ( p = self->offsets[k]; p < self->offsets[k+1]; ++p )
+  int i,j,k,p,q,jleaf;
+  int *workspace, *first, *maxfirst, *prevleaf, *ancestor, *level;
+  workspace = spalloc(5*n*sizeof(int));
+  first = workspace;
+  maxfirst = workspace + n;
+  prevleaf = workspace + 2*n;
+  ancestor = workspace + 3*n;
+  level = workspace + 4*n;
+  tree_first_descendant(etree,n,post,first);
+  tree_node_levels(etree,n,level);
+  for (i = 0; i < n; ++ i)
+  {
+    maxfirst[i] = -1;
+    prevleaf[i] = -1;
+    ancestor[i] = i;
+    rowcounts[i] = 1;           /* diagonal */
+  }
+  /*
+   * colcounts are calculated as differences, 1 for leaves:
+   * first descendant of the leaf is the leaf itself
+   */
+  for (k = 0; k < n; ++ k)
+  {
+    j = post[k];
+    colcounts[j] = first[j] == k ? 1 : 0;
+  }
+  for (k = 0; k < n; ++ k)
+  {
+    j = post[k];
+    if (etree[j] != -1)         /* j is not a root */
+      colcounts[etree[j]]--;
+    /* a_ij != 0 with i > j, matrix is symmetric */
+    for (p = self->offsets[j]; p < self->offsets[j+1]; ++ p)
     {
-      /* store the index to i for simplicity */
-      j = self->indicies[p];    /* a_kj != 0 */
-      if ( j <= k )             /* if above the diagonal */
+      i = self->indicies[p];
+      q = sp_chol_leaf(i,j,first,maxfirst,prevleaf,ancestor,&jleaf);
+      if (jleaf >= 1)           /* a_ij is in skeleton matrix */
       {
-        while(!marked[j]) /* marked encountered, goto next nonzero */
-        {
-          ++colcounts[j];
-          _TREE_MARK(j);
-          if (j == k)           /* root encountered, goto next nonzero */
-            break;
-          /* else climb up by the tree */
-          j = etree[j];
-        }
+        colcounts[j]++;
+        rowcounts[i] += level[j] - level[q];
       }
-      else                      /* assuming indicies are sorted */
-        break;
+      if (jleaf == 2)           /* account for overlap in q */
+        colcounts[q]--;
     }
+    if (etree[j] != -1)
+      ancestor[j] = etree[j];
   }
-#undef _TREE_MARK
-  spfree(marked);
+  /* sum up differences of children */
+  for (j = 0; j < n; ++ j)
+    if (etree[j] != -1)
+      colcounts[etree[j]] += colcounts[j];
+  spfree(workspace);
+  return 1;
+}
+
+int sp_matrix_yale_chol_counts(sp_matrix_yale_ptr self,
+                               int* etree,
+                               int* rowcounts,
+                               int* colcounts)
+{
+  int result;
+  int* post = spalloc(self->rows_count*sizeof(int));
+  tree_postorder_perm(etree,self->rows_count,post);
+  result = sp_matrix_yale_chol_counts_post(self,etree,post,
+                                           rowcounts,colcounts);
+  spfree(post);
   return result;
 }
 
@@ -280,10 +411,332 @@ int sp_matrix_yale_lower_trans_solve(sp_matrix_yale_ptr self,
 }
 
 
+/*
+ * Depth-first search in the graph of the CCS matrix L starting from
+ * the node j. Node j corresponds to the column pinv[j] of L (or j if
+ * pinv is 0); nodes with negative pinv[j] have no edges
+ * (not yet pivotal rows in LU decomposition).
+ * Visited nodes are marked with marker[j] = stamp.
+ * xi - output stack of the nodes in the topological order:
+ * found nodes are stored in xi[top..n-1]
+ * stack - workspace of rows_count elements
+ * returns the new top
+ */
+static int sp_matrix_yale_dfs(sp_matrix_yale_ptr L,
+                              int j,
+                              int top,
+                              int* xi,
+                              int* stack,
+                              int* pinv,
+                              int* marker,
+                              int stamp)
+{
+  int i,p,p2,jnew,done;
+  int head = 0;
+  /* stack of the nodes is in xi[0..head], of positions in stack */
+  xi[0] = j;
+  while (head >= 0)
+  {
+    j = xi[head];
+    jnew = pinv ? pinv[j] : j;
+    if (marker[j] != stamp)
+    {
+      marker[j] = stamp;
+      stack[head] = jnew < 0 ? 0 : L->offsets[jnew]+1;
+    }
+    done = 1;
+    p2 = jnew < 0 ? 0 : L->offsets[jnew+1];
+    for (p = stack[head]; p < p2; ++ p)
+    {
+      i = L->indicies[p];
+      if (marker[i] == stamp)
+        continue;
+      /* pause the search of the node j and continue with i */
+      stack[head] = p;
+      xi[++head] = i;
+      done = 0;
+      break;
+    }
+    if (done)
+    {
+      head--;
+      xi[--top] = j;
+    }
+  }
+  return top;
+}
+
+int sp_matrix_yale_lower_solve_sparse(sp_matrix_yale_ptr self,
+                                      int nonzeros,
+                                      int* bi,
+                                      double* bx,
+                                      double* x,
+                                      int* xi,
+                                      int* workspace,
+                                      int* count)
+{
+  int i,j,k,p,top;
+  int n = self->rows_count;
+  int* marker = workspace + n;
+  double value;
+  if (self->storage_type != CCS)
+  {
+    LOGERROR("Sparse lower solver: matrix in CCS format expected");
+    return 0;
+  }
+  /* reach of the b in the graph of L */
+  top = n;
+  for (k = 0; k < nonzeros; ++ k)
+    if (!marker[bi[k]])
+      top = sp_matrix_yale_dfs(self,bi[k],top,xi,workspace,0,marker,1);
+  for (k = 0; k < nonzeros; ++ k)
+    x[bi[k]] += bx[k];
+  /* solve by the reach in the topological order */
+  for (k = top; k < n; ++ k)
+  {
+    j = xi[k];
+    marker[j] = 0;
+    value = self->values[self->offsets[j]];
+    if (is_almost_zero(value))
+    {
+      LOGERROR("Sparse lower solver: %d diagonal element: %e",j,value);
+      for (; k < n; ++ k)
+        marker[xi[k]] = 0;
+      return 0;
+    }
+    x[j] /= value;
+    for (p = self->offsets[j]+1; p < self->offsets[j+1]; ++ p)
+    {
+      i = self->indicies[p];
+      x[i] -= self->values[p]*x[j];
+    }
+  }
+  /* move the portrait to the beginning */
+  memmove(xi,xi+top,(n-top)*sizeof(int));
+  *count = n - top;
+  return 1;
+}
+
+int sp_level_schedule_init(sp_level_schedule_ptr self,
+                           int n,
+                           int* offsets,
+                           int* indicies,
+                           sparse_storage_type type)
+{
+  int i,j,k,p;
+  int nonzeros = offsets[n];
+  int* level;
+  if (!self || n < 0)
+    return 0;
+  memset(self,0,sizeof(sp_level_schedule));
+  self->rows_count = n;
+  level = spcalloc(n+1,sizeof(int));
+  /* level of the row is greater than levels of rows it depends on */
+  if (type == CRS)
+  {
+    for (i = 0; i < n; ++ i)
+      for (p = offsets[i]; p < offsets[i+1]; ++ p)
+        if ((j = indicies[p]) < i && level[j] >= level[i])
+          level[i] = level[j] + 1;
+  }
+  else
+  {
+    for (j = 0; j < n; ++ j)
+      for (p = offsets[j]; p < offsets[j+1]; ++ p)
+        if ((i = indicies[p]) > j && level[j] >= level[i])
+          level[i] = level[j] + 1;
+  }
+  for (i = 0; i < n; ++ i)
+    if (level[i] >= self->levels_count)
+      self->levels_count = level[i] + 1;
+  /* sort rows by levels */
+  self->levels = spcalloc(self->levels_count+1,sizeof(int));
+  self->rows = spalloc((n ? n : 1)*sizeof(int));
+  for (i = 0; i < n; ++ i)
+    self->levels[level[i]+1]++;
+  for (k = 0; k < self->levels_count; ++ k)
+    self->levels[k+1] += self->levels[k];
+  for (i = 0; i < n; ++ i)
+    self->rows[self->levels[level[i]]++] = i;
+  for (k = self->levels_count; k > 0; -- k)
+    self->levels[k] = self->levels[k-1];
+  self->levels[0] = 0;
+  /* transposed portrait */
+  self->offsets = spcalloc(n+1,sizeof(int));
+  self->indicies = spalloc((nonzeros ? nonzeros : 1)*sizeof(int));
+  self->positions = spalloc((nonzeros ? nonzeros : 1)*sizeof(int));
+  for (p = 0; p < nonzeros; ++ p)
+    self->offsets[indicies[p]+1]++;
+  for (i = 0; i < n; ++ i)
+    self->offsets[i+1] += self->offsets[i];
+  memcpy(level,self->offsets,n*sizeof(int));
+  for (i = 0; i < n; ++ i)
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+    {
+      k = level[indicies[p]]++;
+      self->indicies[k] = i;
+      self->positions[k] = p;
+    }
+  spfree(level);
+  return 1;
+}
+
+void sp_level_schedule_free(sp_level_schedule_ptr self)
+{
+  if (self && self->levels)
+  {
+    spfree(self->levels);
+    spfree(self->rows);
+    spfree(self->offsets);
+    spfree(self->indicies);
+    spfree(self->positions);
+    memset(self,0,sizeof(sp_level_schedule));
+  }
+}
+
+int sp_level_schedule_solve(sp_level_schedule_ptr self,
+                            int* offsets,
+                            int* indicies,
+                            int* positions,
+                            double* values,
+                            double* diag,
+                            int forward,
+                            double* b,
+                            double* x)
+{
+  int result = 1;
+  int i,j,k,l,p,r,first,last;
+  double sum,d,value;
+  for (k = 0; k < self->levels_count; ++ k)
+  {
+    l = forward ? k : self->levels_count - 1 - k;
+    first = self->levels[l];
+    last = self->levels[l+1];
+    /* rows of the level are independent */
+    SP_OMP(omp parallel for private(i,j,p,sum,d,value)            \
+           reduction(&&:result) if(last - first > SP_SCHEDULE_PARALLEL_MIN))
+    for (r = first; r < last; ++ r)
+    {
+      i = self->rows[r];
+      sum = b[i];
+      d = diag ? diag[i] : 1;
+      for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      {
+        j = indicies[p];
+        value = values[positions ? positions[p] : p];
+        if (j == i)
+          d = value;
+        else if ((j < i) == (forward != 0))
+          sum -= value*x[j];
+      }
+      if (is_almost_zero(d))
+        result = 0;
+      else
+        x[i] = sum/d;
+    }
+  }
+  if (!result)
+    LOGERROR("Scheduled triangular solver: zero diagonal element");
+  return result;
+}
+
+/*
+ * Block variant of sp_level_schedule_solve for the triangular matrix
+ * with the diagonal stored: solves kb systems at once inplace,
+ * w[i*kb + r] is the i-th element of the r-th right-hand side.
+ * kb shall not exceed SP_CHOL_BLOCK_RHS
+ * Returns nonzero if successfull
+ */
+static int sp_level_schedule_solve_block(sp_level_schedule_ptr self,
+                                         int* offsets,
+                                         int* indicies,
+                                         int* positions,
+                                         double* values,
+                                         int forward,
+                                         int kb,
+                                         double* w)
+{
+  int result = 1;
+  int i,j,k,l,p,r,c,first,last;
+  double d,value;
+  double sum[SP_CHOL_BLOCK_RHS];
+  for (k = 0; k < self->levels_count; ++ k)
+  {
+    l = forward ? k : self->levels_count - 1 - k;
+    first = self->levels[l];
+    last = self->levels[l+1];
+    /* rows of the level are independent */
+    SP_OMP(omp parallel for private(i,j,p,c,d,value,sum)          \
+           reduction(&&:result) if(last - first > SP_SCHEDULE_PARALLEL_MIN))
+    for (r = first; r < last; ++ r)
+    {
+      i = self->rows[r];
+      d = 0;
+      for (c = 0; c < kb; ++ c)
+        sum[c] = w[i*kb + c];
+      for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      {
+        j = indicies[p];
+        value = values[positions ? positions[p] : p];
+        if (j == i)
+          d = value;
+        else if ((j < i) == (forward != 0))
+          for (c = 0; c < kb; ++ c)
+            sum[c] -= value*w[j*kb + c];
+      }
+      if (is_almost_zero(d))
+        result = 0;
+      else
+        for (c = 0; c < kb; ++ c)
+          w[i*kb + c] = sum[c]/d;
+    }
+  }
+  if (!result)
+    LOGERROR("Scheduled triangular solver: zero diagonal element");
+  return result;
+}
+
+int sp_matrix_yale_lower_solve_scheduled(sp_matrix_yale_ptr self,
+                                         sp_level_schedule_ptr schedule,
+                                         double* b,
+                                         double* x)
+{
+  /* rows of L: the matrix itself or the transposed portrait */
+  if (self->storage_type == CRS)
+    return sp_level_schedule_solve(schedule,
+                                   self->offsets,self->indicies,0,
+                                   self->values,0,1,b,x);
+  return sp_level_schedule_solve(schedule,
+                                 schedule->offsets,schedule->indicies,
+                                 schedule->positions,
+                                 self->values,0,1,b,x);
+}
+
+int sp_matrix_yale_lower_trans_solve_scheduled(sp_matrix_yale_ptr self,
+                                               sp_level_schedule_ptr schedule,
+                                               double* b,
+                                               double* x)
+{
+  /* rows of L^T are columns of L */
+  if (self->storage_type == CCS)
+    return sp_level_schedule_solve(schedule,
+                                   self->offsets,self->indicies,0,
+                                   self->values,0,0,b,x);
+  return sp_level_schedule_solve(schedule,
+                                 schedule->offsets,schedule->indicies,
+                                 schedule->positions,
+                                 self->values,0,0,b,x);
+}
+
+
 /*
  * Finds the symbolic Cholesky decomposition - portrait of the matrix L
  * for row/column storage type WITHOUT numeric values
  * using the given matrix and results of the premilinary symbolic analysis
+ * The CCS portrait is constructed row by row, then the CRS
+ * portrait is obtained by its transposition, so indicies are sorted
+ * in both portraits.
+ * Complexity: O(number of nonzeros in L)
  * 
  * Returns nonzero if succesfull 
  */
@@ -293,55 +746,65 @@ int sp_matrix_yale_chol_structure(sp_matrix_yale_ptr self,
 {
   int result = 1;
   int count,i,j,p,k;
-  int *offsets, *indicies;
-  offsets = spcalloc(self->rows_count + 1,sizeof(int));
-  symb->crs_indicies = spcalloc(symb->nonzeros,sizeof(int));
-  symb->ccs_indicies = spcalloc(symb->nonzeros,sizeof(int));
-  indicies = spcalloc(symb->nonzeros,sizeof(int));  
-  /* calculate offsets for CRS */
-  j = 0;
-  for (i = 0; i < self->rows_count; ++ i)
-  {
-    offsets[i] = j;
-    j += symb->rowcounts[i];
-  }
-  offsets[i] = symb->nonzeros;
-  symb->crs_offsets = memdup(offsets,(self->rows_count + 1)*sizeof(int));
-  /* calculate offsets for CCS */
-  j = 0;
-  for (i = 0; i < self->rows_count; ++ i)
+  int n = self->rows_count;
+  int *offsets, *indicies, *marker;
+  offsets = spalloc((n + 1)*sizeof(int));
+  marker = spalloc(n*sizeof(int));
+  indicies = spalloc(n*sizeof(int));
+  symb->crs_indicies = spalloc(symb->nonzeros*sizeof(int));
+  symb->ccs_indicies = spalloc(symb->nonzeros*sizeof(int));
+  symb->crs_offsets = spalloc((n + 1)*sizeof(int));
+  symb->ccs_offsets = spalloc((n + 1)*sizeof(int));
+  /* calculate offsets for CRS and CCS */
+  symb->crs_offsets[0] = symb->ccs_offsets[0] = 0;
+  for (i = 0; i < n; ++ i)
   {
-    offsets[i] = j;
-    j += symb->colcounts[i];
+    symb->crs_offsets[i+1] = symb->crs_offsets[i] + symb->rowcounts[i];
+    symb->ccs_offsets[i+1] = symb->ccs_offsets[i] + symb->colcounts[i];
+    marker[i] = -1;
   }
-  offsets[i] = symb->nonzeros;
-  symb->ccs_offsets = memdup(offsets,(self->rows_count + 1)*sizeof(int));
-  for (i = 0; i < self->rows_count; ++ i)
+  /* 1. CCS portrait: rows are appended to columns in ascending order */
+  memcpy(offsets,symb->ccs_offsets,(n + 1)*sizeof(int));
+  for (i = 0; i < n && result; ++ i)
   {
     /* ereach simply defines the portrait of every i-th row */
-    count = sp_matrix_yale_ereach(self,symb->etree,i,indicies);
-    if (count != symb->crs_offsets[i+1]-symb->crs_offsets[i])
+    count = sp_matrix_yale_ereach_marked(self,symb->etree,i,marker,indicies);
+    if (count != symb->rowcounts[i])
     {
       LOGERROR("sp_matrix_yale_chol_structure: count = %d, expected: %d."
                " Possibly not symmetric matrix",
-               count,symb->crs_offsets[i+1]-symb->crs_offsets[i]);
-      spfree(offsets);
-      spfree(indicies);
-      return 0;
+               count,symb->rowcounts[i]);
+      result = 0;
+      break;
     }
     /* so, a_ij != 0 where j in indicies array */
     for ( p = 0; p < count; ++ p)
     {
       j = indicies[p];
       /* a_ij != 0  */
-      /* algoritm is the same as in sp_matrix_yale_transpose */
-      k = offsets[j]++;
-      /* FIXME: overflow here on fea_big.mtx */
-      symb->ccs_indicies[k] = i;
+      if (offsets[j] == symb->ccs_offsets[j+1])
+      {
+        LOGERROR("sp_matrix_yale_chol_structure: column %d overflow."
+                 " Possibly not symmetric matrix",j);
+        result = 0;
+        break;
+      }
+      symb->ccs_indicies[offsets[j]++] = i;
     }
-    memcpy(symb->crs_indicies+symb->crs_offsets[i],indicies,count*sizeof(int));
+  }
+  /* 2. CRS portrait by the transposition of CCS */
+  if (result)
+  {
+    memcpy(offsets,symb->crs_offsets,(n + 1)*sizeof(int));
+    for (j = 0; j < n; ++ j)
+      for (p = symb->ccs_offsets[j]; p < symb->ccs_offsets[j+1]; ++ p)
+      {
+        k = offsets[symb->ccs_indicies[p]]++;
+        symb->crs_indicies[k] = j;
+      }
   }
   spfree(offsets);
+  spfree(marker);
   spfree(indicies);
   return result;
 }
@@ -360,14 +823,15 @@ int sp_matrix_yale_chol_symbolic(sp_matrix_yale_ptr self,
       symb->etree = spalloc(self->rows_count*sizeof(int));
       result = sp_matrix_yale_etree(self,symb->etree);
       _SYMB_VERIFY(result);
+      symb->post = spalloc(self->rows_count*sizeof(int));
+      tree_postorder_perm(symb->etree,self->rows_count,symb->post);
       symb->rowcounts = spalloc(self->rows_count*sizeof(int));
       symb->colcounts = spalloc(self->rows_count*sizeof(int));
-      result = sp_matrix_yale_chol_counts(self,symb->etree,
-                                          symb->rowcounts,
-                                          symb->colcounts);
+      result = sp_matrix_yale_chol_counts_post(self,symb->etree,
+                                               symb->post,
+                                               symb->rowcounts,
+                                               symb->colcounts);
       _SYMB_VERIFY(result);
-      symb->post = spalloc(self->rows_count*sizeof(int));
-      tree_postorder_perm(symb->etree,self->rows_count,symb->post);
       /* calculate nonzeros */
       for (i = 0; i < self->rows_count; ++ i)
       {
@@ -380,14 +844,56 @@ int sp_matrix_yale_chol_symbolic(sp_matrix_yale_ptr self,
   return result;
 }
 
+int sp_matrix_yale_chol_symbolic_ordered(sp_matrix_yale_ptr self,
+                                         sp_chol_symbolic_ptr symb,
+                                         sp_ordering_type ordering)
+{
+  int result = 0;
+  int n;
+  int *perm, *pinv;
+  sp_matrix_yale permuted;
+  if (ordering == ORDER_NATURAL)
+    return sp_matrix_yale_chol_symbolic(self,symb);
+  if (!self || !symb)
+    return 0;
+  n = self->rows_count;
+  perm = spalloc(n*sizeof(int));
+  if (!sp_matrix_yale_ordering(self,ordering,perm))
+  {
+    spfree(perm);
+    return 0;
+  }
+  pinv = spalloc(n*sizeof(int));
+  sp_perm_inverse(perm,n,pinv);
+  /* symbolic analysis of the reordered matrix PAP' */
+  sp_matrix_yale_permute(self,&permuted,pinv,pinv);
+  result = sp_matrix_yale_chol_symbolic(&permuted,symb);
+  sp_matrix_yale_free(&permuted);
+  if (result)
+  {
+    symb->perm = perm;
+    symb->pinv = pinv;
+  }
+  else
+  {
+    spfree(perm);
+    spfree(pinv);
+  }
+  return result;
+}
+
 void sp_matrix_yale_symbolic_free(sp_chol_symbolic_ptr symb)
 {
   if (symb)
   {
-    spfree(symb->etree);
-    spfree(symb->post);
-    spfree(symb->rowcounts);
-    spfree(symb->colcounts);
+    if (symb->etree)
+      spfree(symb->etree);
+    if (symb->post)
+      spfree(symb->post);
+    if (symb->rowcounts)
+      spfree(symb->rowcounts);
+    if (symb->colcounts)
+      spfree(symb->colcounts);
     if (symb->crs_indicies)
       spfree(symb->crs_indicies);
     if (symb->crs_offsets)
@@ -396,6 +902,10 @@ void sp_matrix_yale_symbolic_free(sp_chol_symbolic_ptr symb)
       spfree(symb->ccs_indicies);
     if (symb->ccs_offsets)
       spfree(symb->ccs_offsets);
+    if (symb->perm)
+      spfree(symb->perm);
+    if (symb->pinv)
+      spfree(symb->pinv);
     symb->nonzeros = 0;
     symb->etree = 0;
     symb->post = 0;
@@ -405,7 +915,63 @@ void sp_matrix_yale_symbolic_free(sp_chol_symbolic_ptr symb)
     symb->crs_indicies = 0;
     symb->ccs_offsets = 0;
     symb->ccs_indicies = 0;
+    symb->perm = 0;
+    symb->pinv = 0;
+  }
+}
+
+
+void sp_matrix_yale_chol_estimate(sp_matrix_yale_ptr self,
+                                  sp_chol_symbolic_ptr symb,
+                                  double flops_rate,
+                                  sp_chol_estimate_ptr estimate)
+{
+  int j;
+  double n = self->rows_count;
+  double a = self->nonzeros;
+  double l = symb->nonzeros;
+  double c;
+  memset(estimate,0,sizeof(sp_chol_estimate));
+  if (flops_rate <= 0)
+    flops_rate = SP_CHOL_FLOPS_RATE;
+  /* values, row indicies and column offsets of L */
+  estimate->factor_bytes = (size_t)(l*(sizeof(double)+sizeof(int)) +
+                                    (n+1)*sizeof(int));
+  /*
+   * kept by sp_chol_factor besides L: symbolic analysis (6 arrays of
+   * rows_count elements, CRS and CCS portraits of L), reordered matrix
+   * C, the map of A to C, the portrait of A, the level schedule of L
+   * (the transposed portrait with positions) and vector workspaces
+   */
+  estimate->resident_bytes = (size_t)
+    ((6*n + 2*(l+n+1))*sizeof(int) +
+     a*(sizeof(double)+sizeof(int)) + (n+1)*sizeof(int) +
+     a*sizeof(int) +
+     (a + n+1)*sizeof(int) +
+     (2*l + 3*n + 2)*sizeof(int) +
+     (n+1 + n)*sizeof(int) + n*sizeof(char) +
+     (2 + SP_CHOL_BLOCK_RHS)*n*sizeof(double));
+  /*
+   * sp_chol_mixed: the same workspaces, the portrait of L, single
+   * precision values and 4 more vectors
+   */
+  estimate->mixed_bytes = estimate->resident_bytes +
+    (size_t)(l*(sizeof(float)+sizeof(int)) + (n+1)*sizeof(int) +
+             n*sizeof(float) + 3*n*sizeof(double));
+  /* sum of squares of column counts */
+  for (j = 0; j < self->rows_count; ++ j)
+  {
+    c = symb->colcounts[j];
+    estimate->flops += c*c;
   }
+  /* multiplication and addition per element of L in both solves */
+  estimate->solve_flops = 4*l;
+  estimate->time_numeric = estimate->flops/flops_rate;
+  /* LDL' has the same number of operations as LL' */
+  estimate->time_ldl = estimate->time_numeric;
+  /* single precision operations are twice cheaper */
+  estimate->time_mixed = estimate->time_numeric/2;
+  estimate->time_solve = estimate->solve_flops/flops_rate;
 }
 
 /*
@@ -463,39 +1029,56 @@ static int sp_matrix_yale_sparse_lower_solve(sp_matrix_yale_ptr self,
 }
 
 
-int sp_matrix_yale_chol_numeric(sp_matrix_yale_ptr self,
-                                sp_chol_symbolic_ptr symb,
-                                sp_matrix_yale_ptr L)
+/*
+ * Allocates the Cholesky factor L with the structure
+ * defined by the symbolic analysis symb
+ */
+static void sp_matrix_yale_chol_init_factor(sp_chol_symbolic_ptr symb,
+                                            int n,
+                                            sp_matrix_yale_ptr L)
+{
+  L->storage_type = CCS;
+  L->rows_count = n;
+  L->cols_count = n;
+  L->nonzeros = symb->nonzeros;
+  L->offsets =  memdup(symb->ccs_offsets,(n+1)*sizeof(int));
+  L->indicies = memdup(symb->ccs_indicies,symb->nonzeros*sizeof(int));
+  L->values = spcalloc(symb->nonzeros,sizeof(double));
+}
+
+/*
+ * Numeric Cholesky decomposition of the matrix self
+ * without taking into account the ordering.
+ * L shall be already allocated with the structure from symb,
+ * its values are overwritten.
+ * Doesn't allocate memory:
+ * x - workspace of rows_count elements
+ * offsets - workspace of rows_count+1 elements
+ */
+static int sp_matrix_yale_chol_numeric_kernel(sp_matrix_yale_ptr self,
+                                              sp_chol_symbolic_ptr symb,
+                                              sp_matrix_yale_ptr L,
+                                              double* x,
+                                              int* offsets)
 {
   int result = 1;
   int i,j,p;
   int k = 0;
-  int* offsets;
-  double* x;
   int* rowoffsets;
   double value;
   double v,A_kk;
-  if (!self || !symb || !L || self->storage_type != CCS)
-    return 0;
-  /* initialize L */
-  L->storage_type = CCS;
-  L->rows_count = self->rows_count;
-  L->cols_count = self->cols_count;
-  L->nonzeros = symb->nonzeros;
-  L->offsets =  memdup(symb->ccs_offsets,(self->rows_count+1)*sizeof(int));
-  L->indicies = memdup(symb->ccs_indicies,symb->nonzeros*sizeof(int));
-  L->values = spcalloc(symb->nonzeros,sizeof(double));
   /* store offsets */
-  offsets = memdup(symb->ccs_offsets,(self->rows_count+1)*sizeof(int));
-  /* right-part vector */
-  x = spcalloc(self->rows_count,sizeof(double));
-#define _SP_CHOL_STOP {sp_matrix_yale_free(L);spfree(offsets);spfree(x);\
+  memcpy(offsets,symb->ccs_offsets,(self->rows_count+1)*sizeof(int));
+  /*
+   * x is cleared only once: after every row only its portrait is reset
+   */
+  memset(x,0,self->rows_count*sizeof(double));
+#define _SP_CHOL_STOP {                                         \
     LOGERROR("Cholesky decomposition: error in %d row",k);return 0;}
   /* up-looking Cholesky */
   /* loop by rows, constructing one k-th row at a time */
   for (k = 0; k < self->rows_count; ++ k)
   {
-    memset(x,0,self->rows_count*sizeof(double));
     v = 0;
     /*
      * construct the scattered vector x, containing nonzeros
@@ -523,6 +1106,8 @@ int sp_matrix_yale_chol_numeric(sp_matrix_yale_ptr self,
       i = offsets[j];
       L->values[i] = x[j];
       offsets[j]++;
+      /* clear the scattered vector */
+      x[j] = 0;
     }
     value = A_kk-v;
     if (value < 0)
@@ -530,9 +1115,49 @@ int sp_matrix_yale_chol_numeric(sp_matrix_yale_ptr self,
     L->values[L->offsets[k]] = sqrt(value);
     offsets[k]++;
   }
+#undef _SP_CHOL_STOP
+  return result;
+}
+
+/*
+ * Numeric Cholesky decomposition of the matrix self
+ * without taking into account the ordering
+ */
+static int sp_matrix_yale_chol_numeric_natural(sp_matrix_yale_ptr self,
+                                               sp_chol_symbolic_ptr symb,
+                                               sp_matrix_yale_ptr L)
+{
+  int result;
+  int* offsets;
+  double* x;
+  if (!self || !symb || !L || self->storage_type != CCS)
+    return 0;
+  /* initialize L */
+  sp_matrix_yale_chol_init_factor(symb,self->rows_count,L);
+  /* workspaces: column offsets and right-part vector */
+  offsets = spalloc((self->rows_count+1)*sizeof(int));
+  x = spalloc(self->rows_count*sizeof(double));
+  result = sp_matrix_yale_chol_numeric_kernel(self,symb,L,x,offsets);
+  if (!result)
+    sp_matrix_yale_free(L);
   spfree(x);
   spfree(offsets);
-#undef SP_CHOL_STOP
+  return result;
+}
+
+int sp_matrix_yale_chol_numeric(sp_matrix_yale_ptr self,
+                                sp_chol_symbolic_ptr symb,
+                                sp_matrix_yale_ptr L)
+{
+  int result;
+  sp_matrix_yale permuted;
+  if (!self || !symb || !L)
+    return 0;
+  if (!symb->pinv)
+    return sp_matrix_yale_chol_numeric_natural(self,symb,L);
+  sp_matrix_yale_permute(self,&permuted,symb->pinv,symb->pinv);
+  result = sp_matrix_yale_chol_numeric_natural(&permuted,symb,L);
+  sp_matrix_yale_free(&permuted);
   return result;
 }
 
@@ -559,11 +1184,25 @@ int sp_matrix_yale_chol_symbolic_solve(sp_matrix_yale_ptr self,
                                        double* x)
 {
   int result = 0;
+  int n = self->rows_count;
+  double *pb, *px;
   sp_matrix_yale L;
   result = sp_matrix_yale_chol_numeric(self,symb,&L);
   if (result)
   {
-    result = sp_matrix_yale_chol_numeric_solve(&L,b,x);
+    if (symb->perm)
+    {
+      /* solve PAP'(Px) = Pb */
+      pb = spalloc(n*sizeof(double));
+      px = spalloc(n*sizeof(double));
+      sp_perm_vector(symb->perm,n,b,pb);
+      result = sp_matrix_yale_chol_numeric_solve(&L,pb,px);
+      sp_perm_inverse_vector(symb->perm,n,px,x);
+      spfree(pb);
+      spfree(px);
+    }
+    else
+      result = sp_matrix_yale_chol_numeric_solve(&L,b,x);
     sp_matrix_yale_free(&L);
   }
   return result;
@@ -593,3 +1232,1784 @@ int sp_matrix_yale_chol_numeric_solve(sp_matrix_yale_ptr L,
   spfree(y);
   return result;
 }
+
+
+/*
+ * Finds the ordering and the symbolic analysis of the matrix A for the
+ * decomposition object and allocates the factor and workspaces without
+ * the numeric decomposition
+ * Returns nonzero if successfull
+ */
+static int sp_chol_factor_analyse(sp_chol_factor_ptr self,
+                                  sp_matrix_yale_ptr A,
+                                  sp_ordering_type ordering)
+{
+  int result = 0;
+  int n,p;
+  int *perm, *pinv;
+  sp_matrix_yale positions;
+  if (!self || !A || A->rows_count != A->cols_count)
+    return 0;
+  memset(self,0,sizeof(sp_chol_factor));
+  n = A->rows_count;
+  /* fill-reducing ordering */
+  perm = spalloc(n*sizeof(int));
+  if (!sp_matrix_yale_ordering(A,ordering,perm))
+  {
+    spfree(perm);
+    return 0;
+  }
+  pinv = spalloc(n*sizeof(int));
+  sp_perm_inverse(perm,n,pinv);
+  /*
+   * permute the matrix with positions of elements instead of values
+   * to find where the every element of A goes in C = PAP'
+   */
+  positions = *A;
+  positions.values = spalloc(A->nonzeros*sizeof(double));
+  for (p = 0; p < A->nonzeros; ++ p)
+    positions.values[p] = p;
+  sp_matrix_yale_permute(&positions,&self->C,pinv,pinv);
+  spfree(positions.values);
+  /*
+   * arrays of the symmetric matrix in CRS format are the same
+   * as in CCS format
+   */
+  self->C.storage_type = CCS;
+  self->amap = spalloc(A->nonzeros*sizeof(int));
+  for (p = 0; p < A->nonzeros; ++ p)
+    self->amap[(int)self->C.values[p]] = p;
+  /* store the portrait of A to verify it on refactorization */
+  self->storage_type = A->storage_type;
+  self->offsets = memdup(A->offsets,(n+1)*sizeof(int));
+  self->indicies = memdup(A->indicies,A->nonzeros*sizeof(int));
+  /* symbolic analysis */
+  if (sp_matrix_yale_chol_symbolic(&self->C,&self->symb))
+  {
+    if (ordering != ORDER_NATURAL)
+    {
+      self->symb.perm = perm;
+      self->symb.pinv = pinv;
+    }
+    else
+    {
+      spfree(perm);
+      spfree(pinv);
+    }
+    sp_matrix_yale_chol_init_factor(&self->symb,n,&self->L);
+    self->workspace = spalloc((n+1)*sizeof(int));
+    self->x = spalloc(n*sizeof(double));
+    self->y = spalloc(n*sizeof(double));
+    self->block = spalloc(n*SP_CHOL_BLOCK_RHS*sizeof(double));
+    self->reach = spalloc(n*sizeof(int));
+    self->marker = spcalloc(n,sizeof(char));
+    result = sp_level_schedule_init(&self->schedule,n,
+                                    self->L.offsets,self->L.indicies,CCS);
+  }
+  else
+  {
+    spfree(perm);
+    spfree(pinv);
+    /* free only parts initialized */
+    sp_matrix_yale_free(&self->C);
+    spfree(self->amap);
+    spfree(self->offsets);
+    spfree(self->indicies);
+    memset(self,0,sizeof(sp_chol_factor));
+  }
+  return result;
+}
+
+int sp_chol_factor_init(sp_chol_factor_ptr self,
+                        sp_matrix_yale_ptr A,
+                        sp_ordering_type ordering)
+{
+  if (!sp_chol_factor_analyse(self,A,ordering))
+    return 0;
+  if (!sp_chol_factor_refactor(self,A))
+  {
+    sp_chol_factor_free(self);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * Verifies what the portrait of the matrix A is the same as in
+ * decomposition object and scatters values of A to C = PAP'
+ * Returns nonzero if successfull
+ */
+static int sp_chol_factor_scatter(sp_chol_factor_ptr self,
+                                  sp_matrix_yale_ptr A)
+{
+  int p;
+  int n = self->L.rows_count;
+  int nonzeros = self->C.nonzeros;
+  /* verify the portrait */
+  if (A->storage_type != self->storage_type ||
+      A->rows_count != n || A->cols_count != n ||
+      A->nonzeros != nonzeros ||
+      memcmp(A->offsets,self->offsets,(n+1)*sizeof(int)) ||
+      memcmp(A->indicies,self->indicies,nonzeros*sizeof(int)))
+  {
+    LOGERROR("Refactorization: matrix portrait differs from"
+             " the portrait used in symbolic analysis");
+    return 0;
+  }
+  /* scatter values of A to C = PAP' */
+  for (p = 0; p < nonzeros; ++ p)
+    self->C.values[self->amap[p]] = A->values[p];
+  return 1;
+}
+
+int sp_chol_factor_refactor(sp_chol_factor_ptr self,
+                            sp_matrix_yale_ptr A)
+{
+  int n = self->L.rows_count;
+  if (!sp_chol_factor_scatter(self,A))
+    return 0;
+  /*
+   * portrait of L was extended by sp_chol_factor_updown: the extended
+   * portrait contains the symbolic one, so it fits into the arrays of L
+   */
+  if (self->L.nonzeros != self->symb.nonzeros)
+  {
+    memcpy(self->L.offsets,self->symb.ccs_offsets,(n+1)*sizeof(int));
+    memcpy(self->L.indicies,self->symb.ccs_indicies,
+           self->symb.nonzeros*sizeof(int));
+    self->L.nonzeros = self->symb.nonzeros;
+    sp_level_schedule_free(&self->schedule);
+    self->schedule = self->symb_schedule;
+    memset(&self->symb_schedule,0,sizeof(sp_level_schedule));
+  }
+  return sp_matrix_yale_chol_numeric_kernel(&self->C,&self->symb,&self->L,
+                                            self->x,self->workspace);
+}
+
+int sp_chol_factor_solve(sp_chol_factor_ptr self,
+                         double* b,
+                         double* x)
+{
+  int result;
+  int n = self->L.rows_count;
+  if (!self->symb.perm)
+  {
+    /* Ly=b, L'x=y */
+    result =
+      sp_matrix_yale_lower_solve_scheduled(&self->L,&self->schedule,
+                                           b,self->y) &&
+      sp_matrix_yale_lower_trans_solve_scheduled(&self->L,&self->schedule,
+                                                 self->y,x);
+  }
+  else
+  {
+    /* PAP'(Px) = Pb */
+    sp_perm_vector(self->symb.perm,n,b,self->x);
+    result =
+      sp_matrix_yale_lower_solve_scheduled(&self->L,&self->schedule,
+                                           self->x,self->y) &&
+      sp_matrix_yale_lower_trans_solve_scheduled(&self->L,&self->schedule,
+                                                 self->y,self->x);
+    if (result)
+      sp_perm_inverse_vector(self->symb.perm,n,self->x,x);
+  }
+  return result;
+}
+
+int sp_chol_factor_solve_block(sp_chol_factor_ptr self,
+                               int nrhs,
+                               double* B,
+                               double* X)
+{
+  int result = 1;
+  int first,kb,i,r;
+  int n = self->L.rows_count;
+  int* perm = self->symb.perm;
+  sp_matrix_yale_ptr L = &self->L;
+  sp_level_schedule_ptr schedule = &self->schedule;
+  double* w = self->block;
+  for (first = 0; first < nrhs && result; first += SP_CHOL_BLOCK_RHS)
+  {
+    kb = nrhs - first < SP_CHOL_BLOCK_RHS ? nrhs - first : SP_CHOL_BLOCK_RHS;
+    /*
+     * right-hand sides of the block are interleaved:
+     * w[i*kb + r] is the i-th element of the r-th vector
+     */
+    for (r = 0; r < kb; ++ r)
+      for (i = 0; i < n; ++ i)
+        w[i*kb + r] = B[(first + r)*n + (perm ? perm[i] : i)];
+    /* LY = W by rows of L, L'W = Y by columns of L */
+    if (L->storage_type == CRS)
+      result =
+        sp_level_schedule_solve_block(schedule,L->offsets,L->indicies,0,
+                                      L->values,1,kb,w) &&
+        sp_level_schedule_solve_block(schedule,schedule->offsets,
+                                      schedule->indicies,
+                                      schedule->positions,
+                                      L->values,0,kb,w);
+    else
+      result =
+        sp_level_schedule_solve_block(schedule,schedule->offsets,
+                                      schedule->indicies,
+                                      schedule->positions,
+                                      L->values,1,kb,w) &&
+        sp_level_schedule_solve_block(schedule,L->offsets,L->indicies,0,
+                                      L->values,0,kb,w);
+    if (result)
+      for (r = 0; r < kb; ++ r)
+        for (i = 0; i < n; ++ i)
+          X[(first + r)*n + (perm ? perm[i] : i)] = w[i*kb + r];
+  }
+  return result;
+}
+
+int sp_chol_factor_solve_sparse(sp_chol_factor_ptr self,
+                                int nonzeros,
+                                int* bi,
+                                double* bx,
+                                double* x)
+{
+  int i,j,k,p,count = 0;
+  int n = self->L.rows_count;
+  int* pinv = self->symb.pinv;
+  sp_matrix_yale_ptr L = &self->L;
+  double* y = self->y;
+  memset(y,0,n*sizeof(double));
+  /*
+   * nonzeros of L^{-1}b are on paths from nonzeros of b
+   * to the root in the elimination tree
+   */
+  for (k = 0; k < nonzeros; ++ k)
+  {
+    i = pinv ? pinv[bi[k]] : bi[k];
+    y[i] += bx[k];
+    /* parent is the first row below the diagonal in the column */
+    for (; i != -1 && !self->marker[i];
+         i = L->offsets[i]+1 < L->offsets[i+1] ?
+           L->indicies[L->offsets[i]+1] : -1)
+    {
+      self->marker[i] = 1;
+      self->reach[count++] = i;
+    }
+  }
+  /* parents have greater indicies, so ascending order is topological */
+  qsort(self->reach,count,sizeof(int),int_compare);
+  /* Ly = b by the reach */
+  for (k = 0; k < count; ++ k)
+  {
+    j = self->reach[k];
+    self->marker[j] = 0;
+    y[j] /= L->values[L->offsets[j]];
+    for (p = L->offsets[j]+1; p < L->offsets[j+1]; ++ p)
+      y[L->indicies[p]] -= L->values[p]*y[j];
+  }
+  /* L'x = y, the solution is dense */
+  if (!sp_matrix_yale_lower_trans_solve_scheduled(L,&self->schedule,y,
+                                                  self->x))
+    return 0;
+  if (self->symb.perm)
+    sp_perm_inverse_vector(self->symb.perm,n,self->x,x);
+  else
+    memcpy(x,self->x,n*sizeof(double));
+  return 1;
+}
+
+/*
+ * Extends the portrait of the Cholesky factor L to the portrait
+ * of the factor of LL' + WW'.
+ * Rows of every column of W are added to the column f of L, where f
+ * is the first row of the column of W; then new rows are propagated
+ * to the parent of f in the (changed) elimination tree and so on
+ * while columns receive new rows.
+ * New elements of L are zero, so L is still the factor of the same
+ * matrix.
+ * Returns the number of added elements
+ */
+static int sp_matrix_yale_chol_grow(sp_matrix_yale_ptr L,
+                                    sp_matrix_yale_ptr W)
+{
+  int c,j,p,q,r,f,size,grew;
+  int n = L->rows_count;
+  int count = 0, capacity = n;
+  int stamp = 0;
+  int *head, *next, *rows, *marker, *set, *offsets, *indicies;
+  double* values;
+  head = spalloc(n*sizeof(int));
+  marker = spalloc(n*sizeof(int));
+  set = spalloc(n*sizeof(int));
+  next = spalloc(capacity*sizeof(int));
+  rows = spalloc(capacity*sizeof(int));
+  for (j = 0; j < n; ++ j)
+  {
+    head[j] = -1;
+    marker[j] = -1;
+  }
+  /* added elements are stored in lists by columns: head, next, rows */
+  for (c = 0; c < W->cols_count; ++ c)
+  {
+    if (W->offsets[c] == W->offsets[c+1])
+      continue;
+    size = 0;
+    f = n;
+    for (p = W->offsets[c]; p < W->offsets[c+1]; ++ p)
+    {
+      set[size++] = W->indicies[p];
+      f = W->indicies[p] < f ? W->indicies[p] : f;
+    }
+    for (j = f; j != -1; )
+    {
+      /* mark the portrait of the column j */
+      stamp++;
+      for (p = L->offsets[j]; p < L->offsets[j+1]; ++ p)
+        marker[L->indicies[p]] = stamp;
+      for (q = head[j]; q != -1; q = next[q])
+        marker[rows[q]] = stamp;
+      /* add rows of the set below the diagonal */
+      grew = 0;
+      for (p = 0; p < size; ++ p)
+      {
+        r = set[p];
+        if (r > j && marker[r] != stamp)
+        {
+          if (count == capacity)
+          {
+            capacity *= 2;
+            next = sprealloc(next,capacity*sizeof(int));
+            rows = sprealloc(rows,capacity*sizeof(int));
+          }
+          marker[r] = stamp;
+          rows[count] = r;
+          next[count] = head[j];
+          head[j] = count++;
+          grew = 1;
+        }
+      }
+      /* the portrait of ancestors already includes the portrait of j */
+      if (!grew)
+        break;
+      /* propagate the portrait of the column to the parent */
+      size = 0;
+      for (p = L->offsets[j]+1; p < L->offsets[j+1]; ++ p)
+        set[size++] = L->indicies[p];
+      for (q = head[j]; q != -1; q = next[q])
+        set[size++] = rows[q];
+      for (f = n, p = 0; p < size; ++ p)
+        f = set[p] < f ? set[p] : f;
+      j = size ? f : -1;
+    }
+  }
+  if (count)
+  {
+    /* merge sorted columns of L with the sorted added rows */
+    offsets = spalloc((n+1)*sizeof(int));
+    indicies = spalloc((L->nonzeros+count)*sizeof(int));
+    values = spalloc((L->nonzeros+count)*sizeof(double));
+    offsets[0] = 0;
+    for (j = 0; j < n; ++ j)
+    {
+      size = 0;
+      for (q = head[j]; q != -1; q = next[q])
+        set[size++] = rows[q];
+      qsort(set,size,sizeof(int),int_compare);
+      r = offsets[j];
+      for (p = L->offsets[j], q = 0; p < L->offsets[j+1] || q < size; ++ r)
+      {
+        if (q == size || (p < L->offsets[j+1] && L->indicies[p] < set[q]))
+        {
+          indicies[r] = L->indicies[p];
+          values[r] = L->values[p++];
+        }
+        else
+        {
+          indicies[r] = set[q++];
+          values[r] = 0;
+        }
+      }
+      offsets[j+1] = r;
+    }
+    spfree(L->offsets);
+    spfree(L->indicies);
+    spfree(L->values);
+    L->offsets = offsets;
+    L->indicies = indicies;
+    L->values = values;
+    L->nonzeros += count;
+  }
+  spfree(head);
+  spfree(marker);
+  spfree(set);
+  spfree(next);
+  spfree(rows);
+  return count;
+}
+
+int sp_matrix_yale_chol_updown(sp_matrix_yale_ptr L,
+                               int sigma,
+                               sp_matrix_yale_ptr W)
+{
+  int result = 1;
+  int c,i,j,f,p;
+  int n = L->rows_count;
+  int* parent;
+  double *w;
+  double alpha,beta,beta2,delta,gamma,w1,w2;
+  if (L->storage_type != CCS || W->storage_type != CCS ||
+      W->rows_count != n || (sigma != 1 && sigma != -1))
+  {
+    LOGERROR("Cholesky update: wrong arguments");
+    return 0;
+  }
+  sp_matrix_yale_chol_grow(L,W);
+  /* elimination tree by the portrait of L */
+  parent = spalloc(n*sizeof(int));
+  w = spalloc(n*sizeof(double));
+  for (j = 0; j < n; ++ j)
+    parent[j] = L->offsets[j]+1 < L->offsets[j+1] ?
+      L->indicies[L->offsets[j]+1] : -1;
+  /* rank-1 update or downdate by every column of W */
+  for (c = 0; c < W->cols_count && result; ++ c)
+  {
+    if (W->offsets[c] == W->offsets[c+1])
+      continue;
+    f = n;
+    for (p = W->offsets[c]; p < W->offsets[c+1]; ++ p)
+      f = W->indicies[p] < f ? W->indicies[p] : f;
+    /* portrait of w is in the path from f to the root */
+    for (j = f; j != -1; j = parent[j])
+      w[j] = 0;
+    for (p = W->offsets[c]; p < W->offsets[c+1]; ++ p)
+      w[W->indicies[p]] = W->values[p];
+    beta = 1;
+    for (j = f; j != -1; j = parent[j])
+    {
+      p = L->offsets[j];
+      alpha = w[j]/L->values[p];
+      beta2 = beta*beta + sigma*alpha*alpha;
+      if (beta2 <= 0)
+      {
+        LOGERROR("Cholesky downdate: matrix is not positive definite");
+        result = 0;
+        break;
+      }
+      beta2 = sqrt(beta2);
+      delta = sigma > 0 ? beta/beta2 : beta2/beta;
+      gamma = sigma*alpha/(beta2*beta);
+      L->values[p] = delta*L->values[p] + (sigma > 0 ? gamma*w[j] : 0);
+      beta = beta2;
+      for (p++; p < L->offsets[j+1]; ++ p)
+      {
+        i = L->indicies[p];
+        w1 = w[i];
+        w[i] = w2 = w1 - alpha*L->values[p];
+        L->values[p] = delta*L->values[p] + gamma*(sigma > 0 ? w1 : w2);
+      }
+    }
+  }
+  spfree(parent);
+  spfree(w);
+  return result;
+}
+
+int sp_chol_factor_updown(sp_chol_factor_ptr self,
+                          int sigma,
+                          sp_matrix_yale_ptr W)
+{
+  int result,p;
+  int nonzeros = self->L.nonzeros;
+  int n = self->L.rows_count;
+  sp_matrix_yale permuted;
+  if (W->storage_type != CCS || W->rows_count != n)
+  {
+    LOGERROR("Cholesky update: wrong arguments");
+    return 0;
+  }
+  if (self->symb.pinv)
+  {
+    /* rows of W in terms of PAP' */
+    permuted = *W;
+    permuted.indicies = spalloc((W->nonzeros ? W->nonzeros : 1)*sizeof(int));
+    for (p = 0; p < W->nonzeros; ++ p)
+      permuted.indicies[p] = self->symb.pinv[W->indicies[p]];
+    result = sp_matrix_yale_chol_updown(&self->L,sigma,&permuted);
+    spfree(permuted.indicies);
+  }
+  else
+    result = sp_matrix_yale_chol_updown(&self->L,sigma,W);
+  /*
+   * the portrait of L has changed: update the level schedule keeping
+   * the schedule of the symbolic portrait for refactorizations
+   */
+  if (self->L.nonzeros != nonzeros)
+  {
+    if (self->symb_schedule.levels)
+      sp_level_schedule_free(&self->schedule);
+    else
+      self->symb_schedule = self->schedule;
+    sp_level_schedule_init(&self->schedule,n,
+                           self->L.offsets,self->L.indicies,CCS);
+  }
+  return result;
+}
+
+void sp_chol_factor_free(sp_chol_factor_ptr self)
+{
+  if (self)
+  {
+    sp_matrix_yale_symbolic_free(&self->symb);
+    sp_matrix_yale_free(&self->L);
+    sp_matrix_yale_free(&self->C);
+    spfree(self->offsets);
+    spfree(self->indicies);
+    spfree(self->amap);
+    spfree(self->workspace);
+    spfree(self->x);
+    spfree(self->y);
+    sp_level_schedule_free(&self->schedule);
+    sp_level_schedule_free(&self->symb_schedule);
+    if (self->block) spfree(self->block);
+    if (self->reach) spfree(self->reach);
+    if (self->marker) spfree(self->marker);
+    memset(self,0,sizeof(sp_chol_factor));
+  }
+}
+
+
+/*
+ * Numeric LDL' decomposition of the matrix self
+ * without taking into account the ordering (up-looking).
+ * L shall be already allocated with the structure from symb,
+ * its values are overwritten; the unit diagonal of L is stored
+ * explicitly, so triangular solvers could be applied to L.
+ * Pivots less than tolerance by absolute value are replaced with
+ * +/-tolerance (static pivot perturbation), the number of
+ * perturbed pivots is stored to perturbed.
+ * Doesn't allocate memory:
+ * x - workspace of rows_count elements
+ * offsets - workspace of rows_count+1 elements
+ */
+static int sp_matrix_yale_ldl_numeric_kernel(sp_matrix_yale_ptr self,
+                                             sp_chol_symbolic_ptr symb,
+                                             sp_matrix_yale_ptr L,
+                                             double* D,
+                                             double tolerance,
+                                             int* perturbed,
+                                             double* x,
+                                             int* offsets)
+{
+  int i,j,k,p,q;
+  double d,y_j,l_kj;
+  memcpy(offsets,symb->ccs_offsets,(self->rows_count+1)*sizeof(int));
+  memset(x,0,self->rows_count*sizeof(double));
+  *perturbed = 0;
+  for (k = 0; k < self->rows_count; ++ k)
+  {
+    /* scatter A(1:k,k), the diagonal element could be absent */
+    d = 0;
+    for (p = self->offsets[k];
+         p < self->offsets[k+1] && (i = self->indicies[p]) <= k;
+         ++p)
+    {
+      if (i < k)
+        x[i] = self->values[p];
+      else
+        d = self->values[p];
+    }
+    /*
+     * solve L(1:k-1,1:k-1)*y = A(1:k-1,k) by the row portrait,
+     * then L(k,j) = y_j/d_j and d_k = a_kk - sum L(k,j)*y_j
+     * last element of the row portrait is the diagonal
+     */
+    for (p = symb->crs_offsets[k]; p < symb->crs_offsets[k+1]-1; ++p)
+    {
+      j = symb->crs_indicies[p];
+      y_j = x[j];
+      x[j] = 0;
+      /* elements of the column j already calculated are above k */
+      for (q = L->offsets[j]+1; q < offsets[j]; ++ q)
+        x[L->indicies[q]] -= L->values[q]*y_j;
+      l_kj = y_j/D[j];
+      d -= l_kj*y_j;
+      L->values[offsets[j]++] = l_kj;
+    }
+    if (fabs(d) < tolerance)
+    {
+      d = d < 0 ? -tolerance : tolerance;
+      (*perturbed)++;
+    }
+    if (d == 0)
+    {
+      LOGERROR("LDL' decomposition: zero pivot in %d row",k);
+      return 0;
+    }
+    D[k] = d;
+    L->values[offsets[k]++] = 1;
+  }
+  return 1;
+}
+
+int sp_ldl_factor_init(sp_ldl_factor_ptr self,
+                       sp_matrix_yale_ptr A,
+                       sp_ordering_type ordering)
+{
+  int n;
+  if (!self || !A)
+    return 0;
+  memset(self,0,sizeof(sp_ldl_factor));
+  if (!sp_chol_factor_analyse(&self->chol,A,ordering))
+    return 0;
+  n = A->rows_count;
+  self->D = spalloc(n*sizeof(double));
+  self->b = spalloc(n*sizeof(double));
+  self->r = spalloc(n*sizeof(double));
+  self->dx = spalloc(n*sizeof(double));
+  self->pivot_tolerance = SP_LDL_PIVOT_TOLERANCE;
+  self->refinement_steps = SP_LDL_REFINEMENT_STEPS;
+  if (!sp_ldl_factor_refactor(self,A))
+  {
+    sp_ldl_factor_free(self);
+    return 0;
+  }
+  return 1;
+}
+
+int sp_ldl_factor_refactor(sp_ldl_factor_ptr self,
+                           sp_matrix_yale_ptr A)
+{
+  int p;
+  double amax = 0;
+  sp_chol_factor_ptr chol = &self->chol;
+  if (!sp_chol_factor_scatter(chol,A))
+    return 0;
+  /* pivot threshold relative to the largest element of the matrix */
+  for (p = 0; p < chol->C.nonzeros; ++ p)
+    amax = FMAX(amax,fabs(chol->C.values[p]));
+  return sp_matrix_yale_ldl_numeric_kernel(&chol->C,&chol->symb,&chol->L,
+                                           self->D,
+                                           self->pivot_tolerance*amax,
+                                           &self->perturbed,
+                                           chol->x,chol->workspace);
+}
+
+/*
+ * Solves LDL'x = b with the decomposition of the reordered matrix
+ * using the workspace y of the Cholesky object
+ */
+static int sp_ldl_factor_apply(sp_ldl_factor_ptr self,
+                               double* b,
+                               double* x)
+{
+  int i;
+  sp_chol_factor_ptr chol = &self->chol;
+  if (!sp_matrix_yale_lower_solve_scheduled(&chol->L,&chol->schedule,
+                                            b,chol->y))
+    return 0;
+  for (i = 0; i < chol->L.rows_count; ++ i)
+    chol->y[i] /= self->D[i];
+  return sp_matrix_yale_lower_trans_solve_scheduled(&chol->L,
+                                                    &chol->schedule,
+                                                    chol->y,x);
+}
+
+int sp_ldl_factor_solve(sp_ldl_factor_ptr self,
+                        double* b,
+                        double* x)
+{
+  int i,step;
+  double bnorm,rnorm;
+  double rnorm_prev = DBL_MAX;
+  sp_chol_factor_ptr chol = &self->chol;
+  int n = chol->L.rows_count;
+  /* solve in terms of the reordered matrix: PAP'(Px) = Pb */
+  if (chol->symb.perm)
+    sp_perm_vector(chol->symb.perm,n,b,self->b);
+  else
+    memcpy(self->b,b,n*sizeof(double));
+  if (!sp_ldl_factor_apply(self,self->b,chol->x))
+    return 0;
+  /*
+   * iterative refinement to compensate perturbed pivots; the residual
+   * is evaluated after the last correction as well
+   */
+  bnorm = norm2(self->b,n);
+  for (step = 0; ; ++ step)
+  {
+    /* r = b - Cx */
+    sp_matrix_yale_mv(&chol->C,chol->x,self->r);
+    for (i = 0; i < n; ++ i)
+      self->r[i] = self->b[i] - self->r[i];
+    rnorm = norm2(self->r,n);
+    self->residual = bnorm > 0 ? rnorm/bnorm : rnorm;
+    self->refinement_iterations = step;
+    self->converged = rnorm <= SP_LDL_REFINEMENT_TOLERANCE*bnorm;
+    if (self->converged || rnorm >= rnorm_prev ||
+        step >= self->refinement_steps)
+      break;
+    rnorm_prev = rnorm;
+    if (!sp_ldl_factor_apply(self,self->r,self->dx))
+      return 0;
+    for (i = 0; i < n; ++ i)
+      chol->x[i] += self->dx[i];
+  }
+  if (chol->symb.perm)
+    sp_perm_inverse_vector(chol->symb.perm,n,chol->x,x);
+  else
+    memcpy(x,chol->x,n*sizeof(double));
+  return 1;
+}
+
+void sp_ldl_factor_free(sp_ldl_factor_ptr self)
+{
+  if (self)
+  {
+    sp_chol_factor_free(&self->chol);
+    if (self->D) spfree(self->D);
+    if (self->b) spfree(self->b);
+    if (self->r) spfree(self->r);
+    if (self->dx) spfree(self->dx);
+    memset(self,0,sizeof(sp_ldl_factor));
+  }
+}
+
+int sp_matrix_yale_ldl_solve(sp_matrix_yale_ptr self,
+                             double* b,
+                             double* x)
+{
+  int result;
+  sp_ldl_factor ldl;
+  result = sp_ldl_factor_init(&ldl,self,ORDER_NESTED_DISSECTION);
+  if (result)
+  {
+    result = sp_ldl_factor_solve(&ldl,b,x);
+    sp_ldl_factor_free(&ldl);
+  }
+  return result;
+}
+
+
+/*
+ * Numeric Cholesky decomposition of the matrix self in single precision
+ * without taking into account the ordering (up-looking).
+ * Values of L are stored to values, the portrait is from symb.
+ * Doesn't allocate memory:
+ * x - workspace of rows_count elements
+ * offsets - workspace of rows_count+1 elements
+ */
+static int sp_matrix_yale_chol_numeric_kernel_float(sp_matrix_yale_ptr self,
+                                                    sp_chol_symbolic_ptr symb,
+                                                    float* values,
+                                                    float* x,
+                                                    int* offsets)
+{
+  int i,j,k,p,q;
+  int* Lp = symb->ccs_offsets, *Li = symb->ccs_indicies;
+  float v,A_kk;
+  memcpy(offsets,Lp,(self->rows_count+1)*sizeof(int));
+  memset(x,0,self->rows_count*sizeof(float));
+  for (k = 0; k < self->rows_count; ++ k)
+  {
+    v = 0;
+    /* scatter A(1:k-1,k) */
+    for (p = self->offsets[k];
+         p < self->offsets[k+1] && self->indicies[p] < k;
+         ++p)
+      x[self->indicies[p]] = (float)self->values[p];
+    A_kk = (float)self->values[p];
+    /* solve L(1:k-1,1:k-1)*L(k,1:k-1)=A(1:k-1,k) by the row portrait */
+    for (p = symb->crs_offsets[k]; (j = symb->crs_indicies[p]) < k; ++ p)
+    {
+      x[j] /= values[Lp[j]];
+      for (q = Lp[j]+1; q < Lp[j+1] && (i = Li[q]) < k; ++ q)
+        x[i] -= values[q]*x[j];
+      v += x[j]*x[j];
+      /* store to the k-th row */
+      values[offsets[j]++] = x[j];
+      x[j] = 0;
+    }
+    A_kk -= v;
+    if (A_kk <= 0 || is_almost_zero(A_kk))
+    {
+      LOGERROR("Single precision Cholesky decomposition: error in %d row",k);
+      return 0;
+    }
+    values[Lp[k]] = sqrtf(A_kk);
+    offsets[k]++;
+  }
+  return 1;
+}
+
+/*
+ * Solves LL'x = b in single precision with L from the mixed
+ * precision decomposition object, b and x in double precision
+ */
+static void sp_chol_mixed_apply(sp_chol_mixed_ptr self,
+                                double* b,
+                                double* x)
+{
+  int i,j,p;
+  int n = self->chol.L.rows_count;
+  int* Lp = self->chol.L.offsets, *Li = self->chol.L.indicies;
+  float* values = self->values;
+  float* w = self->w;
+  for (i = 0; i < n; ++ i)
+    w[i] = (float)b[i];
+  /* Ly = b */
+  for (j = 0; j < n; ++ j)
+  {
+    w[j] /= values[Lp[j]];
+    for (p = Lp[j]+1; p < Lp[j+1]; ++ p)
+      w[Li[p]] -= values[p]*w[j];
+  }
+  /* L'x = y */
+  for (i = n-1; i >= 0; -- i)
+  {
+    for (p = Lp[i]+1; p < Lp[i+1]; ++ p)
+      w[i] -= values[p]*w[Li[p]];
+    w[i] /= values[Lp[i]];
+  }
+  for (i = 0; i < n; ++ i)
+    x[i] = w[i];
+}
+
+/*
+ * Switches the mixed precision decomposition object to the factor
+ * in double precision and performs the numeric decomposition
+ * Returns nonzero if successfull
+ */
+static int sp_chol_mixed_fallback(sp_chol_mixed_ptr self)
+{
+  sp_chol_factor_ptr chol = &self->chol;
+  if (self->values)
+  {
+    spfree(self->values);
+    self->values = 0;
+  }
+  if (!chol->L.values)
+    chol->L.values = spcalloc(chol->L.nonzeros,sizeof(double));
+  self->fallback = 1;
+  return sp_matrix_yale_chol_numeric_kernel(&chol->C,&chol->symb,&chol->L,
+                                            chol->x,chol->workspace);
+}
+
+int sp_chol_mixed_init(sp_chol_mixed_ptr self,
+                       sp_matrix_yale_ptr A,
+                       sp_ordering_type ordering,
+                       double tolerance)
+{
+  int n;
+  if (!self || !sp_chol_factor_analyse(&self->chol,A,ordering))
+    return 0;
+  n = A->rows_count;
+  /* factor in double precision is allocated only on fallback */
+  spfree(self->chol.L.values);
+  self->chol.L.values = 0;
+  self->values = spalloc(self->chol.L.nonzeros*sizeof(float));
+  self->w = spalloc(n*sizeof(float));
+  self->b = spalloc(n*sizeof(double));
+  self->r = spalloc(n*sizeof(double));
+  self->dx = spalloc(n*sizeof(double));
+  self->tolerance = tolerance;
+  self->refinement_steps = SP_CHOL_MIXED_REFINEMENT_STEPS;
+  self->iterations = 0;
+  self->fallback = 0;
+  if (!sp_chol_mixed_refactor(self,A))
+  {
+    sp_chol_mixed_free(self);
+    return 0;
+  }
+  return 1;
+}
+
+int sp_chol_mixed_refactor(sp_chol_mixed_ptr self,
+                           sp_matrix_yale_ptr A)
+{
+  sp_chol_factor_ptr chol = &self->chol;
+  if (!sp_chol_factor_scatter(chol,A))
+    return 0;
+  if (self->fallback)
+    return sp_matrix_yale_chol_numeric_kernel(&chol->C,&chol->symb,
+                                              &chol->L,chol->x,
+                                              chol->workspace);
+  /* matrix is too ill-conditioned for single precision */
+  if (!sp_matrix_yale_chol_numeric_kernel_float(&chol->C,&chol->symb,
+                                                self->values,self->w,
+                                                chol->workspace))
+    return sp_chol_mixed_fallback(self);
+  return 1;
+}
+
+int sp_chol_mixed_solve(sp_chol_mixed_ptr self,
+                        double* b,
+                        double* x)
+{
+  int i,step;
+  double bnorm,rnorm;
+  double rnorm_prev = DBL_MAX;
+  sp_chol_factor_ptr chol = &self->chol;
+  int n = chol->L.rows_count;
+  self->iterations = 0;
+  if (self->fallback)
+    return sp_chol_factor_solve(chol,b,x);
+  /* solve in terms of the reordered matrix: PAP'(Px) = Pb */
+  if (chol->symb.perm)
+    sp_perm_vector(chol->symb.perm,n,b,self->b);
+  else
+    memcpy(self->b,b,n*sizeof(double));
+  sp_chol_mixed_apply(self,self->b,chol->x);
+  bnorm = norm2(self->b,n);
+  for (step = 0; ; ++ step)
+  {
+    /* r = b - Cx in double precision */
+    sp_matrix_yale_mv(&chol->C,chol->x,self->r);
+    for (i = 0; i < n; ++ i)
+      self->r[i] = self->b[i] - self->r[i];
+    rnorm = norm2(self->r,n);
+    if (rnorm <= self->tolerance*bnorm)
+      break;
+    /* refinement stalls: factorize in double precision */
+    if (step == self->refinement_steps ||
+        rnorm*SP_CHOL_MIXED_STALL_RATIO > rnorm_prev)
+    {
+      LOGINFO("Mixed precision Cholesky: refinement stalled"
+              " with relative residual %e, fallback to double precision",
+              rnorm/bnorm);
+      return sp_chol_mixed_fallback(self) &&
+        sp_chol_factor_solve(chol,b,x);
+    }
+    rnorm_prev = rnorm;
+    sp_chol_mixed_apply(self,self->r,self->dx);
+    for (i = 0; i < n; ++ i)
+      chol->x[i] += self->dx[i];
+    self->iterations++;
+  }
+  if (chol->symb.perm)
+    sp_perm_inverse_vector(chol->symb.perm,n,chol->x,x);
+  else
+    memcpy(x,chol->x,n*sizeof(double));
+  return 1;
+}
+
+void sp_chol_mixed_free(sp_chol_mixed_ptr self)
+{
+  if (self)
+  {
+    sp_chol_factor_free(&self->chol);
+    if (self->values) spfree(self->values);
+    if (self->w) spfree(self->w);
+    if (self->b) spfree(self->b);
+    if (self->r) spfree(self->r);
+    if (self->dx) spfree(self->dx);
+    memset(self,0,sizeof(sp_chol_mixed));
+  }
+}
+
+
+int sp_matrix_yale_lu_symbolic(sp_matrix_yale_ptr self,
+                               sp_lu_symbolic_ptr symb,
+                               sp_ordering_type ordering)
+{
+  int n = self->rows_count;
+  memset(symb,0,sizeof(sp_lu_symbolic));
+  if (self->storage_type != CCS || n != self->cols_count)
+  {
+    LOGERROR("LU symbolic analysis: square matrix in CCS format expected");
+    return 0;
+  }
+  if (ordering != ORDER_NATURAL)
+  {
+    symb->q = spalloc(n*sizeof(int));
+    if (!sp_matrix_yale_ordering(self,ordering,symb->q))
+    {
+      spfree(symb->q);
+      symb->q = 0;
+      return 0;
+    }
+  }
+  symb->lnz = symb->unz = SP_LU_NONZEROS_FACTOR*self->nonzeros + n;
+  return 1;
+}
+
+void sp_matrix_yale_lu_symbolic_free(sp_lu_symbolic_ptr symb)
+{
+  if (symb)
+  {
+    if (symb->q) spfree(symb->q);
+    memset(symb,0,sizeof(sp_lu_symbolic));
+  }
+}
+
+/*
+ * Solves L*x = A(:,col) by the sparse right part, where L contains
+ * first columns of the factor, rows are in terms of A
+ * x - dense vector, shall be zero on entrance
+ * xi - workspace of 2*rows_count elements, the nonzero portrait
+ * of x is returned in xi[top..n-1] in the topological order
+ * returns top
+ */
+static int sp_lu_spsolve(sp_matrix_yale_ptr L,
+                         sp_matrix_yale_ptr A,
+                         int col,
+                         int* xi,
+                         double* x,
+                         int* pinv,
+                         int* marker,
+                         int stamp)
+{
+  int i,j,J,p,px;
+  int n = A->rows_count;
+  int top = n;
+  /* reach of the column in the graph of L */
+  for (p = A->offsets[col]; p < A->offsets[col+1]; ++ p)
+    if (marker[A->indicies[p]] != stamp)
+      top = sp_matrix_yale_dfs(L,A->indicies[p],top,xi,xi+n,pinv,
+                               marker,stamp);
+  /* scatter A(:,col) */
+  for (p = A->offsets[col]; p < A->offsets[col+1]; ++ p)
+    x[A->indicies[p]] = A->values[p];
+  for (px = top; px < n; ++ px)
+  {
+    j = xi[px];
+    J = pinv[j];
+    if (J < 0)
+      continue;
+    /* L has the unit diagonal, x_j is final: update the rest */
+    for (p = L->offsets[J]+1; p < L->offsets[J+1]; ++ p)
+    {
+      i = L->indicies[p];
+      x[i] -= L->values[p]*x[j];
+    }
+  }
+  return top;
+}
+
+/*
+ * Grows the factor L or U to keep at least size nonzeros
+ */
+static void sp_lu_grow(sp_matrix_yale_ptr F, int* nzmax, int size)
+{
+  if (size > *nzmax)
+  {
+    *nzmax = 2*(*nzmax) > size ? 2*(*nzmax) : size;
+    F->indicies = sprealloc(F->indicies,(*nzmax)*sizeof(int));
+    F->values = sprealloc(F->values,(*nzmax)*sizeof(double));
+  }
+}
+
+/*
+ * Left-looking LU decomposition with threshold partial pivoting
+ * (Gilbert-Peierls algorithm) of the matrix A(:,q) = P'LU
+ * L and U shall be allocated with lnz and unz nonzeros
+ */
+static int sp_lu_factor_numeric(sp_lu_factor_ptr self,
+                                sp_matrix_yale_ptr A)
+{
+  int i,k,p,top,col,ipiv;
+  int lnz = 0, unz = 0;
+  int n = A->rows_count;
+  int lnzmax = self->symb.lnz, unzmax = self->symb.unz;
+  int* q = self->symb.q;
+  double a,t,pivot;
+  sp_matrix_yale_ptr L = &self->L, U = &self->U;
+  int* marker = self->xi + 2*n;
+  for (i = 0; i < n; ++ i)
+  {
+    self->x[i] = 0;
+    self->pinv[i] = -1;
+    marker[i] = -1;
+  }
+  for (k = 0; k < n; ++ k)
+  {
+    L->offsets[k] = lnz;
+    U->offsets[k] = unz;
+    /* column k of L and U has at most n nonzeros */
+    sp_lu_grow(L,&lnzmax,lnz + n);
+    sp_lu_grow(U,&unzmax,unz + n);
+    col = q ? q[k] : k;
+    /* x = L\A(:,col) */
+    top = sp_lu_spsolve(L,A,col,self->xi,self->x,self->pinv,marker,k);
+    /* find the pivot among not pivotal rows, store U(:,k) */
+    ipiv = -1;
+    a = -1;
+    for (p = top; p < n; ++ p)
+    {
+      i = self->xi[p];
+      if (self->pinv[i] < 0)
+      {
+        if ((t = fabs(self->x[i])) > a)
+        {
+          a = t;
+          ipiv = i;
+        }
+      }
+      else
+      {
+        U->indicies[unz] = self->pinv[i];
+        U->values[unz++] = self->x[i];
+      }
+    }
+    if (ipiv == -1 || a <= 0)
+    {
+      LOGERROR("LU decomposition: matrix is singular in %d column",k);
+      return 0;
+    }
+    /* prefer the diagonal element if it is large enough */
+    if (self->pinv[col] < 0 && fabs(self->x[col]) >= a*self->tolerance)
+      ipiv = col;
+    pivot = self->x[ipiv];
+    U->indicies[unz] = k;
+    U->values[unz++] = pivot;
+    self->pinv[ipiv] = k;
+    L->indicies[lnz] = ipiv;
+    L->values[lnz++] = 1;
+    for (p = top; p < n; ++ p)
+    {
+      i = self->xi[p];
+      if (self->pinv[i] < 0)
+      {
+        L->indicies[lnz] = i;
+        L->values[lnz++] = self->x[i]/pivot;
+      }
+      self->x[i] = 0;
+    }
+  }
+  L->offsets[n] = lnz;
+  U->offsets[n] = unz;
+  /* row indicies of L in terms of PA */
+  for (p = 0; p < lnz; ++ p)
+    L->indicies[p] = self->pinv[L->indicies[p]];
+  /* remove extra space */
+  L->nonzeros = lnz;
+  U->nonzeros = unz;
+  L->indicies = sprealloc(L->indicies,(lnz ? lnz : 1)*sizeof(int));
+  L->values = sprealloc(L->values,(lnz ? lnz : 1)*sizeof(double));
+  U->indicies = sprealloc(U->indicies,(unz ? unz : 1)*sizeof(int));
+  U->values = sprealloc(U->values,(unz ? unz : 1)*sizeof(double));
+  return 1;
+}
+
+/*
+ * Allocates the matrix L or U for the LU decomposition
+ */
+static void sp_lu_init_factor(sp_matrix_yale_ptr F, int n, int nzmax)
+{
+  F->storage_type = CCS;
+  F->rows_count = n;
+  F->cols_count = n;
+  F->nonzeros = 0;
+  F->offsets = spalloc((n+1)*sizeof(int));
+  F->indicies = spalloc(nzmax*sizeof(int));
+  F->values = spalloc(nzmax*sizeof(double));
+}
+
+int sp_lu_factor_init(sp_lu_factor_ptr self,
+                      sp_matrix_yale_ptr A,
+                      sp_ordering_type ordering,
+                      double tolerance)
+{
+  int result;
+  int n;
+  if (!self || !A)
+    return 0;
+  memset(self,0,sizeof(sp_lu_factor));
+  if (!sp_matrix_yale_lu_symbolic(A,&self->symb,ordering))
+    return 0;
+  n = A->rows_count;
+  self->tolerance = tolerance;
+  sp_lu_init_factor(&self->L,n,self->symb.lnz);
+  sp_lu_init_factor(&self->U,n,self->symb.unz);
+  self->pinv = spalloc(n*sizeof(int));
+  self->xi = spalloc(3*n*sizeof(int));
+  self->x = spalloc(n*sizeof(double));
+  /* store the portrait of A to verify it on refactorization */
+  self->offsets = memdup(A->offsets,(n+1)*sizeof(int));
+  self->indicies = memdup(A->indicies,A->nonzeros*sizeof(int));
+  result = sp_lu_factor_numeric(self,A);
+  if (!result)
+    sp_lu_factor_free(self);
+  return result;
+}
+
+int sp_lu_factor_refactor(sp_lu_factor_ptr self,
+                          sp_matrix_yale_ptr A)
+{
+  int i,j,k,p,r,col;
+  double u_jk,pivot;
+  int n = self->L.rows_count;
+  int* q = self->symb.q;
+  sp_matrix_yale_ptr L = &self->L, U = &self->U;
+  double* x = self->x;
+  /* verify the portrait */
+  if (A->storage_type != CCS ||
+      A->rows_count != n || A->cols_count != n ||
+      A->offsets[n] != self->offsets[n] ||
+      memcmp(A->offsets,self->offsets,(n+1)*sizeof(int)) ||
+      memcmp(A->indicies,self->indicies,A->nonzeros*sizeof(int)))
+  {
+    LOGERROR("LU refactorization: matrix portrait differs from"
+             " the portrait used in decomposition");
+    return 0;
+  }
+  /*
+   * with the same pivots portraits of L and U are the same;
+   * U(:,k) is stored in the topological order, diagonal last
+   */
+  for (k = 0; k < n; ++ k)
+  {
+    col = q ? q[k] : k;
+    for (p = A->offsets[col]; p < A->offsets[col+1]; ++ p)
+      x[self->pinv[A->indicies[p]]] = A->values[p];
+    for (p = U->offsets[k]; p < U->offsets[k+1]-1; ++ p)
+    {
+      j = U->indicies[p];
+      u_jk = x[j];
+      x[j] = 0;
+      U->values[p] = u_jk;
+      for (r = L->offsets[j]+1; r < L->offsets[j+1]; ++ r)
+        x[L->indicies[r]] -= L->values[r]*u_jk;
+    }
+    pivot = x[k];
+    x[k] = 0;
+    if (pivot == 0)
+    {
+      LOGERROR("LU refactorization: zero pivot in %d column",k);
+      return 0;
+    }
+    U->values[U->offsets[k+1]-1] = pivot;
+    for (r = L->offsets[k]+1; r < L->offsets[k+1]; ++ r)
+    {
+      i = L->indicies[r];
+      L->values[r] = x[i]/pivot;
+      x[i] = 0;
+    }
+  }
+  return 1;
+}
+
+int sp_lu_factor_solve(sp_lu_factor_ptr self,
+                       double* b,
+                       double* x)
+{
+  int i,j,p;
+  int n = self->L.rows_count;
+  sp_matrix_yale_ptr L = &self->L, U = &self->U;
+  double* y = self->x;
+  /* y = Pb */
+  sp_perm_inverse_vector(self->pinv,n,b,y);
+  /* y = L\y, unit diagonal first */
+  for (j = 0; j < n; ++ j)
+    for (p = L->offsets[j]+1; p < L->offsets[j+1]; ++ p)
+      y[L->indicies[p]] -= L->values[p]*y[j];
+  /* y = U\y, diagonal last */
+  for (j = n-1; j >= 0; -- j)
+  {
+    y[j] /= U->values[U->offsets[j+1]-1];
+    for (p = U->offsets[j]; p < U->offsets[j+1]-1; ++ p)
+      y[U->indicies[p]] -= U->values[p]*y[j];
+  }
+  /* x = Qy */
+  if (self->symb.q)
+    sp_perm_inverse_vector(self->symb.q,n,y,x);
+  else
+    memcpy(x,y,n*sizeof(double));
+  /* keep the workspace zero for refactorization */
+  for (i = 0; i < n; ++ i)
+    y[i] = 0;
+  return 1;
+}
+
+void sp_lu_factor_free(sp_lu_factor_ptr self)
+{
+  if (self)
+  {
+    sp_matrix_yale_lu_symbolic_free(&self->symb);
+    sp_matrix_yale_free(&self->L);
+    sp_matrix_yale_free(&self->U);
+    if (self->pinv) spfree(self->pinv);
+    if (self->xi) spfree(self->xi);
+    if (self->x) spfree(self->x);
+    if (self->offsets) spfree(self->offsets);
+    if (self->indicies) spfree(self->indicies);
+    memset(self,0,sizeof(sp_lu_factor));
+  }
+}
+
+int sp_matrix_yale_lu_solve(sp_matrix_yale_ptr self,
+                            double* b,
+                            double* x)
+{
+  int result;
+  sp_lu_factor lu;
+  result = sp_lu_factor_init(&lu,self,ORDER_NESTED_DISSECTION,
+                             SP_LU_PIVOT_TOLERANCE);
+  if (result)
+  {
+    result = sp_lu_factor_solve(&lu,b,x);
+    sp_lu_factor_free(&lu);
+  }
+  return result;
+}
+
+
+/*
+ * Reads or writes values and row indicies of the panel of L from/to
+ * the scratch file. The panel starting at the position p of L is
+ * stored at p*(sizeof(double)+sizeof(int)): values, then row indicies
+ * Returns nonzero if successfull
+ */
+static int sp_chol_ooc_io(sp_chol_ooc_ptr self,
+                          int panel,
+                          double* values,
+                          int* rows,
+                          int write)
+{
+  int first = self->symb.ccs_offsets[self->panels[panel]];
+  size_t count = self->symb.ccs_offsets[self->panels[panel+1]] - first;
+  if (fseek(self->file,(long)first*(long)(sizeof(double)+sizeof(int)),
+            SEEK_SET) ||
+      (write ? fwrite(values,sizeof(double),count,self->file) :
+       fread(values,sizeof(double),count,self->file)) != count ||
+      (write ? fwrite(rows,sizeof(int),count,self->file) :
+       fread(rows,sizeof(int),count,self->file)) != count)
+  {
+    LOGERROR("Out-of-core Cholesky: unable to %s panel %d",
+             write ? "write" : "read", panel);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * Finds the panel containing the column j
+ */
+static int sp_chol_ooc_panel_of(sp_chol_ooc_ptr self, int j)
+{
+  int lo = 0, hi = self->panels_count;
+  while (hi - lo > 1)
+  {
+    int mid = lo + (hi - lo)/2;
+    if (self->panels[mid] <= j)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/*
+ * Constructs row indicies of the columns of the panel from row
+ * subtrees of the etree, so the portrait of L is never kept in memory
+ * at once. Rows of the panel are traversed completely to find the
+ * previous panels with columns updating this one (self->linked);
+ * rows below the panel jump over the columns of the previous panels
+ * by their first ancestors in the panel.
+ * Complexity: O(rows_count + nonzeros of C + nonzeros in rows of L
+ * of the panel)
+ * Returns nonzero if successfull
+ */
+static int sp_chol_ooc_structure(sp_chol_ooc_ptr self,
+                                 sp_matrix_yale_ptr C,
+                                 int panel)
+{
+  int i,j,k,p;
+  int n = C->rows_count;
+  int first = self->panels[panel], last = self->panels[panel+1];
+  int *Lp = self->symb.ccs_offsets, *etree = self->symb.etree;
+  int *marker = self->marker, *rows = self->rows;
+  /* pos: next free position in columns of the panel */
+  int *offsets = self->pos;
+  /* cursor: first ancestors in the panel or above of previous columns */
+  int *ancestor = self->cursor;
+  int base = Lp[first];
+  int result = 1;
+  for (j = first; j < last; ++ j)
+    offsets[j] = Lp[j];
+  for (k = first-1; k >= 0; -- k)
+  {
+    j = etree[k];
+    ancestor[k] = j == -1 || j >= first ? j : ancestor[j];
+  }
+  memset(self->linked,0,self->panels_count*sizeof(char));
+  for (i = first; i < n && result; ++ i)
+  {
+    if (i < last)
+    {
+      marker[i] = i;
+      rows[offsets[i]++ - base] = i;
+    }
+    for (p = C->offsets[i]; p < C->offsets[i+1] && result; ++ p)
+    {
+      k = C->indicies[p];
+      if (k >= i || k >= last)
+        continue;
+      if (i >= last && k < first)
+        k = ancestor[k];
+      for (j = k; j != -1 && j < i && j < last && marker[j] != i;
+           j = etree[j])
+      {
+        marker[j] = i;
+        if (j < first)
+          self->linked[sp_chol_ooc_panel_of(self,j)] = 1;
+        else if (offsets[j] == Lp[j+1])
+        {
+          LOGERROR("Out-of-core Cholesky: column %d overflow."
+                   " Possibly not symmetric matrix",j);
+          result = 0;
+          break;
+        }
+        else
+          rows[offsets[j]++ - base] = i;
+      }
+    }
+  }
+  /* stamps of rows below the panel will be used by the next panels */
+  for (j = first; j < last; ++ j)
+  {
+    marker[j] = -1;
+    if (result && offsets[j] != Lp[j+1])
+    {
+      LOGERROR("Out-of-core Cholesky: column %d underflow."
+               " Possibly not symmetric matrix",j);
+      result = 0;
+    }
+  }
+  return result;
+}
+
+/*
+ * Links the column k of L to the list of the row of its element
+ * in position p if the row is in the range [first,last);
+ * rows - row indicies of the panel of the column k starting at base
+ */
+#define _SP_OOC_LINK(k,p,rows,base)                                    \
+  if ((p) < Lp[(k)+1] && (rows)[(p)-(base)] < last)                    \
+  {                                                                    \
+    cursor[(k)] = (p);                                                 \
+    next[(k)] = head[(rows)[(p)-(base)]];                              \
+    head[(rows)[(p)-(base)]] = (k);                                    \
+  }
+
+/*
+ * Applies updates of the columns linked to the list of the column i
+ * of the current panel
+ * values, rows - values and row indicies of the columns linked,
+ * base - position of its first element in L
+ */
+static void sp_chol_ooc_update(sp_chol_ooc_ptr self,
+                               int i,
+                               int last,
+                               double* values,
+                               int* rows,
+                               int base)
+{
+  int k,p,t;
+  int *Lp = self->symb.ccs_offsets;
+  int *head = self->head, *next = self->next, *cursor = self->cursor;
+  int *pos = self->pos;
+  int panel_base = Lp[self->first];
+  double l_ik;
+  /* pos: positions of elements of the column i in panel values */
+  for (p = Lp[i]; p < Lp[i+1]; ++ p)
+    pos[self->rows[p - panel_base]] = p - panel_base;
+  k = head[i];
+  head[i] = -1;
+  while (k != -1)
+  {
+    int following = next[k];
+    t = cursor[k];
+    l_ik = values[t - base];
+    /* L(i:n,i) -= L(i:n,k)*L(i,k) */
+    for (p = t; p < Lp[k+1]; ++ p)
+      self->panel[pos[rows[p - base]]] -= values[p - base]*l_ik;
+    t++;
+    _SP_OOC_LINK(k,t,rows,base);
+    k = following;
+  }
+}
+
+/*
+ * Left-looking numeric Cholesky decomposition of the panel:
+ * the panel is updated by columns of the previous panels linked to
+ * it, streamed from the scratch file, then by its own columns
+ */
+static int sp_chol_ooc_panel(sp_chol_ooc_ptr self,
+                             sp_matrix_yale_ptr C,
+                             int panel)
+{
+  int i,j,k,p,q,stream_base;
+  int first = self->panels[panel], last = self->panels[panel+1];
+  int *Lp = self->symb.ccs_offsets, *rows = self->rows;
+  int *head = self->head, *next = self->next, *cursor = self->cursor;
+  int *pos = self->pos;
+  int base = Lp[first];
+  double d;
+  self->first = first;
+  if (!sp_chol_ooc_structure(self,C,panel))
+    return 0;
+  /* scatter the lower triangle of the columns of C */
+  memset(self->panel,0,(Lp[last]-base)*sizeof(double));
+  for (j = first; j < last; ++ j)
+  {
+    for (p = Lp[j]; p < Lp[j+1]; ++ p)
+      pos[rows[p - base]] = p - base;
+    for (p = C->offsets[j]; p < C->offsets[j+1]; ++ p)
+      if ((i = C->indicies[p]) >= j)
+        self->panel[pos[i]] = C->values[p];
+  }
+  for (j = first; j < last; ++ j)
+    head[j] = -1;
+  /* updates from the previous panels, which have links to this one */
+  for (q = 0; q < panel; ++ q)
+  {
+    if (!self->linked[q])
+      continue;
+    if (!sp_chol_ooc_io(self,q,self->stream,self->stream_rows,0))
+      return 0;
+    stream_base = Lp[self->panels[q]];
+    /* link columns by their first rows in the panel */
+    for (k = self->panels[q]; k < self->panels[q+1]; ++ k)
+    {
+      /* rows are sorted: binary search of the first row >= first */
+      int lo = Lp[k]+1, hi = Lp[k+1];
+      while (lo < hi)
+      {
+        int mid = lo + (hi - lo)/2;
+        if (self->stream_rows[mid - stream_base] < first)
+          lo = mid + 1;
+        else
+          hi = mid;
+      }
+      _SP_OOC_LINK(k,lo,self->stream_rows,stream_base);
+    }
+    for (i = first; i < last; ++ i)
+      if (head[i] != -1)
+        sp_chol_ooc_update(self,i,last,self->stream,self->stream_rows,
+                           stream_base);
+  }
+  /* updates inside the panel */
+  for (i = first; i < last; ++ i)
+  {
+    if (head[i] != -1)
+      sp_chol_ooc_update(self,i,last,self->panel,rows,base);
+    d = self->panel[Lp[i] - base];
+    if (d <= 0 || is_almost_zero(d))
+    {
+      LOGERROR("Out-of-core Cholesky: error in %d column",i);
+      return 0;
+    }
+    d = sqrt(d);
+    self->panel[Lp[i] - base] = d;
+    for (p = Lp[i]+1; p < Lp[i+1]; ++ p)
+      self->panel[p - base] /= d;
+    p = Lp[i]+1;
+    _SP_OOC_LINK(i,p,rows,base);
+  }
+  return sp_chol_ooc_io(self,panel,self->panel,rows,1);
+}
+#undef _SP_OOC_LINK
+
+int sp_chol_ooc_init(sp_chol_ooc_ptr self,
+                     sp_matrix_yale_ptr A,
+                     sp_ordering_type ordering,
+                     size_t budget,
+                     const char* filename)
+{
+  int result = 1;
+  int j,k,n,count,size = 0;
+  int* rowcounts;
+  size_t matrix = 0, analysis, fixed, panel_size;
+  sp_matrix_yale C;
+  if (!self || !A || A->rows_count != A->cols_count)
+    return 0;
+  memset(self,0,sizeof(sp_chol_ooc));
+  n = A->rows_count;
+  /*
+   * memory accounted in the budget:
+   * the reordered matrix C (if reordered) and during its construction
+   * the intermediate copy, ordering and transposition workspaces;
+   * during the decomposition arrays of rows_count elements: etree,
+   * column counts, offsets of L, ordering, panels, 5 integer
+   * workspaces, flags of linked panels and the vector of the solver
+   */
+  if (ordering != ORDER_NATURAL)
+    matrix = (size_t)(n+1)*sizeof(int) +
+      (size_t)A->nonzeros*(sizeof(int)+sizeof(double));
+  analysis = 2*matrix + (size_t)(4*n+1)*sizeof(int);
+  fixed = matrix + (size_t)(11*n+2)*sizeof(int) +
+    (size_t)n*(sizeof(char)+sizeof(double));
+  if (budget <= fixed || budget < analysis)
+  {
+    LOGERROR("Out-of-core Cholesky: budget %lu bytes is less than %lu bytes"
+             " of workspaces",(unsigned long)budget,
+             (unsigned long)(fixed > analysis ? fixed : analysis));
+    return 0;
+  }
+  /* reordered matrix */
+  C = *A;
+  if (ordering != ORDER_NATURAL)
+  {
+    self->symb.perm = spalloc(n*sizeof(int));
+    if (!sp_matrix_yale_ordering(A,ordering,self->symb.perm))
+    {
+      spfree(self->symb.perm);
+      self->symb.perm = 0;
+      return 0;
+    }
+    self->symb.pinv = spalloc(n*sizeof(int));
+    sp_perm_inverse(self->symb.perm,n,self->symb.pinv);
+    sp_matrix_yale_permute(A,&C,self->symb.pinv,self->symb.pinv);
+  }
+  /* symbolic analysis: column counts only, without the portrait of L */
+  self->symb.etree = spalloc(n*sizeof(int));
+  self->symb.colcounts = spalloc(n*sizeof(int));
+  rowcounts = spalloc(n*sizeof(int));
+  result = sp_matrix_yale_etree(&C,self->symb.etree) &&
+    sp_matrix_yale_chol_counts(&C,self->symb.etree,rowcounts,
+                               self->symb.colcounts);
+  spfree(rowcounts);
+  if (result)
+  {
+    self->symb.ccs_offsets = spalloc((n+1)*sizeof(int));
+    self->symb.ccs_offsets[0] = 0;
+    for (j = 0; j < n; ++ j)
+      self->symb.ccs_offsets[j+1] = self->symb.ccs_offsets[j] +
+        self->symb.colcounts[j];
+    self->symb.nonzeros = self->symb.ccs_offsets[n];
+    /*
+     * panels: consecutive columns with values and row indicies
+     * fitting in the half of the rest of the budget (another half is
+     * for the panel streamed from the file)
+     */
+    self->budget = budget;
+    panel_size = (budget - fixed)/2/(sizeof(double)+sizeof(int));
+    self->panels = spalloc((n+1)*sizeof(int));
+    self->panels[0] = 0;
+    for (j = 0, k = 0, count = 0; j < n && result; ++ j)
+    {
+      if ((size_t)self->symb.colcounts[j] > panel_size)
+      {
+        LOGERROR("Out-of-core Cholesky: %d elements of column %d exceed"
+                 " the half of the budget",self->symb.colcounts[j],j);
+        result = 0;
+        break;
+      }
+      if (count && (size_t)(count + self->symb.colcounts[j]) > panel_size)
+      {
+        self->panels[++k] = j;
+        size = count > size ? count : size;
+        count = 0;
+      }
+      count += self->symb.colcounts[j];
+    }
+    size = count > size ? count : size;
+    self->panels[++k] = n;
+    self->panels_count = k;
+  }
+  if (result)
+  {
+    self->file = filename ? fopen(filename,"w+b") : tmpfile();
+    if (!self->file)
+    {
+      LOGERROR("Out-of-core Cholesky: unable to create scratch file");
+      result = 0;
+    }
+    else if (filename)
+      self->filename = memdup(filename,strlen(filename)+1);
+  }
+  if (result)
+  {
+    self->panels = sprealloc(self->panels,(k+1)*sizeof(int));
+    self->panel = spalloc((size ? size : 1)*sizeof(double));
+    self->rows = spalloc((size ? size : 1)*sizeof(int));
+    self->stream = spalloc((size ? size : 1)*sizeof(double));
+    self->stream_rows = spalloc((size ? size : 1)*sizeof(int));
+    self->linked = spalloc(k*sizeof(char));
+    self->y = spalloc((n ? n : 1)*sizeof(double));
+    self->pos = spalloc((n ? n : 1)*sizeof(int));
+    self->head = spalloc((n ? n : 1)*sizeof(int));
+    self->next = spalloc((n ? n : 1)*sizeof(int));
+    self->cursor = spalloc((n ? n : 1)*sizeof(int));
+    self->marker = spalloc((n ? n : 1)*sizeof(int));
+    for (j = 0; j < n; ++ j)
+      self->marker[j] = -1;
+  }
+  /* factorize the reordered matrix panel by panel */
+  for (k = 0; k < self->panels_count && result; ++ k)
+    result = sp_chol_ooc_panel(self,&C,k);
+  if (C.offsets != A->offsets)
+    sp_matrix_yale_free(&C);
+  if (!result)
+    sp_chol_ooc_free(self);
+  return result;
+}
+
+int sp_chol_ooc_solve(sp_chol_ooc_ptr self,
+                      double* b,
+                      double* x)
+{
+  int i,j,k,p,base;
+  int n = self->panels[self->panels_count];
+  int *Lp = self->symb.ccs_offsets, *rows = self->rows;
+  double* y = self->y;
+  if (self->symb.perm)
+    sp_perm_vector(self->symb.perm,n,b,y);
+  else
+    memcpy(y,b,n*sizeof(double));
+  /* Ly = b: panels in the forward order */
+  for (k = 0; k < self->panels_count; ++ k)
+  {
+    if (!sp_chol_ooc_io(self,k,self->panel,rows,0))
+      return 0;
+    base = Lp[self->panels[k]];
+    for (j = self->panels[k]; j < self->panels[k+1]; ++ j)
+    {
+      y[j] /= self->panel[Lp[j] - base];
+      for (p = Lp[j]+1; p < Lp[j+1]; ++ p)
+        y[rows[p - base]] -= self->panel[p - base]*y[j];
+    }
+  }
+  /* L'x = y: panels in the backward order */
+  for (k = self->panels_count-1; k >= 0; -- k)
+  {
+    if (!sp_chol_ooc_io(self,k,self->panel,rows,0))
+      return 0;
+    base = Lp[self->panels[k]];
+    for (i = self->panels[k+1]-1; i >= self->panels[k]; -- i)
+    {
+      for (p = Lp[i]+1; p < Lp[i+1]; ++ p)
+        y[i] -= self->panel[p - base]*y[rows[p - base]];
+      y[i] /= self->panel[Lp[i] - base];
+    }
+  }
+  if (self->symb.perm)
+    sp_perm_inverse_vector(self->symb.perm,n,y,x);
+  else
+    memcpy(x,y,n*sizeof(double));
+  return 1;
+}
+
+void sp_chol_ooc_free(sp_chol_ooc_ptr self)
+{
+  if (self)
+  {
+    if (self->file)
+      fclose(self->file);
+    if (self->filename)
+    {
+      remove(self->filename);
+      spfree(self->filename);
+    }
+    sp_matrix_yale_symbolic_free(&self->symb);
+    if (self->panels) spfree(self->panels);
+    if (self->panel) spfree(self->panel);
+    if (self->rows) spfree(self->rows);
+    if (self->stream) spfree(self->stream);
+    if (self->stream_rows) spfree(self->stream_rows);
+    if (self->linked) spfree(self->linked);
+    if (self->y) spfree(self->y);
+    if (self->pos) spfree(self->pos);
+    if (self->head) spfree(self->head);
+    if (self->next) spfree(self->next);
+    if (self->cursor) spfree(self->cursor);
+    if (self->marker) spfree(self->marker);
+    memset(self,0,sizeof(sp_chol_ooc));
+  }
+}
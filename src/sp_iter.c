@@ -18,12 +18,20 @@
  along with libspmatrix.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-/* #include <stdlib.h> */
+#include <stdlib.h>
 #include <memory.h>
 #include <math.h>
 
 #include "sp_iter.h"
 #include "sp_mem.h"
+#include "sp_utils.h"
+#include "sp_log.h"
+
+/*
+ * Minimal size of vectors processed by vector kernels in parallel:
+ * smaller vectors don't pay off the synchronization of threads
+ */
+#define SP_ITER_PARALLEL_MIN 4096
 
 /*
  * Scalar product x*y
@@ -31,8 +39,9 @@
 inline static double prod(double* x, double* y, int size)
 {
   double r = 0;
-  int i = 0;
-  for ( ; i < size; ++ i)
+  int i;
+  SP_OMP(omp parallel for simd reduction(+:r) if(size > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < size; ++ i)
     r += x[i]*y[i];
   return r;
 }
@@ -43,19 +52,392 @@ inline static double prod(double* x, double* y, int size)
 inline static double norm2(double* x, int size)
 {
   double r = 0;
-  int i = 0;
-  for ( ; i < size; ++ i)
+  int i;
+  SP_OMP(omp parallel for simd reduction(+:r) if(size > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < size; ++ i)
     r += x[i]*x[i];
   return sqrt(r);
 }
 
+/*
+ * Matrix-vector multiplication y = A*x, rows of CRS matrices are
+ * calculated in parallel
+ */
+static void sp_iter_mv(sp_matrix_yale_ptr self, double* x, double* y)
+{
+  double sum;
+  int i,j;
+  if (self->storage_type != CRS)
+  {
+    sp_matrix_yale_mv(self,x,y);
+    return;
+  }
+  SP_OMP(omp parallel for private(i,j,sum)                       \
+         if(self->rows_count > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < self->rows_count; ++ i)
+  {
+    sum = 0;
+    for (j = self->offsets[i]; j < self->offsets[i+1]; ++ j)
+      sum += self->values[j]*x[self->indicies[j]];
+    y[i] = sum;
+  }
+}
 
-void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
+/*
+ * Fused matrix-vector multiplication y = A*p and the scalar
+ * product (p,A*p), saving a pass over p and y:
+ * for CRS matrices the product is accumulated while rows are
+ * calculated; for CCS matrices columns are scattered to y and
+ * (p,A*p) = (p,A'*p) is gathered from the same columns
+ * Returns (p,A*p)
+ */
+static double sp_iter_mv_dot(sp_matrix_yale_ptr self, double* p, double* y)
+{
+  double r = 0, sum;
+  int i,j;
+  if (self->storage_type == CCS)
+  {
+    memset(y,0,self->rows_count*sizeof(double));
+    for (j = 0; j < self->cols_count; ++ j)
+    {
+      sum = 0;
+      for (i = self->offsets[j]; i < self->offsets[j+1]; ++ i)
+      {
+        y[self->indicies[i]] += self->values[i]*p[j];
+        sum += self->values[i]*p[self->indicies[i]];
+      }
+      r += p[j]*sum;
+    }
+    return r;
+  }
+  SP_OMP(omp parallel for private(i,j,sum) reduction(+:r)        \
+         if(self->rows_count > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < self->rows_count; ++ i)
+  {
+    sum = 0;
+    for (j = self->offsets[i]; j < self->offsets[i+1]; ++ j)
+      sum += self->values[j]*p[self->indicies[j]];
+    y[i] = sum;
+    r += p[i]*sum;
+  }
+  return r;
+}
+
+/*
+ * Fused update of the solution and the residual in one sweep:
+ * x = x + alpha*p, r = r - alpha*q
+ * Returns (r,r) of the updated residual
+ */
+static double sp_iter_update_xr(double alpha,
+                                double* p,
+                                double* q,
+                                double* x,
+                                double* r,
+                                int size)
+{
+  double rr = 0;
+  int i;
+  SP_OMP(omp parallel for simd reduction(+:rr)                  \
+         if(size > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < size; ++ i)
+  {
+    x[i] += alpha*p[i];
+    r[i] -= alpha*q[i];
+    rr += r[i]*r[i];
+  }
+  return rr;
+}
+
+/*
+ * Update of the search direction p = z + beta*p
+ */
+static void sp_iter_update_p(double beta, double* z, double* p, int size)
+{
+  int i;
+  SP_OMP(omp parallel for simd if(size > SP_ITER_PARALLEL_MIN))
+  for (i = 0; i < size; ++ i)
+    p[i] = z[i] + beta*p[i];
+}
+
+/*
+ * Applies the preconditioner z = M^{-1}*r
+ * z = r if the preconditioner is not given
+ */
+static void sp_precond_solve(sp_preconditioner_ptr precond,
+                             double* r,
+                             double* z,
+                             int size)
+{
+  if (precond)
+    precond->apply(precond->state,r,z);
+  else
+    memcpy(z,r,size*sizeof(double));
+}
+
+/*
+ * Matrix-vector multiplication with the right preconditioner
+ * y = A*M^{-1}*x, z - workspace for M^{-1}*x
+ * y = A*x if the preconditioner is not given
+ */
+static void sp_precond_mv(sp_matrix_yale_ptr self,
+                          sp_preconditioner_ptr precond,
+                          double* x,
+                          double* z,
+                          double* y)
+{
+  if (precond)
+  {
+    precond->apply(precond->state,x,z);
+    sp_matrix_yale_mv(self,z,y);
+  }
+  else
+    sp_matrix_yale_mv(self,x,y);
+}
+
+/*
+ * Iterative solver context
+ */
+
+/* Maximal number of iterations in the default options */
+#define SP_ITER_DEFAULT_MAX_ITER 10000
+
+/* Dimension of the Krylov subspace of GMRES in the default options */
+#define SP_ITER_DEFAULT_RESTART 30
+
+static void sp_iter_cg(sp_iter_solver_ptr solver,
+                       sp_matrix_yale_ptr self,
+                       double* b,
+                       double* x0,
+                       double* x);
+static void sp_iter_pcg(sp_iter_solver_ptr solver,
+                        sp_matrix_yale_ptr self,
+                        sp_preconditioner_ptr precond,
+                        double* b,
+                        double* x0,
+                        double* x);
+static void sp_iter_pipecg(sp_iter_solver_ptr solver,
+                           sp_matrix_yale_ptr self,
+                           sp_preconditioner_ptr precond,
+                           double* b,
+                           double* x0,
+                           double* x);
+static void sp_iter_tfqmr(sp_iter_solver_ptr solver,
+                          sp_matrix_yale_ptr self,
+                          sp_preconditioner_ptr precond,
+                          double* b,
+                          double* x0,
+                          double* x);
+static void sp_iter_cgs(sp_iter_solver_ptr solver,
+                        sp_matrix_yale_ptr self,
+                        sp_preconditioner_ptr precond,
+                        double* b,
+                        double* x0,
+                        double* x);
+static void sp_iter_bicgstab(sp_iter_solver_ptr solver,
+                             sp_matrix_yale_ptr self,
+                             sp_preconditioner_ptr precond,
                              double* b,
                              double* x0,
-                             int* max_iter,
-                             double* tolerance,
-                             double* x)
+                             double* x);
+static void sp_iter_gmres(sp_iter_solver_ptr solver,
+                          sp_matrix_yale_ptr self,
+                          sp_preconditioner_ptr precond,
+                          double* b,
+                          double* x0,
+                          double* x);
+
+/* k-th workspace vector of the solver context */
+inline static double* sp_iter_vector(sp_iter_solver_ptr self, int k)
+{
+  return self->workspace + (size_t)k*self->ld;
+}
+
+/* Dimension of the Krylov subspace of GMRES by options */
+static int sp_iter_restart(sp_iter_options* options)
+{
+  return options->restart > 0 ? options->restart : 1;
+}
+
+/* Number of workspace vectors needed by the method */
+static int sp_iter_vectors_count(sp_iter_method method,
+                                 sp_iter_options* options)
+{
+  switch (method)
+  {
+  case ITER_CG: return 4;
+  case ITER_TFQMR: return 11;
+  case ITER_CGS: return 9;
+  case ITER_BICGSTAB: return 8;
+  case ITER_GMRES: return sp_iter_restart(options) + 2;
+  case ITER_PIPECG: return 9;
+  default: return 0;
+  }
+}
+
+/*
+ * Number of elements of the small workspace: Hessenberg matrix,
+ * Givens rotations and right part of the least squares problem
+ * of GMRES
+ */
+static int sp_iter_small_count(sp_iter_method method,
+                               sp_iter_options* options)
+{
+  int m = sp_iter_restart(options);
+  return method == ITER_GMRES ? (m+1)*(m+2) + 2*m : 0;
+}
+
+/*
+ * Allocates the workspace for the system of the given size
+ * if the current one is too small
+ */
+static void sp_iter_solver_reserve(sp_iter_solver_ptr self, int size)
+{
+  int vectors_count = sp_iter_vectors_count(self->method,&self->options);
+  int small_count = sp_iter_small_count(self->method,&self->options);
+  /* vectors are aligned to the cache line */
+  const int align = SP_MEM_ALIGNMENT/sizeof(double);
+  int ld = (size + align - 1)/align*align;
+  
+  if (ld > self->ld || vectors_count > self->vectors_count)
+  {
+    if (self->workspace)
+      spfree_aligned(self->workspace);
+    self->ld = ld > self->ld ? ld : self->ld;
+    self->vectors_count = vectors_count > self->vectors_count ?
+      vectors_count : self->vectors_count;
+    self->workspace =
+      spalloc_aligned((size_t)self->vectors_count*self->ld*sizeof(double));
+  }
+  if (small_count > self->small_count)
+  {
+    if (self->small)
+      spfree(self->small);
+    self->small_count = small_count;
+    self->small = spcalloc(small_count,sizeof(double));
+  }
+  if (size > self->size)
+    self->size = size;
+}
+
+void sp_iter_options_default(sp_iter_options* options)
+{
+  options->max_iter = SP_ITER_DEFAULT_MAX_ITER;
+  options->tolerance = 1e-10;
+  options->restart = SP_ITER_DEFAULT_RESTART;
+  options->orthogonalization = GMRES_MGS;
+  options->replacement = SP_PIPECG_REPLACEMENT;
+}
+
+int sp_iter_solver_init(sp_iter_solver_ptr self,
+                        sp_iter_method method,
+                        int size,
+                        sp_iter_options* options)
+{
+  memset(self,0,sizeof(sp_iter_solver));
+  if (size <= 0 || method < ITER_CG || method > ITER_PIPECG)
+  {
+    LOGERROR("Wrong parameters of the iterative solver");
+    return 0;
+  }
+  self->method = method;
+  if (options)
+    self->options = *options;
+  else
+    sp_iter_options_default(&self->options);
+  sp_iter_solver_reserve(self,size);
+  return 1;
+}
+
+int sp_iter_solver_solve(sp_iter_solver_ptr self,
+                         sp_matrix_yale_ptr A,
+                         sp_preconditioner_ptr precond,
+                         double* b,
+                         double* x0,
+                         double* x)
+{
+  /* options could be changed after the previous solve */
+  sp_iter_solver_reserve(self,A->rows_count);
+  switch (self->method)
+  {
+  case ITER_CG:
+    if (precond)
+      sp_iter_pcg(self,A,precond,b,x0,x);
+    else
+      sp_iter_cg(self,A,b,x0,x);
+    break;
+  case ITER_TFQMR:
+    sp_iter_tfqmr(self,A,precond,b,x0,x);
+    break;
+  case ITER_CGS:
+    sp_iter_cgs(self,A,precond,b,x0,x);
+    break;
+  case ITER_BICGSTAB:
+    sp_iter_bicgstab(self,A,precond,b,x0,x);
+    break;
+  case ITER_GMRES:
+    sp_iter_gmres(self,A,precond,b,x0,x);
+    break;
+  case ITER_PIPECG:
+    sp_iter_pipecg(self,A,precond,b,x0,x);
+    break;
+  default:
+    break;
+  }
+  self->stats.converged = self->stats.residual < self->options.tolerance;
+  self->stats.solves ++;
+  self->stats.total_iterations += self->stats.iterations;
+  return self->stats.converged;
+}
+
+void sp_iter_solver_free(sp_iter_solver_ptr self)
+{
+  if (self->workspace)
+    spfree_aligned(self->workspace);
+  if (self->small)
+    spfree(self->small);
+  self->workspace = 0;
+  self->small = 0;
+  self->ld = self->size = self->vectors_count = self->small_count = 0;
+}
+
+/*
+ * Solves the system by the temporary solver context
+ * for the solver functions without the context
+ */
+static void sp_iter_solve_once(sp_iter_method method,
+                               sp_matrix_yale_ptr self,
+                               sp_preconditioner_ptr precond,
+                               int restart,
+                               sp_gmres_orthogonalization type,
+                               double* b,
+                               double* x0,
+                               int* max_iter,
+                               double* tolerance,
+                               double* x)
+{
+  sp_iter_solver solver;
+  sp_iter_options options;
+  sp_iter_options_default(&options);
+  options.max_iter = *max_iter;
+  options.tolerance = *tolerance;
+  options.restart = restart;
+  options.orthogonalization = type;
+  if (sp_iter_solver_init(&solver,method,self->rows_count,&options))
+  {
+    sp_iter_solver_solve(&solver,self,precond,b,x0,x);
+    *max_iter = solver.stats.iterations;
+    *tolerance = solver.stats.residual;
+    sp_iter_solver_free(&solver);
+  }
+}
+
+
+
+static void sp_iter_cg(sp_iter_solver_ptr solver,
+                       sp_matrix_yale_ptr self,
+                       double* b,
+                       double* x0,
+                       double* x)
 {
   /* Conjugate Gradient Algorithm */
   /*
@@ -70,20 +452,11 @@ void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
   double residn = 0;
   int size = sizeof(double)*self->rows_count;
   int msize = self->rows_count;
-  int max_iterations = *max_iter;
-  double tol = *tolerance;
-  double* r;              /* residual */
-  double* p;              /* search direction */
-  double* temp;
-
-  /* allocate memory for vectors */
-  r = (double*)spalloc(size);
-  p = (double*)spalloc(size);
-  temp = (double*)spalloc(size);
-  /* clear vectors */
-  memset(r,0,size);
-  memset(p,0,size);
-  memset(temp,0,size);
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  double* r = sp_iter_vector(solver,0);    /* residual */
+  double* p = sp_iter_vector(solver,1);    /* search direction */
+  double* temp = sp_iter_vector(solver,2);
 
   /* x = x_0 */
   memcpy(x,x0,size);
@@ -95,15 +468,19 @@ void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
 
   /* p_0 = r_0 */
   memcpy(p,r,size);
+  /* (r_0,r_0) */
+  a1 = prod(r,r,msize);
   
-  /* CG loop */
+  /*
+   * CG loop: the matrix-vector product is fused with (A*p_j,p_j),
+   * updates of x and r - with (r_{j+1},r_{j+1}) giving both the
+   * residual norm and the next (r_j,r_j), so every iteration makes
+   * 3 passes over vectors besides the matrix
+   */
   for ( j = 0; j < max_iterations; j ++ )
   {
-    /* temp = A*p_j */
-    sp_matrix_yale_mv(self,p,temp);
-    /* compute (r_j,r_j) and (A*p_j,p_j) */
-    a1 = prod(r,r,msize);        /* (r_j,r_j) */
-    a2 = prod(temp,p,msize);     /* (A*p_j,p_j) */
+    /* temp = A*p_j, a2 = (A*p_j,p_j) */
+    a2 = sp_iter_mv_dot(self,p,temp);
 
     /*            (r_j,r_j) 
      * alpha_j = -----------
@@ -111,45 +488,47 @@ void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
      */                     
     alpha = a1/a2;              
                                 
-    /* x_{j+1} = x_j+alpha_j*p_j */
-    for (i = 0; i < msize; ++ i)
-      x[i] += alpha*p[i];
-    
-    /* r_{j+1} = r_j-alpha_j*A*p_j */
-    for (i = 0; i < msize; ++ i)
-      r[i] -= alpha*temp[i]; 
+    /*
+     * x_{j+1} = x_j+alpha_j*p_j
+     * r_{j+1} = r_j-alpha_j*A*p_j
+     * a2 = (r_{j+1},r_{j+1})
+     */
+    a2 = sp_iter_update_xr(alpha,p,temp,x,r,msize);
 
     /* check for convergence */
-    residn = norm2(r,msize);
+    residn = sqrt(a2);
     if (residn < tol )
       break;
 
-    /* compute (r_{j+1},r_{j+1}) */
-    a2 = prod(r,r,msize);
-
     /* b_j = (r_{j+1},r_{j+1})/(r_j,r_j) */
     beta = a2/a1;
+    a1 = a2;
     
     /* p_{j+1} = r_{j+1} + beta_j*p_j */
-    for (i = 0; i < msize; ++ i)
-      p[i] = r[i] + beta*p[i];
+    sp_iter_update_p(beta,r,p,msize);
   }
-  *max_iter = j;
-  *tolerance = residn;
-  
-  spfree(r);
-  spfree(p);
-  spfree(temp);
+  solver->stats.iterations = j;
+  solver->stats.residual = residn;
 }
 
+void sp_matrix_yale_solve_cg(sp_matrix_yale_ptr self,
+                             double* b,
+                             double* x0,
+                             int* max_iter,
+                             double* tolerance,
+                             double* x)
+{
+  sp_iter_solve_once(ITER_CG,self,0,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
+}
 
-void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
-                                  sp_matrix_skyline_ilu_ptr ILU,                         
-                                  double* b,
-                                  double* x0,
-                                  int* max_iter,
-                                  double* tolerance,
-                                  double* x)
+
+static void sp_iter_pcg(sp_iter_solver_ptr solver,
+                        sp_matrix_yale_ptr self,
+                        sp_preconditioner_ptr precond,
+                        double* b,
+                        double* x0,
+                        double* x)
 {
   /* Preconditioned Conjugate Gradient Algorithm */
   /*
@@ -157,8 +536,8 @@ void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
    * Saad Y. Iterative methods for sparse linear systems (2ed., 2000)
    * page 246
    *
-   * Preconditioner: Incomplete LU decomposition (ILU)
-   * M = L*U, A = M-R
+   * Preconditioner M is given by the preconditioner object precond
+   * calculating z = M^{-1}*r
    */
 
   /* variables */
@@ -167,28 +546,12 @@ void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
   double residn = 0;
   int size = sizeof(double)*self->rows_count;
   int msize = self->rows_count;
-  int max_iterations = *max_iter;
-  double tol = *tolerance;
-  
-  double* r;              /* residual */
-  double* r1;             /* backup of the residual */
-  double* p;              /* search direction */
-  double* z;              /* z = M^{-1}*r */
-  double* temp;
-
-  /* allocate memory for vectors */
-  r = (double*)spalloc(size);
-  r1 = (double*)spalloc(size);
-  p = (double*)spalloc(size);
-  z = (double*)spalloc(size);
-  temp = (double*)spalloc(size);
-  
-  /* clear vectors */
-  memset(r,0,size);
-  memset(r1,0,size);
-  memset(p,0,size);
-  memset(z,0,size);
-  memset(temp,0,size);
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  double* r = sp_iter_vector(solver,0);    /* residual */
+  double* p = sp_iter_vector(solver,1);    /* search direction */
+  double* z = sp_iter_vector(solver,2);    /* z = M^{-1}*r */
+  double* temp = sp_iter_vector(solver,3);
 
   /* x = x_0 */
   memcpy(x,x0,size);
@@ -198,182 +561,1234 @@ void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
   for ( i = 0; i < msize; ++ i)
     r[i] = b[i] - r[i];
   
-  /* backup residual */
-  memcpy(r1,r,size);
   /* z_0 = M^{-1}*r_0 */
-  /*
-   * to solve system L*U*x = b
-   * y = U*x, => L*y = b
-   * U*x = y => x
-   */ 
-  sp_matrix_skyline_ilu_lower_solve(ILU,r1,temp); /* temp = L^{-1}*r */
-  /* r1 now changed, temp contains solution */
-  sp_matrix_skyline_ilu_upper_solve(ILU,temp,z); /* z = U^{-1}*temp */
-  /* temp now changed, z contains solution*/
+  sp_precond_solve(precond,r,z,msize);
   
   /* p_0 = z_0 */
   memcpy(p,z,size);
+  /* (r_0,z_0) */
+  a1 = prod(r,z,msize);
   
-  /* CG loop */
+  /* CG loop with fused kernels, see sp_iter_cg */
   for ( j = 0; j < max_iterations; j ++ )
   {
-    /* temp = A*p_j */
-    memset(temp,0,size);
-    sp_matrix_yale_mv(self,p,temp);
-    /* compute (r_j,z_j) and (A*p_j,p_j) */
-    a1 = prod(r,z,msize);       /* (r_j,z_j) */
-    a2 = prod(p,temp,msize);    /* (A*p_j,p_j) */
+    /* temp = A*p_j, a2 = (A*p_j,p_j) */
+    a2 = sp_iter_mv_dot(self,p,temp);
     /*            (r_j,z_j) 
      * alpha_j = -----------
      *           (A*p_j,p_j)
      */                     
     alpha = a1/a2;              
                                 
-    /* x_{j+1} = x_j+alpha_j*p_j */
-    for (i = 0; i < msize; ++ i)
-      x[i] += alpha*p[i];
-    
-    /* r_{j+1} = r_j-alpha_j*A*p_j */
-    for (i = 0; i < msize; ++ i)
-      r[i] -= alpha*temp[i]; 
+    /*
+     * x_{j+1} = x_j+alpha_j*p_j
+     * r_{j+1} = r_j-alpha_j*A*p_j
+     * a2 = (r_{j+1},r_{j+1})
+     */
+    a2 = sp_iter_update_xr(alpha,p,temp,x,r,msize);
 
     /* check for convergence */
-    residn = norm2(r,msize);
+    residn = sqrt(a2);
     if (residn < tol )
       break;
 
     /* z_{j+1} = M^{-1}*r_{j+1} */
-    memcpy(r1,r,size);
-    memset(temp,0,size);
-    sp_matrix_skyline_ilu_lower_solve(ILU,r1,temp); /* temp = L^{-1}*r */
-    sp_matrix_skyline_ilu_upper_solve(ILU,temp,z); /* z = U^{-1}*temp */
-
+    sp_precond_solve(precond,r,z,msize);
     
     /* compute (r_{j+1},z_{j+1}) */
     a2 = prod(r,z,msize);
 
     /* b_j = (r_{j+1},z_{j+1})/(r_j,z_j) */
     beta = a2/a1;
+    a1 = a2;
     
     /* d_{j+1} = r_{j+1} + beta_j*d_j */
-    for (i = 0; i < msize; ++ i)
-      p[i] = z[i] + beta*p[i];
+    sp_iter_update_p(beta,z,p,msize);
   }
-  *max_iter = j;
-  *tolerance = residn;
-  
-  /* free vectors */
-  spfree(r);
-  spfree(r1);
-  spfree(z);
-  spfree(p);
-  spfree(temp);
+  solver->stats.iterations = j;
+  solver->stats.residual = residn;
 }
 
-void sp_matrix_create_ilu(sp_matrix_ptr self,sp_matrix_skyline_ilu_ptr ilu)
+void sp_matrix_yale_solve_pcg(sp_matrix_yale_ptr self,
+                              sp_preconditioner_ptr precond,
+                              double* b,
+                              double* x0,
+                              int* max_iter,
+                              double* tolerance,
+                              double* x)
 {
-  sp_matrix_skyline A;
-  /* reorder self if not already reordered */
-  if (!self->ordered)
-    sp_matrix_reorder(self);
-  /* initialize skyline matrix for ILU decomposition */
-  sp_matrix_skyline_init(&A,self);
-  /*
-   * create ILU decomposition of the sparse matrix in skyline format
-   * taking ownership of the skyline A matrix
-   */
-  sp_matrix_skyline_ilu_copy_init(ilu,&A);
-  /*
-   * since init_copy_sp_matrix_skyline_ilu takes the ownership
-   * of the A matrix it is not needed to free A matrix
-   */
+  sp_iter_solve_once(ITER_CG,self,precond,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
 }
 
-
-void sp_matrix_skyline_ilu_copy_init(sp_matrix_skyline_ilu_ptr self,
-                                     sp_matrix_skyline_ptr parent)
+/*
+ * Explicit calculation of the residual of the pipelined CG:
+ * r = b - A*x, u = M^{-1}*r, w = A*u
+ */
+static void sp_iter_pipecg_residual(sp_matrix_yale_ptr self,
+                                    sp_preconditioner_ptr precond,
+                                    double* b,
+                                    double* x,
+                                    double* r,
+                                    double* u,
+                                    double* w)
 {
-  int i,j,k,l,q;
-  double sum;
-  
-  /* copy parent member-wise */
-  self->parent = *parent;
-  /* allocate memory for ILU decomposition arrays */
-  self->ilu_diag = (double*)spalloc(sizeof(double)*parent->rows_count);
-  self->ilu_lowertr = (double*)spalloc(sizeof(double)*parent->tr_nonzeros);
-  self->ilu_uppertr = (double*)spalloc(sizeof(double)*parent->tr_nonzeros);
-  /* clear arrays before construction of the ILU decomposition */
-  memset(self->ilu_diag,0,sizeof(double)*parent->rows_count);
-  memset(self->ilu_lowertr,0,sizeof(double)*parent->tr_nonzeros);
-  memset(self->ilu_uppertr,0,sizeof(double)*parent->tr_nonzeros);
+  int i;
+  sp_iter_mv(self,x,r);
+  for (i = 0; i < self->rows_count; ++ i)
+    r[i] = b[i] - r[i];
+  if (precond)
+    precond->apply(precond->state,r,u);
+  sp_iter_mv(self,u,w);
+}
 
-  for (k = 0; k < parent->rows_count; ++ k)
+static void sp_iter_pipecg(sp_iter_solver_ptr solver,
+                           sp_matrix_yale_ptr self,
+                           sp_preconditioner_ptr precond,
+                           double* b,
+                           double* x0,
+                           double* x)
+{
+  /* Pipelined Preconditioned Conjugate Gradient Algorithm */
+  /*
+   * Based on the article:
+   * Ghysels P., Vanroose W. Hiding global synchronization latency
+   * in the preconditioned Conjugate Gradient algorithm.
+   * Parallel Computing 40 (2014), Algorithm 4
+   *
+   * Besides x, r, u = M^{-1}*r and p the method updates
+   * w = A*u, s = A*p, q = M^{-1}*s and z = A*q by recurrences, so
+   * (r,u), (w,u) and (r,r) of the next iteration are calculated in
+   * the same sweep as updates of vectors, and the matrix-vector
+   * product n = A*M^{-1}*w doesn't depend on them.
+   * Without preconditioner u = r, q = s and m = w
+   */
+  int i,j;
+  double alpha = 0, beta = 0;
+  double gamma, gamma1 = 0, delta, rr;
+  double residn = 0, residn0;
+  int msize = self->rows_count;
+  int max_iterations = solver->options.max_iter;
+  int replacement = solver->options.replacement;
+  double tol = solver->options.tolerance;
+  double* r = sp_iter_vector(solver,0);    /* residual */
+  double* w = sp_iter_vector(solver,1);    /* A*u */
+  double* n = sp_iter_vector(solver,2);    /* A*m */
+  double* z = sp_iter_vector(solver,3);    /* A*q */
+  double* s = sp_iter_vector(solver,4);    /* A*p */
+  double* p = sp_iter_vector(solver,5);    /* search direction */
+  double* u = precond ? sp_iter_vector(solver,6) : r; /* M^{-1}*r */
+  double* m = precond ? sp_iter_vector(solver,7) : w; /* M^{-1}*w */
+  double* q = precond ? sp_iter_vector(solver,8) : s; /* M^{-1}*s */
+
+  /* x = x_0, p_{-1} = s_{-1} = q_{-1} = z_{-1} = 0 */
+  memcpy(x,x0,msize*sizeof(double));
+  memset(p,0,msize*sizeof(double));
+  memset(s,0,msize*sizeof(double));
+  memset(q,0,msize*sizeof(double));
+  memset(z,0,msize*sizeof(double));
+  /* r_0 = b - A*x_0, u_0 = M^{-1}*r_0, w_0 = A*u_0 */
+  sp_iter_pipecg_residual(self,precond,b,x,r,u,w);
+  gamma = prod(r,u,msize);
+  delta = prod(w,u,msize);
+  rr = prod(r,r,msize);
+  residn0 = sqrt(rr);
+
+  for (j = 0; j < max_iterations; ++ j)
   {
-    for ( j = parent->iptr[k]; j < parent->iptr[k+1]; ++ j)
+    /* check for convergence */
+    residn = sqrt(rr);
+    if (residn < tol)
+      break;
+    /* m = M^{-1}*w, n = A*m */
+    if (precond)
+      precond->apply(precond->state,w,m);
+    sp_iter_mv(self,m,n);
+    /*
+     * beta_j = gamma_j/gamma_{j-1}
+     * alpha_j = gamma_j/(delta_j - beta_j*gamma_j/alpha_{j-1})
+     */
+    if (j > 0)
     {
-      /*
-       * L_{kj} = (A_{kj} - \sum\limits_{i=1}^{j-1}L_{ki}U_{ij}/U_{jj}
-       * calculate using L_{k,jptr[j]}
-       */
-      sum = 0;
-      q = parent->jptr[j];        /* column index */
-      for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
+      beta = gamma/gamma1;
+      alpha = gamma/(delta - beta*gamma/alpha);
+    }
+    else
+      alpha = gamma/delta;
+    gamma1 = gamma;
+    gamma = delta = rr = 0;
+    /* all updates and scalar products in one sweep */
+    SP_OMP(omp parallel for reduction(+:gamma,delta,rr)          \
+           if(msize > SP_ITER_PARALLEL_MIN))
+    for (i = 0; i < msize; ++ i)
+    {
+      z[i] = n[i] + beta*z[i];
+      s[i] = w[i] + beta*s[i];
+      p[i] = u[i] + beta*p[i];
+      x[i] += alpha*p[i];
+      if (precond)
       {
-        for ( l = parent->iptr[q]; l < parent->iptr[q+1]; ++ l)
-        {
-          /* if row and column indicies are the same */
-          if ( parent->jptr[i] == parent->jptr[l] )
-            sum += self->ilu_lowertr[i]*self->ilu_uppertr[l];
-        }
+        q[i] = m[i] + beta*q[i];
+        u[i] -= alpha*q[i];
       }
-      self->ilu_lowertr[j] =
-        (parent->lower_triangle[j] - sum)/self->ilu_diag[q];
+      r[i] -= alpha*s[i];
+      w[i] -= alpha*z[i];
+      gamma += r[i]*u[i];
+      delta += w[i]*u[i];
+      rr += r[i]*r[i];
     }
-
     /*
-     * U_{kk} = A_{kk} -
-     * \sum\limits_{i=1}^{k-1} L_{ki}U_{ik}
+     * replace the recursively updated vectors by true ones;
+     * when the residual is reduced by sqrt(eps) the true one comes
+     * close to the attainable accuracy, so further replacements
+     * would stop the convergence of the recursively updated residual
      */
-    sum = 0;
-    for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
-      sum += self->ilu_lowertr[i]*self->ilu_uppertr[i];
-    self->ilu_diag[k] = parent->diag[k] - sum;
-
-    for (j = k; j < parent->rows_count; ++ j)
+    if (replacement > 0 && (j+1) % replacement == 0 &&
+        sqrt(rr) > sqrt(DBL_EPSILON)*residn0)
     {
-      for ( q = parent->iptr[j]; q < parent->iptr[j+1]; ++ q)
-        if (k == parent->jptr[q])
-        {
-          /*
-           * U_{kj} = A_{kj} -
-           * \sum\limits_{i=1}^{k-1}L_{ki}U_{ij}
-           */
-          sum = 0;
-          /*
-           * i = iptr[k]:iptr[k+1]-1 are coordinates of the
-           * k-th row in lower matrix array (self->ilu_lowertr)
-           * l = iptr[j]:iptr[j+1]-1 are coordinates of the
-           * j-th column in upper matrix array (self->ilu_uppertr)
-           */
-          for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
-            for ( l = parent->iptr[j]; l < parent->iptr[j+1]; ++ l)
-            {
-              /* if row and column indicies are the same */
-              if ( parent->jptr[i] == parent->jptr[l] )
-                sum += self->ilu_lowertr[i]*self->ilu_uppertr[l];
-            }
-          self->ilu_uppertr[q] = parent->upper_triangle[q] - sum;
-        }
+      sp_iter_pipecg_residual(self,precond,b,x,r,u,w);
+      /* s = A*p, q = M^{-1}*s, z = A*q */
+      sp_iter_mv(self,p,s);
+      if (precond)
+        precond->apply(precond->state,s,q);
+      sp_iter_mv(self,q,z);
+      gamma = prod(r,u,msize);
+      delta = prod(w,u,msize);
+      rr = prod(r,r,msize);
     }
   }
+  solver->stats.iterations = j;
+  solver->stats.residual = residn;
 }
 
-void sp_matrix_skyline_ilu_free(sp_matrix_skyline_ilu_ptr self)
+void sp_matrix_yale_solve_pipecg(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x)
 {
-  spfree(self->ilu_diag);
-  spfree(self->ilu_lowertr);
-  spfree(self->ilu_uppertr);
-  sp_matrix_skyline_free(&self->parent);
+  sp_iter_solve_once(ITER_PIPECG,self,precond,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
+}
+
+/*
+ * Relative norm of the column of the block of search directions
+ * after orthogonalization below which the column is considered
+ * linearly dependent on the previous ones and dropped
+ */
+#define SP_BLOCK_CG_DROP 1e-10
+
+/*
+ * Cholesky decomposition G = L*L' of the small dense symmetric
+ * matrix of size s stored by rows, L overwrites the lower triangle
+ * Returns nonzero if G is positive definite
+ */
+static int sp_dense_chol(int s, double* G)
+{
+  int i,j,l;
+  double sum;
+  for (j = 0; j < s; ++ j)
+  {
+    sum = G[j*s+j];
+    for (l = 0; l < j; ++ l)
+      sum -= G[j*s+l]*G[j*s+l];
+    if (sum <= 0)
+      return 0;
+    G[j*s+j] = sqrt(sum);
+    for (i = j+1; i < s; ++ i)
+    {
+      sum = G[i*s+j];
+      for (l = 0; l < j; ++ l)
+        sum -= G[i*s+l]*G[j*s+l];
+      G[i*s+j] = sum/G[j*s+j];
+    }
+  }
+  return 1;
+}
+
+/*
+ * Solves L*L'*Y = W with L calculated by sp_dense_chol,
+ * W is s x k matrix stored by rows, overwritten by Y
+ */
+static void sp_dense_chol_solve(int s, double* L, int k, double* W)
+{
+  int i,l,c;
+  for (c = 0; c < k; ++ c)
+  {
+    for (i = 0; i < s; ++ i)
+    {
+      for (l = 0; l < i; ++ l)
+        W[i*k+c] -= L[i*s+l]*W[l*k+c];
+      W[i*k+c] /= L[i*s+i];
+    }
+    for (i = s-1; i >= 0; -- i)
+    {
+      for (l = i+1; l < s; ++ l)
+        W[i*k+c] -= L[l*s+i]*W[l*k+c];
+      W[i*k+c] /= L[i*s+i];
+    }
+  }
+}
+
+/*
+ * Orthonormalizes active columns of Z (n x k, stored by columns)
+ * by the classical Gram-Schmidt with reorthogonalization, dropping
+ * columns which norm is reduced below SP_BLOCK_CG_DROP of the
+ * initial one: they are linearly dependent on the previous columns.
+ * Accepted columns are stored by rows in P (n x s),
+ * h - workspace of k elements
+ * Returns the number s of accepted columns
+ */
+static int sp_block_cg_orth(int n,
+                            int k,
+                            int* active,
+                            double* Z,
+                            double* P,
+                            double* h)
+{
+  int i,a,c,pass,s = 0;
+  double norm0, norm;
+  double* v;
+  for (c = 0; c < k; ++ c)
+  {
+    if (!active[c])
+      continue;
+    v = Z + c*n;
+    norm0 = norm2(v,n);
+    for (pass = 0; pass < 2; ++ pass)
+    {
+      for (a = 0; a < s; ++ a)
+        h[a] = prod(Z+a*n,v,n);
+      for (i = 0; i < n; ++ i)
+        for (a = 0; a < s; ++ a)
+          v[i] -= h[a]*Z[a*n+i];
+    }
+    norm = norm2(v,n);
+    if (norm0 == 0 || norm <= SP_BLOCK_CG_DROP*norm0)
+      continue;
+    /* accepted columns are moved to the beginning of Z */
+    for (i = 0; i < n; ++ i)
+      Z[s*n+i] = v[i]/norm;
+    s ++;
+  }
+  for (i = 0; i < n; ++ i)
+    for (a = 0; a < s; ++ a)
+      P[i*s+a] = Z[a*n+i];
+  return s;
+}
+
+/*
+ * Z = M^{-1}*R for active columns stored one after another
+ */
+static void sp_block_cg_precond(sp_preconditioner_ptr precond,
+                                int n,
+                                int k,
+                                int* active,
+                                double* R,
+                                double* Z)
+{
+  int c;
+  for (c = 0; c < k; ++ c)
+    if (active[c])
+      sp_precond_solve(precond,R+c*n,Z+c*n,n);
+}
+
+int sp_matrix_yale_solve_block_cg(sp_matrix_yale_ptr self,
+                                  sp_preconditioner_ptr precond,
+                                  int nrhs,
+                                  double* B,
+                                  double* X0,
+                                  int* max_iter,
+                                  double tolerance,
+                                  int* iterations,
+                                  double* residuals,
+                                  double* X)
+{
+  /* Block Preconditioned Conjugate Gradient Algorithm */
+  /*
+   * Based on the articles:
+   * O'Leary D. P. The block conjugate gradient algorithm and
+   * related methods. Linear Algebra Appl. 29 (1980)
+   * Ji H., Li Y. A breakdown-free block conjugate gradient method.
+   * BIT Numerical Mathematics 57 (2017)
+   *
+   * Search directions P (n x s, s <= nrhs) are orthonormalized
+   * with dropping of linearly dependent columns, so the block
+   * shrinks instead of the breakdown of P'*A*P. Converged columns
+   * are not updated anymore and don't generate search directions
+   */
+  int n = self->rows_count, k = nrhs;
+  int i,a,b,c,s,it = 0,active_count = 0;
+  double sum_x, sum_r, residn;
+  double* R = spalloc(n*k*sizeof(double)); /* residuals by columns */
+  double* Z = spalloc(n*k*sizeof(double)); /* M^{-1}*R by columns */
+  double* P = spalloc(n*k*sizeof(double)); /* directions by rows */
+  double* Q = spalloc(n*k*sizeof(double)); /* A*P by rows */
+  double* G = spalloc(k*k*sizeof(double)); /* P'*A*P */
+  double* W = spalloc(k*k*sizeof(double)); /* alpha and beta */
+  int* active = spalloc(k*sizeof(int));    /* not converged columns */
+
+  /* R_0 = B - A*X_0 */
+  memcpy(X,X0,n*k*sizeof(double));
+  for (c = 0; c < k; ++ c)
+  {
+    sp_matrix_yale_mv(self,X+c*n,R+c*n);
+    for (i = 0; i < n; ++ i)
+      R[c*n+i] = B[c*n+i] - R[c*n+i];
+    residuals[c] = norm2(R+c*n,n);
+    iterations[c] = 0;
+    active[c] = residuals[c] >= tolerance;
+    active_count += active[c];
+  }
+  /* P_0 = orth(M^{-1}*R_0) */
+  sp_block_cg_precond(precond,n,k,active,R,Z);
+  s = sp_block_cg_orth(n,k,active,Z,P,W);
+  
+  while (active_count && s && it < *max_iter)
+  {
+    ++ it;
+    /* Q = A*P, reading the matrix once for all directions */
+    sp_matrix_yale_mv_block(self,s,P,Q);
+    /* G = P'*Q, W = P'*R */
+    memset(G,0,s*s*sizeof(double));
+    memset(W,0,s*k*sizeof(double));
+    for (i = 0; i < n; ++ i)
+    {
+      for (a = 0; a < s; ++ a)
+        for (b = a; b < s; ++ b)
+          G[a*s+b] += P[i*s+a]*Q[i*s+b];
+      for (c = 0; c < k; ++ c)
+        if (active[c])
+          for (a = 0; a < s; ++ a)
+            W[a*k+c] += P[i*s+a]*R[c*n+i];
+    }
+    for (a = 0; a < s; ++ a)
+      for (b = 0; b < a; ++ b)
+        G[a*s+b] = G[b*s+a];
+    /* breakdown: P'*A*P is not positive definite */
+    if (!sp_dense_chol(s,G))
+      break;
+    /* alpha = (P'*A*P)^{-1}*P'*R */
+    sp_dense_chol_solve(s,G,k,W);
+    /* X = X + P*alpha, R = R - Q*alpha */
+    for (c = 0; c < k; ++ c)
+    {
+      if (!active[c])
+        continue;
+      residn = 0;
+      for (i = 0; i < n; ++ i)
+      {
+        sum_x = sum_r = 0;
+        for (a = 0; a < s; ++ a)
+        {
+          sum_x += P[i*s+a]*W[a*k+c];
+          sum_r += Q[i*s+a]*W[a*k+c];
+        }
+        X[c*n+i] += sum_x;
+        R[c*n+i] -= sum_r;
+        residn += R[c*n+i]*R[c*n+i];
+      }
+      /* check for convergence of the column */
+      residuals[c] = sqrt(residn);
+      if (residuals[c] < tolerance)
+      {
+        active[c] = 0;
+        iterations[c] = it;
+        active_count --;
+      }
+    }
+    if (!active_count)
+      break;
+    /* Z = M^{-1}*R, W = Q'*Z */
+    sp_block_cg_precond(precond,n,k,active,R,Z);
+    memset(W,0,s*k*sizeof(double));
+    for (i = 0; i < n; ++ i)
+      for (c = 0; c < k; ++ c)
+        if (active[c])
+          for (a = 0; a < s; ++ a)
+            W[a*k+c] += Q[i*s+a]*Z[c*n+i];
+    /* beta = -(P'*A*P)^{-1}*Q'*Z, P = orth(Z + P*beta) */
+    sp_dense_chol_solve(s,G,k,W);
+    for (i = 0; i < n; ++ i)
+      for (c = 0; c < k; ++ c)
+        if (active[c])
+          for (a = 0; a < s; ++ a)
+            Z[c*n+i] -= P[i*s+a]*W[a*k+c];
+    s = sp_block_cg_orth(n,k,active,Z,P,W);
+  }
+  for (c = 0; c < k; ++ c)
+    if (active[c])
+      iterations[c] = it;
+  *max_iter = it;
+
+  spfree(R);
+  spfree(Z);
+  spfree(P);
+  spfree(Q);
+  spfree(G);
+  spfree(W);
+  spfree(active);
+  return active_count == 0;
+}
+
+/*
+ * Preconditioner function for the ILU decomposition in skyline format
+ * M = L*U:
+ * to solve system L*U*z = r
+ * y = U*z, => L*y = r
+ * U*z = y => z
+ * both solvers could work in place
+ */
+static void sp_matrix_skyline_ilu_precond(void* data, double* r, double* z)
+{
+  sp_matrix_skyline_ilu_ptr ILU = (sp_matrix_skyline_ilu_ptr)data;
+  sp_matrix_skyline_ilu_lower_solve(ILU,r,z); /* z = L^{-1}*r */
+  sp_matrix_skyline_ilu_upper_solve(ILU,z,z); /* z = U^{-1}*z */
+}
+
+void sp_matrix_yale_solve_pcg_ilu(sp_matrix_yale_ptr self,
+                                  sp_matrix_skyline_ilu_ptr ILU,                         
+                                  double* b,
+                                  double* x0,
+                                  int* max_iter,
+                                  double* tolerance,
+                                  double* x)
+{
+  /*
+   * Preconditioner: Incomplete LU decomposition (ILU)
+   * M = L*U, A = M-R
+   */
+  sp_preconditioner precond;
+  sp_preconditioner_user_init(&precond,sp_matrix_skyline_ilu_precond,ILU);
+  sp_matrix_yale_solve_pcg(self,&precond,b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_yale_ilu_precond(void* data, double* r, double* z)
+{
+  sp_matrix_yale_ilu_solve((sp_matrix_yale_ilu_ptr)data,r,z);
+}
+
+void sp_matrix_yale_solve_pcg_ilu0(sp_matrix_yale_ptr self,
+                                   sp_matrix_yale_ilu_ptr ilu,
+                                   double* b,
+                                   double* x0,
+                                   int* max_iter,
+                                   double* tolerance,
+                                   double* x)
+{
+  sp_preconditioner precond;
+  sp_preconditioner_user_init(&precond,sp_matrix_yale_ilu_precond,ilu);
+  sp_matrix_yale_solve_pcg(self,&precond,b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_yale_ic_precond(void* data, double* r, double* z)
+{
+  sp_matrix_yale_ic_solve((sp_matrix_yale_ic_ptr)data,r,z);
+}
+
+void sp_matrix_yale_solve_pcg_ic(sp_matrix_yale_ptr self,
+                                 sp_matrix_yale_ic_ptr ic,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x)
+{
+  sp_preconditioner precond;
+  sp_preconditioner_user_init(&precond,sp_matrix_yale_ic_precond,ic);
+  sp_matrix_yale_solve_pcg(self,&precond,b,x0,max_iter,tolerance,x);
+}
+
+void sp_amg_precond(void* data, double* r, double* z)
+{
+  sp_amg_solve((sp_amg_ptr)data,r,z);
+}
+
+void sp_matrix_yale_solve_pcg_amg(sp_matrix_yale_ptr self,
+                                  sp_amg_ptr amg,
+                                  double* b,
+                                  double* x0,
+                                  int* max_iter,
+                                  double* tolerance,
+                                  double* x)
+{
+  sp_preconditioner precond;
+  sp_preconditioner_user_init(&precond,sp_amg_precond,amg);
+  sp_matrix_yale_solve_pcg(self,&precond,b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_create_ilu(sp_matrix_ptr self,sp_matrix_skyline_ilu_ptr ilu)
+{
+  sp_matrix_skyline A;
+  /* reorder self if not already reordered */
+  if (!self->ordered)
+    sp_matrix_reorder(self);
+  /* initialize skyline matrix for ILU decomposition */
+  sp_matrix_skyline_init(&A,self);
+  /*
+   * create ILU decomposition of the sparse matrix in skyline format
+   * taking ownership of the skyline A matrix
+   */
+  sp_matrix_skyline_ilu_copy_init(ilu,&A);
+  /*
+   * since init_copy_sp_matrix_skyline_ilu takes the ownership
+   * of the A matrix it is not needed to free A matrix
+   */
+}
+
+
+void sp_matrix_skyline_ilu_copy_init(sp_matrix_skyline_ilu_ptr self,
+                                     sp_matrix_skyline_ptr parent)
+{
+  int i,j,k,l,q;
+  int bandwidth = 0;
+  double sum;
+  
+  /* copy parent member-wise */
+  self->parent = *parent;
+  /* allocate memory for ILU decomposition arrays */
+  self->ilu_diag = (double*)spalloc(sizeof(double)*parent->rows_count);
+  self->ilu_lowertr = (double*)spalloc(sizeof(double)*parent->tr_nonzeros);
+  self->ilu_uppertr = (double*)spalloc(sizeof(double)*parent->tr_nonzeros);
+  /* clear arrays before construction of the ILU decomposition */
+  memset(self->ilu_diag,0,sizeof(double)*parent->rows_count);
+  memset(self->ilu_lowertr,0,sizeof(double)*parent->tr_nonzeros);
+  memset(self->ilu_uppertr,0,sizeof(double)*parent->tr_nonzeros);
+  /*
+   * bandwidth of the matrix: only rows k..k+bandwidth could contain
+   * nonzeros in k-th column, so the narrow profile
+   * (i.e. after the Cuthill-McKee reordering) speeds up the decomposition
+   */
+  for (k = 0; k < parent->rows_count; ++ k)
+    for ( j = parent->iptr[k]; j < parent->iptr[k+1]; ++ j)
+      if (k - parent->jptr[j] > bandwidth)
+        bandwidth = k - parent->jptr[j];
+
+  for (k = 0; k < parent->rows_count; ++ k)
+  {
+    for ( j = parent->iptr[k]; j < parent->iptr[k+1]; ++ j)
+    {
+      /*
+       * L_{kj} = (A_{kj} - \sum\limits_{i=1}^{j-1}L_{ki}U_{ij}/U_{jj}
+       * calculate using L_{k,jptr[j]}
+       */
+      sum = 0;
+      q = parent->jptr[j];        /* column index */
+      for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
+      {
+        for ( l = parent->iptr[q]; l < parent->iptr[q+1]; ++ l)
+        {
+          /* if row and column indicies are the same */
+          if ( parent->jptr[i] == parent->jptr[l] )
+            sum += self->ilu_lowertr[i]*self->ilu_uppertr[l];
+        }
+      }
+      self->ilu_lowertr[j] =
+        (parent->lower_triangle[j] - sum)/self->ilu_diag[q];
+    }
+
+    /*
+     * U_{kk} = A_{kk} -
+     * \sum\limits_{i=1}^{k-1} L_{ki}U_{ik}
+     */
+    sum = 0;
+    for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
+      sum += self->ilu_lowertr[i]*self->ilu_uppertr[i];
+    self->ilu_diag[k] = parent->diag[k] - sum;
+
+    for (j = k; j < parent->rows_count && j <= k + bandwidth; ++ j)
+    {
+      for ( q = parent->iptr[j]; q < parent->iptr[j+1]; ++ q)
+        if (k == parent->jptr[q])
+        {
+          /*
+           * U_{kj} = A_{kj} -
+           * \sum\limits_{i=1}^{k-1}L_{ki}U_{ij}
+           */
+          sum = 0;
+          /*
+           * i = iptr[k]:iptr[k+1]-1 are coordinates of the
+           * k-th row in lower matrix array (self->ilu_lowertr)
+           * l = iptr[j]:iptr[j+1]-1 are coordinates of the
+           * j-th column in upper matrix array (self->ilu_uppertr)
+           */
+          for ( i = parent->iptr[k]; i < parent->iptr[k+1]; ++ i)
+            for ( l = parent->iptr[j]; l < parent->iptr[j+1]; ++ l)
+            {
+              /* if row and column indicies are the same */
+              if ( parent->jptr[i] == parent->jptr[l] )
+                sum += self->ilu_lowertr[i]*self->ilu_uppertr[l];
+            }
+          self->ilu_uppertr[q] = parent->upper_triangle[q] - sum;
+        }
+    }
+  }
+  /*
+   * the portrait of L is the same as of U^T, so the same schedule
+   * is used in both solvers
+   */
+  sp_level_schedule_init(&self->schedule,parent->rows_count,
+                         parent->iptr,parent->jptr,CRS);
+}
+
+void sp_matrix_skyline_ilu_free(sp_matrix_skyline_ilu_ptr self)
+{
+  spfree(self->ilu_diag);
+  spfree(self->ilu_lowertr);
+  spfree(self->ilu_uppertr);
+  sp_level_schedule_free(&self->schedule);
+  sp_matrix_skyline_free(&self->parent);
+}
+
+
+int sp_matrix_yale_ilu_init(sp_matrix_yale_ilu_ptr self,
+                            sp_matrix_yale_ptr A)
+{
+  int i,j,k,p,q;
+  int n = A->rows_count;
+  int *offsets, *indicies, *diag, *marker;
+  double* values;
+  double l_ik;
+  memset(self,0,sizeof(sp_matrix_yale_ilu));
+  /* factors are calculated in the copy of the matrix in CRS format */
+  if (!sp_matrix_yale_convert(A,&self->LU,CRS))
+    sp_matrix_yale_copy(A,&self->LU);
+  offsets = self->LU.offsets;
+  indicies = self->LU.indicies;
+  values = self->LU.values;
+  diag = self->diag = spalloc((n ? n : 1)*sizeof(int));
+  marker = spalloc((n ? n : 1)*sizeof(int));
+  for (i = 0; i < n; ++ i)
+    marker[i] = -1;
+  /*
+   * IKJ variant of the Gaussian elimination restricted to the portrait:
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * page 303
+   */
+  for (i = 0; i < n; ++ i)
+  {
+    /* positions of the elements of i-th row */
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      marker[indicies[p]] = p;
+    diag[i] = marker[i];
+    if (diag[i] == -1)
+    {
+      LOGERROR("ILU(0) decomposition: no diagonal element in %d row",i);
+      spfree(marker);
+      sp_matrix_yale_ilu_free(self);
+      return 0;
+    }
+    /* elimination by rows k < i of the row portrait */
+    for (p = offsets[i]; p < diag[i]; ++ p)
+    {
+      k = indicies[p];
+      l_ik = values[p] /= values[diag[k]];
+      for (q = diag[k]+1; q < offsets[k+1]; ++ q)
+        if ((j = marker[indicies[q]]) != -1)
+          values[j] -= l_ik*values[q];
+    }
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      marker[indicies[p]] = -1;
+    if (values[diag[i]] == 0)
+    {
+      LOGERROR("ILU(0) decomposition: zero pivot in %d row",i);
+      spfree(marker);
+      sp_matrix_yale_ilu_free(self);
+      return 0;
+    }
+  }
+  spfree(marker);
+  /*
+   * L depends on elements left of the diagonal (rows), U on elements
+   * right of the diagonal (the CRS portrait taken as CCS one)
+   */
+  sp_level_schedule_init(&self->lower,n,offsets,indicies,CRS);
+  sp_level_schedule_init(&self->upper,n,offsets,indicies,CCS);
+  return 1;
+}
+
+void sp_matrix_yale_ilu_solve(sp_matrix_yale_ilu_ptr self,
+                              double* b,
+                              double* x)
+{
+  int i,k,p,r,first,last;
+  int* offsets = self->LU.offsets, *indicies = self->LU.indicies;
+  int* diag = self->diag;
+  double* values = self->LU.values;
+  double sum;
+  /* L*y = b, rows of the same level are independent */
+  for (k = 0; k < self->lower.levels_count; ++ k)
+  {
+    first = self->lower.levels[k];
+    last = self->lower.levels[k+1];
+    SP_OMP(omp parallel for private(i,p,sum) if(last - first > SP_SCHEDULE_PARALLEL_MIN))
+    for (r = first; r < last; ++ r)
+    {
+      i = self->lower.rows[r];
+      sum = b[i];
+      for (p = offsets[i]; p < diag[i]; ++ p)
+        sum -= values[p]*x[indicies[p]];
+      x[i] = sum;
+    }
+  }
+  /* U*x = y by decreasing levels */
+  for (k = self->upper.levels_count-1; k >= 0; -- k)
+  {
+    first = self->upper.levels[k];
+    last = self->upper.levels[k+1];
+    SP_OMP(omp parallel for private(i,p,sum) if(last - first > SP_SCHEDULE_PARALLEL_MIN))
+    for (r = first; r < last; ++ r)
+    {
+      i = self->upper.rows[r];
+      sum = x[i];
+      for (p = diag[i]+1; p < offsets[i+1]; ++ p)
+        sum -= values[p]*x[indicies[p]];
+      x[i] = sum/values[diag[i]];
+    }
+  }
+}
+
+void sp_matrix_yale_ilu_free(sp_matrix_yale_ilu_ptr self)
+{
+  if (self->LU.offsets)
+    sp_matrix_yale_free(&self->LU);
+  if (self->diag) spfree(self->diag);
+  sp_level_schedule_free(&self->lower);
+  sp_level_schedule_free(&self->upper);
+  memset(self,0,sizeof(sp_matrix_yale_ilu));
+}
+
+
+static int int_compare(const void* a, const void* b)
+{
+  return *(const int*)a - *(const int*)b;
+}
+
+/*
+ * Moves the count elements of rows with the largest absolute values
+ * of w[row] to the beginning of rows (quickselect)
+ */
+static void sp_select_largest(int* rows, int size, int count, double* w)
+{
+  int first = 0, last = size - 1;
+  int i,j,t;
+  double pivot;
+  while (first < last)
+  {
+    pivot = fabs(w[rows[(first + last)/2]]);
+    i = first;
+    j = last;
+    while (i <= j)
+    {
+      while (fabs(w[rows[i]]) > pivot) ++ i;
+      while (fabs(w[rows[j]]) < pivot) -- j;
+      if (i <= j)
+      {
+        t = rows[i]; rows[i] = rows[j]; rows[j] = t;
+        ++ i;
+        -- j;
+      }
+    }
+    if (count - 1 <= j)
+      last = j;
+    else if (count - 1 >= i)
+      first = i;
+    else
+      break;
+  }
+}
+
+/*
+ * Left-looking incomplete Cholesky decomposition.
+ * threshold - if 0 the portrait of L is the lower triangle of A (IC(0)),
+ * otherwise fill-in is allowed with dropping by tau and fill
+ * Returns nonzero if successfull
+ */
+static int sp_matrix_yale_ic_factor(sp_matrix_yale_ic_ptr self,
+                                    sp_matrix_yale_ptr A,
+                                    int threshold,
+                                    double tau,
+                                    int fill)
+{
+  int i,j,k,p,q,count,kept,next_k;
+  int n = A->rows_count;
+  int nonzeros = 0, capacity = 0;
+  int *Lp, *Li, *marker, *rows, *head, *next, *cursor;
+  double *Lx, *w;
+  double d,l_jk,norm;
+  memset(self,0,sizeof(sp_matrix_yale_ic));
+  /* lower triangle of the symmetric matrix, CRS arrays are the same */
+  for (j = 0; j < n; ++ j)
+    for (p = A->offsets[j]; p < A->offsets[j+1]; ++ p)
+      if (A->indicies[p] >= j)
+        capacity++;
+  capacity += n + (threshold ? n*fill : 0);
+  Lp = spalloc((n+1)*sizeof(int));
+  Li = spalloc(capacity*sizeof(int));
+  Lx = spalloc(capacity*sizeof(double));
+  w = spcalloc(n ? n : 1,sizeof(double));
+  marker = spalloc((n ? n : 1)*sizeof(int));
+  rows = spalloc((n ? n : 1)*sizeof(int));
+  head = spalloc((n ? n : 1)*sizeof(int));
+  next = spalloc((n ? n : 1)*sizeof(int));
+  cursor = spalloc((n ? n : 1)*sizeof(int));
+  for (i = 0; i < n; ++ i)
+  {
+    marker[i] = -1;
+    head[i] = -1;
+  }
+  for (j = 0; j < n; ++ j)
+  {
+    Lp[j] = nonzeros;
+    /* scatter A(j:n,j), the diagonal is first in rows */
+    marker[j] = j;
+    w[j] = 0;
+    rows[0] = j;
+    count = 1;
+    norm = 0;
+    for (p = A->offsets[j]; p < A->offsets[j+1]; ++ p)
+      if ((i = A->indicies[p]) >= j)
+      {
+        if (marker[i] != j)
+        {
+          marker[i] = j;
+          rows[count++] = i;
+        }
+        w[i] = A->values[p];
+        norm += A->values[p]*A->values[p];
+      }
+    kept = count - 1 + fill;
+    /* updates by columns k with L(j,k) != 0 */
+    k = head[j];
+    while (k != -1)
+    {
+      next_k = next[k];
+      p = cursor[k];
+      l_jk = Lx[p];
+      for (q = p; q < Lp[k+1]; ++ q)
+      {
+        i = Li[q];
+        if (marker[i] != j)
+        {
+          /* IC(0): fill-in is dropped */
+          if (!threshold)
+            continue;
+          marker[i] = j;
+          w[i] = 0;
+          rows[count++] = i;
+        }
+        w[i] -= Lx[q]*l_jk;
+      }
+      /* link the column k to its next row */
+      if (++p < Lp[k+1])
+      {
+        cursor[k] = p;
+        next[k] = head[Li[p]];
+        head[Li[p]] = k;
+      }
+      k = next_k;
+    }
+    d = w[j];
+    if (d <= 0)
+    {
+      LOGERROR("Incomplete Cholesky decomposition: nonpositive pivot"
+               " %e in %d column",d,j);
+      break;
+    }
+    d = sqrt(d);
+    if (threshold)
+    {
+      /* drop small elements, then keep the largest */
+      norm = tau*sqrt(norm);
+      for (p = 1, q = 1; p < count; ++ p)
+        if (fabs(w[rows[p]]) >= norm)
+          rows[q++] = rows[p];
+      count = q;
+      if (count - 1 > kept)
+      {
+        sp_select_largest(rows+1,count-1,kept,w);
+        count = kept + 1;
+      }
+    }
+    qsort(rows+1,count-1,sizeof(int),int_compare);
+    if (nonzeros + count > capacity)
+    {
+      capacity = 2*capacity + count;
+      Li = sprealloc(Li,capacity*sizeof(int));
+      Lx = sprealloc(Lx,capacity*sizeof(double));
+    }
+    Li[nonzeros] = j;
+    Lx[nonzeros++] = d;
+    for (p = 1; p < count; ++ p)
+    {
+      Li[nonzeros] = rows[p];
+      Lx[nonzeros++] = w[rows[p]]/d;
+    }
+    /* link the column j to its first off-diagonal row */
+    if (count > 1)
+    {
+      cursor[j] = Lp[j] + 1;
+      next[j] = head[rows[1]];
+      head[rows[1]] = j;
+    }
+  }
+  spfree(w);
+  spfree(marker);
+  spfree(rows);
+  spfree(head);
+  spfree(next);
+  spfree(cursor);
+  if (j < n)
+  {
+    spfree(Lp);
+    spfree(Li);
+    spfree(Lx);
+    return 0;
+  }
+  Lp[n] = nonzeros;
+  self->L.storage_type = CCS;
+  self->L.rows_count = n;
+  self->L.cols_count = n;
+  self->L.nonzeros = nonzeros;
+  self->L.offsets = Lp;
+  self->L.indicies = sprealloc(Li,(nonzeros ? nonzeros : 1)*sizeof(int));
+  self->L.values = sprealloc(Lx,(nonzeros ? nonzeros : 1)*sizeof(double));
+  self->y = spalloc((n ? n : 1)*sizeof(double));
+  sp_level_schedule_init(&self->schedule,n,Lp,self->L.indicies,CCS);
+  return 1;
+}
+
+int sp_matrix_yale_ic0_init(sp_matrix_yale_ic_ptr self,
+                            sp_matrix_yale_ptr A)
+{
+  return sp_matrix_yale_ic_factor(self,A,0,0,0);
+}
+
+int sp_matrix_yale_ict_init(sp_matrix_yale_ic_ptr self,
+                            sp_matrix_yale_ptr A,
+                            double tau,
+                            int fill)
+{
+  return sp_matrix_yale_ic_factor(self,A,1,tau,fill > 0 ? fill : 0);
+}
+
+void sp_matrix_yale_ic_solve(sp_matrix_yale_ic_ptr self,
+                             double* b,
+                             double* x)
+{
+  /* L*y = b, L'*x = y */
+  sp_matrix_yale_lower_solve_scheduled(&self->L,&self->schedule,b,self->y);
+  sp_matrix_yale_lower_trans_solve_scheduled(&self->L,&self->schedule,
+                                             self->y,x);
+}
+
+void sp_matrix_yale_ic_free(sp_matrix_yale_ic_ptr self)
+{
+  if (self->L.offsets)
+    sp_matrix_yale_free(&self->L);
+  if (self->y) spfree(self->y);
+  sp_level_schedule_free(&self->schedule);
+  memset(self,0,sizeof(sp_matrix_yale_ic));
+}
+
+
+/* adds value to the binary min-heap of size elements */
+static void sp_heap_push(int* heap, int* size, int value)
+{
+  int i = (*size)++;
+  while (i > 0 && heap[(i-1)/2] > value)
+  {
+    heap[i] = heap[(i-1)/2];
+    i = (i-1)/2;
+  }
+  heap[i] = value;
+}
+
+/* removes and returns the minimum value from the binary min-heap */
+static int sp_heap_pop(int* heap, int* size)
+{
+  int result = heap[0];
+  int value = heap[--(*size)];
+  int i = 0, child;
+  while ((child = 2*i+1) < *size)
+  {
+    if (child + 1 < *size && heap[child+1] < heap[child])
+      child++;
+    if (heap[child] >= value)
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = value;
+  return result;
+}
+
+int sp_matrix_yale_ilut_init(sp_matrix_yale_ilu_ptr self,
+                             sp_matrix_yale_ptr A,
+                             double tau,
+                             int fill)
+{
+  int result = 1;
+  int i,j,k,p,q,nl,nu,nk,count;
+  int n = A->rows_count;
+  int nonzeros = 0, capacity;
+  int *Lp, *Li, *diag, *marker, *heap, *lower, *upper;
+  double *Lx, *w;
+  double norm,drop;
+  sp_matrix_yale C;
+  memset(self,0,sizeof(sp_matrix_yale_ilu));
+  /* rows of the matrix */
+  if (!sp_matrix_yale_convert(A,&C,CRS))
+    C = *A;
+  fill = fill > 0 ? fill : 0;
+  capacity = C.nonzeros + n;
+  Lp = spalloc((n+1)*sizeof(int));
+  Li = spalloc(capacity*sizeof(int));
+  Lx = spalloc(capacity*sizeof(double));
+  diag = spalloc((n ? n : 1)*sizeof(int));
+  w = spalloc((n ? n : 1)*sizeof(double));
+  marker = spalloc((n ? n : 1)*sizeof(int));
+  heap = spalloc((n ? n : 1)*sizeof(int));
+  lower = spalloc((n ? n : 1)*sizeof(int));
+  upper = spalloc((n ? n : 1)*sizeof(int));
+  for (i = 0; i < n; ++ i)
+    marker[i] = -1;
+  /*
+   * ILUT(p,tau):
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * page 307
+   */
+  for (i = 0; i < n && result; ++ i)
+  {
+    Lp[i] = nonzeros;
+    /* sparse accumulator: the dense row w and lists of its portrait */
+    marker[i] = i;
+    w[i] = 0;
+    nl = nu = 0;
+    norm = 0;
+    for (p = C.offsets[i]; p < C.offsets[i+1]; ++ p)
+    {
+      j = C.indicies[p];
+      if (marker[j] != i)
+      {
+        marker[j] = i;
+        if (j < i)
+          sp_heap_push(heap,&nl,j);
+        else
+          upper[nu++] = j;
+      }
+      w[j] = C.values[p];
+      norm += C.values[p]*C.values[p];
+    }
+    norm = sqrt(norm);
+    drop = tau*norm;
+    /* elimination by rows k < i in increasing order */
+    nk = 0;
+    while (nl)
+    {
+      k = sp_heap_pop(heap,&nl);
+      /* the drop test uses the unscaled value l_ik*u_kk, since the
+       * multiplier itself does not scale with the row norm */
+      if (fabs(w[k]) < drop)
+      {
+        w[k] = 0;
+        continue;
+      }
+      w[k] /= Lx[diag[k]];
+      lower[nk++] = k;
+      for (q = diag[k]+1; q < Lp[k+1]; ++ q)
+      {
+        j = Li[q];
+        if (marker[j] != i)
+        {
+          marker[j] = i;
+          w[j] = 0;
+          if (j < i)
+            sp_heap_push(heap,&nl,j);
+          else
+            upper[nu++] = j;
+        }
+        w[j] -= w[k]*Lx[q];
+      }
+    }
+    /* dropping: small elements, then all except fill largest */
+    for (p = 0, q = 0; p < nu; ++ p)
+      if (upper[p] != i && fabs(w[upper[p]]) >= drop)
+        upper[q++] = upper[p];
+    nu = q;
+    if (nk > fill)
+    {
+      sp_select_largest(lower,nk,fill,w);
+      nk = fill;
+    }
+    if (nu > fill)
+    {
+      sp_select_largest(upper,nu,fill,w);
+      nu = fill;
+    }
+    qsort(lower,nk,sizeof(int),int_compare);
+    qsort(upper,nu,sizeof(int),int_compare);
+    /* zero pivot is replaced by the small value */
+    if (w[i] == 0)
+      w[i] = (1e-4 + tau)*norm;
+    if (w[i] == 0)
+    {
+      LOGERROR("ILUT decomposition: zero row %d",i);
+      result = 0;
+      break;
+    }
+    /* store the row: L, diagonal, U */
+    count = nk + nu + 1;
+    if (nonzeros + count > capacity)
+    {
+      capacity = 2*capacity + count;
+      Li = sprealloc(Li,capacity*sizeof(int));
+      Lx = sprealloc(Lx,capacity*sizeof(double));
+    }
+    for (p = 0; p < nk; ++ p, ++ nonzeros)
+    {
+      Li[nonzeros] = lower[p];
+      Lx[nonzeros] = w[lower[p]];
+    }
+    diag[i] = nonzeros;
+    Li[nonzeros] = i;
+    Lx[nonzeros++] = w[i];
+    for (p = 0; p < nu; ++ p, ++ nonzeros)
+    {
+      Li[nonzeros] = upper[p];
+      Lx[nonzeros] = w[upper[p]];
+    }
+    Lp[i+1] = nonzeros;
+  }
+  if (C.offsets != A->offsets)
+    sp_matrix_yale_free(&C);
+  spfree(w);
+  spfree(marker);
+  spfree(heap);
+  spfree(lower);
+  spfree(upper);
+  if (!result)
+  {
+    spfree(Lp);
+    spfree(Li);
+    spfree(Lx);
+    spfree(diag);
+    return 0;
+  }
+  Lp[n] = nonzeros;
+  self->LU.storage_type = CRS;
+  self->LU.rows_count = n;
+  self->LU.cols_count = n;
+  self->LU.nonzeros = nonzeros;
+  self->LU.offsets = Lp;
+  self->LU.indicies = sprealloc(Li,(nonzeros ? nonzeros : 1)*sizeof(int));
+  self->LU.values = sprealloc(Lx,(nonzeros ? nonzeros : 1)*sizeof(double));
+  self->diag = diag;
+  sp_level_schedule_init(&self->lower,n,Lp,self->LU.indicies,CRS);
+  sp_level_schedule_init(&self->upper,n,Lp,self->LU.indicies,CCS);
+  return 1;
 }
 
 
@@ -382,335 +1797,1301 @@ void sp_matrix_skyline_ilu_lower_mv(sp_matrix_skyline_ilu_ptr self,
                                     double* y)
 {
   int i,j;
-  memset(y,0,sizeof(double)*self->parent.rows_count);
-  for (i = 0; i < self->parent.rows_count; ++ i)
+  memset(y,0,sizeof(double)*self->parent.rows_count);
+  for (i = 0; i < self->parent.rows_count; ++ i)
+  {
+    y[i] = x[i];
+    for (j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++ j)
+      y[i] += x[self->parent.jptr[j]]*self->ilu_lowertr[j];
+  }
+}
+
+void sp_matrix_skyline_ilu_upper_mv(sp_matrix_skyline_ilu_ptr self,
+                                    double* x,
+                                    double* y)
+{
+  int i,j;
+  memset(y,0,sizeof(double)*self->parent.rows_count);
+
+  for (i = 0; i < self->parent.rows_count; ++ i)
+    y[i] = x[i]*self->ilu_diag[i];
+  for (i = 0; i < self->parent.rows_count; ++ i)
+  {
+    for ( j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++j )
+      y[self->parent.jptr[j]] += x[i]*self->ilu_uppertr[j];
+  }
+}
+
+void sp_matrix_skyline_ilu_lower_solve(sp_matrix_skyline_ilu_ptr self,
+                                       double* b,
+                                       double* x)
+{
+  /* rows of L with unit diagonal */
+  sp_level_schedule_solve(&self->schedule,
+                          self->parent.iptr,self->parent.jptr,0,
+                          self->ilu_lowertr,0,1,b,x);
+}
+
+void sp_matrix_skyline_ilu_upper_solve(sp_matrix_skyline_ilu_ptr self,
+                                       double* b,
+                                       double* x)
+{
+  /* rows of U are columns of the lower portrait */
+  sp_level_schedule_solve(&self->schedule,
+                          self->schedule.offsets,self->schedule.indicies,
+                          self->schedule.positions,
+                          self->ilu_uppertr,self->ilu_diag,0,b,x);
+}
+
+
+static void sp_iter_tfqmr(sp_iter_solver_ptr solver,
+                          sp_matrix_yale_ptr self,
+                          sp_preconditioner_ptr precond,
+                          double* b,
+                          double* x0,
+                          double* x)
+{
+  /* Transpose-Free Quasi-Minimal Residual Algorithm */
+  /*
+   * Based on the book:
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * page 235
+   *
+   * With the right preconditioner M the method is applied to
+   * A*M^{-1}*y = b, x = M^{-1}*y
+   */
+
+  /* variables */
+  int i,m;
+  double alpha, beta;
+  double residn = 0;
+  double theta = 0, eta = 0;
+  double rho[2] = {0};
+  double tau;
+  int size = sizeof(double)*self->rows_count;
+  int msize = self->rows_count;
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  double c;
+  double* r = sp_iter_vector(solver,0);    /* residual */
+  double* r1 = sp_iter_vector(solver,1);   /* r^*_0 */
+  double* temp = sp_iter_vector(solver,2);
+  double* d = sp_iter_vector(solver,3);
+  double* v[2];
+  double* w = sp_iter_vector(solver,4);
+  double* u[2];
+  double* z = 0;          /* z = M^{-1}*u */
+  double* y = x;          /* solution of the preconditioned system */
+  
+  v[0] = sp_iter_vector(solver,5);
+  v[1] = sp_iter_vector(solver,6);
+  u[0] = sp_iter_vector(solver,7);
+  u[1] = sp_iter_vector(solver,8);
+  if (precond)
+  {
+    z = sp_iter_vector(solver,9);
+    y = sp_iter_vector(solver,10);
+    memset(y,0,size);
+  }
+
+  /* d = 0 */
+  memset(d,0,size);
+
+  /* x = x_0 */
+  memcpy(x,x0,size);
+
+  /* r_0 = b - A*x_0 */
+  sp_matrix_yale_mv(self,x0,r);
+  for ( i = 0; i < msize; ++ i)
+    r[i] = b[i] - r[i];
+
+  /* w_0 = r_0 */
+  memcpy(w,r,size);
+  /* u_0 = r_0 */
+  memcpy(u[1],r,size);
+  /* v_0 = A*u_0 */
+  sp_precond_mv(self,precond,u[1],z,v[1]);
+
+  tau = norm2(r,msize);
+  
+  /* choose r^*_0 that rho_0 = (r^*_0,r_0) != 0 */
+  memcpy(r1,r,size);
+  r1[0] = 1;
+  /* rho_0 = (r^*_0,r_0) */
+  rho[0] = rho[1] = prod(r1,r,msize);
+  /* QMR loop */
+  for ( m = 0; m < max_iterations; m ++ )
+  {
+    /* store values from previous iterations */
+    memcpy(u[0],u[1],size);
+    /* if m is even */
+    if ((m&1) == 0)
+    {
+
+      /* alpha_{m+1} = alpha_m = rho_m/(v_m,r^*_0) */
+      alpha = rho[1]/prod(v[1],r1,msize);
+      /* u_{m+1} = u_m - alpha_m*v_m */
+      for (i = 0; i < msize; ++ i)
+        u[1][i] = u[0][i]-alpha*v[1][i]; /* u from old ? shall be u[1] */
+    }
+
+    /* temp = A*u_m */
+    sp_precond_mv(self,precond,u[0],z,temp);
+
+    /* w_{m+1} = w_m - alpha_m*A*u_m */
+    for (i = 0; i < msize; ++ i)
+      w[i] -= alpha*temp[i];
+
+    /* d_{m+1} = u_m + (theta^2_m/alpha_m)*eta_m*d_m */
+    c = theta*theta/alpha*eta;
+    for (i = 0; i < msize; ++ i)
+      d[i] = u[0][i] + c*d[i];
+    
+    /* theta_{m+1} = norm2(w_{m+1})/tau_m */
+    theta = norm2(w,msize)/tau;
+
+    /* c_{m+1} = (1+theta^2_{m+1})^(-1/2) */
+    c = 1./sqrt(1+theta*theta);
+
+    /* tau_{m+1} = tau_m*theta_{m+1}*c_{m+1} */
+    tau *= theta*c;
+
+    /* eta_{m+1} = c^2_{m+1}*alpha_m */
+    eta = c*c*alpha;
+    
+    /* x_{m+1} = x_m+eta_{m+1}*d_{m+1} */
+    for (i = 0; i < msize; ++ i)
+      y[i] += eta*d[i];
+
+    /* check for convergence */
+    /*
+     * residual estimation:
+     * norm(b-A*x_m) <= sqrt(m+1)*tau_m
+     */
+    residn = sqrt(m+1)*tau;
+    if ( residn < tol )
+      break;
+
+    /* store values from previous iterations */
+    memcpy(v[0],v[1],size);
+    /* if m is odd */
+    if ( m&1 )
+    {
+      rho[0] = rho[1];
+      /* rho_{m+1} = w_{m+1}*r^*_0 */
+      rho[1] = prod(w,r1,msize);
+      /* beta_{m-1} = rho_{m+1}/rho_{m-1} */
+      beta = rho[1]/rho[0];
+      /* u_{m+1} = w_{m+1} + beta_{m-1}*u_m */
+      for (i = 0; i < msize; ++ i)
+        u[1][i] = w[i] + beta*u[1][i];
+      /* v_{m+1} = A*u_{m+1} + beta_{m-1}*(A*u_m+beta_{m-1}*v_{m-1}) */
+      for ( i = 0; i < msize; ++ i)
+        v[1][i] = beta*(temp[i]+beta*v[0][i]);
+      /* temp = A*u_{m+1} */
+      sp_precond_mv(self,precond,u[1],z,temp);
+      for (i = 0; i < msize; ++ i)
+        v[1][i] += temp[i];
+    }
+  }
+  /* x = x_0 + M^{-1}*y */
+  if (precond)
+  {
+    precond->apply(precond->state,y,z);
+    for (i = 0; i < msize; ++ i)
+      x[i] += z[i];
+  }
+  solver->stats.iterations = m;
+  solver->stats.residual = residn;
+}
+
+void sp_matrix_yale_solve_ptfqmr(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x)
+{
+  sp_iter_solve_once(ITER_TFQMR,self,precond,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
+}
+
+
+void sp_matrix_yale_solve_tfqmr(sp_matrix_yale_ptr self,
+                                double* b,
+                                double* x0,
+                                int* max_iter,
+                                double* tolerance,
+                                double* x)
+{
+  sp_matrix_yale_solve_ptfqmr(self,0,b,x0,max_iter,tolerance,x);
+}
+
+
+static void sp_iter_cgs(sp_iter_solver_ptr solver,
+                        sp_matrix_yale_ptr self,
+                        sp_preconditioner_ptr precond,
+                        double* b,
+                        double* x0,
+                        double* x)
+{
+  /* Conjugate Gradient Squared Algorithm */
+  /*
+   * Based on the book:
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * page 229
+   *
+   * With the right preconditioner M search directions are
+   * multiplied by M^{-1} before multiplication by A
+   */
+   
+  /* variables */
+  int i,j;
+  double alpha, beta,a1,a2;
+  double residn = 0;
+  int size = sizeof(double)*self->rows_count;
+  int msize = self->rows_count;
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  double* r = sp_iter_vector(solver,0);    /* residual */
+  double* r1 = sp_iter_vector(solver,1);   /* r^*_0 */
+  double* p = sp_iter_vector(solver,2);    /* search direction */
+  double* q = sp_iter_vector(solver,3);
+  double* u = sp_iter_vector(solver,4);
+  double* temp = sp_iter_vector(solver,5);
+  double* s = sp_iter_vector(solver,6);    /* u_j + q_j */
+  /* M^{-1}*p_j */
+  double* ph = precond ? sp_iter_vector(solver,7) : p;
+  /* M^{-1}*(u_j + q_j) */
+  double* sh = precond ? sp_iter_vector(solver,8) : s;
+
+  /* x = x_0 */
+  memcpy(x,x0,size);
+
+  /* r_0 = b - A*x_0 */
+  sp_matrix_yale_mv(self,x0,r);
+  for ( i = 0; i < msize; ++ i)
+    r[i] = b[i] - r[i];
+  /* r1 - arbitrary */
+  memcpy(r1,r,size);
+  r1[0] = 1;
+  
+  /* p_0 = r_0 */
+  memcpy(p,r,size);
+
+  /* u_0 = r_0 */
+  memcpy(u,r,size);
+  
+  /* CGS loop */
+  for ( j = 0; j < max_iterations; j ++ )
   {
-    y[i] = x[i];
-    for (j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++ j)
-      y[i] += x[self->parent.jptr[j]]*self->ilu_lowertr[j];
+    /* temp = A*M^{-1}*p_j */
+    if (precond)
+      precond->apply(precond->state,p,ph);
+    sp_matrix_yale_mv(self,ph,temp);
+    /* compute (r_j,r^*_0) and (A*p_j,r^*_0) */
+    a1 = prod(r,r1,msize);      /* (r_j,r^*_0) */
+    a2 = prod(temp,r1,msize);   /* (A*p_j,r^*_0) */
+    /*                  
+     *            (r_j,r^*_0) 
+     * alpha_j = -----------
+     *           (A*p_j,r^*_0)
+     */                     
+    alpha = a1/a2;              
+
+    /*
+     * q_j = u_j - alpha_j*A*p_j
+     */
+    for (i = 0; i < msize; ++ i)
+      q[i] = u[i] - alpha*temp[i];
+           
+    /* s = u_j+q_j */
+    for (i = 0; i < msize; ++ i)
+      s[i] = u[i] + q[i];
+    if (precond)
+      precond->apply(precond->state,s,sh);
+           
+    /* x_{j+1} = x_j+alpha_j*M^{-1}(u_j+q_j) */
+    for (i = 0; i < msize; ++ i)
+      x[i] += alpha*sh[i];
+
+    /* temp = A*M^{-1}*(u_j+q_j) */
+    sp_matrix_yale_mv(self,sh,temp);
+    
+    /* r_{j+1} = r_j-alpha_j*A*(u_j+q_j) */
+    for (i = 0; i < msize; ++ i)
+      r[i] -= alpha*temp[i]; 
+
+    /* check for convergence */
+    residn = norm2(r,msize);
+    if (residn < tol )
+      break;
+
+    /* compute (r_{j+1},r^*_0) */
+    a2 = prod(r,r1,msize);
+
+    /* b_j = (r_{j+1},r^*_0)/(r_j,r^*_0) */
+    beta = a2/a1;
+
+    /* u_{j+1} = r_{j+1} + b_j*q_j */
+    for (i = 0; i < msize; ++ i)
+      u[i] = r[i] + beta*q[i];
+    
+    /* p_{j+1} = u_{j+1} + beta_j*(q_j + b_j*p_j) */
+    for (i = 0; i < msize; ++ i)
+      p[i] = u[i] + beta*(q[i] + beta*p[i]);
   }
+  solver->stats.iterations = j;
+  solver->stats.residual = residn;
 }
 
-void sp_matrix_skyline_ilu_upper_mv(sp_matrix_skyline_ilu_ptr self,
-                                    double* x,
-                                    double* y)
+void sp_matrix_yale_solve_pcgs(sp_matrix_yale_ptr self,
+                               sp_preconditioner_ptr precond,
+                               double* b,
+                               double* x0,
+                               int* max_iter,
+                               double* tolerance,
+                               double* x)
+{
+  sp_iter_solve_once(ITER_CGS,self,precond,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_yale_solve_cgs(sp_matrix_yale_ptr self,
+                              double* b,
+                              double* x0,
+                              int* max_iter,
+                              double* tolerance,
+                              double* x)
+{
+  sp_matrix_yale_solve_pcgs(self,0,b,x0,max_iter,tolerance,x);
+}
+
+
+static void sp_iter_bicgstab(sp_iter_solver_ptr solver,
+                             sp_matrix_yale_ptr self,
+                             sp_preconditioner_ptr precond,
+                             double* b,
+                             double* x0,
+                             double* x)
 {
+  /* Biconjugate Gradient Stabilized Algorithm */
+  /*
+   * Based on the book:
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * page 234
+   *
+   * With the right preconditioner M search directions p_j and s_j
+   * are multiplied by M^{-1} before multiplication by A
+   */
   int i,j;
-  memset(y,0,sizeof(double)*self->parent.rows_count);
+  double alpha, beta, omega, rho, rho1, a1;
+  double residn = 0;
+  int msize = self->rows_count;
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  double* r  = sp_iter_vector(solver,0); /* residual */
+  double* r1 = sp_iter_vector(solver,1); /* r^*_0 */
+  double* p  = sp_iter_vector(solver,2); /* direction */
+  double* v  = sp_iter_vector(solver,3); /* A*M^{-1}*p */
+  double* s  = sp_iter_vector(solver,4);
+  double* t  = sp_iter_vector(solver,5); /* A*M^{-1}*s */
+  double* ph = precond ? sp_iter_vector(solver,6) : p;
+  double* sh = precond ? sp_iter_vector(solver,7) : s;
+
+  /* x = x_0, r_0 = b - A*x_0 */
+  memcpy(x,x0,msize*sizeof(double));
+  sp_matrix_yale_mv(self,x0,r);
+  for (i = 0; i < msize; ++ i)
+    r[i] = b[i] - r[i];
+  memcpy(r1,r,msize*sizeof(double));
+  memcpy(p,r,msize*sizeof(double));
+  rho = prod(r,r1,msize);
+  residn = norm2(r,msize);
+  
+  for (j = 0; j < max_iterations && residn >= tol; ++ j)
+  {
+    /* v = A*M^{-1}*p_j */
+    if (precond)
+      precond->apply(precond->state,p,ph);
+    sp_matrix_yale_mv(self,ph,v);
+    a1 = prod(v,r1,msize);
+    if (a1 == 0)
+      break;
+    /* alpha_j = (r_j,r^*_0)/(A*p_j,r^*_0) */
+    alpha = rho/a1;
+    /* s_j = r_j - alpha_j*A*p_j */
+    for (i = 0; i < msize; ++ i)
+      s[i] = r[i] - alpha*v[i];
+    residn = norm2(s,msize);
+    if (residn < tol)
+    {
+      for (i = 0; i < msize; ++ i)
+        x[i] += alpha*ph[i];
+      ++ j;
+      break;
+    }
+    /* t = A*M^{-1}*s_j */
+    if (precond)
+      precond->apply(precond->state,s,sh);
+    sp_matrix_yale_mv(self,sh,t);
+    /* omega_j = (A*s_j,s_j)/(A*s_j,A*s_j) */
+    a1 = prod(t,t,msize);
+    omega = a1 != 0 ? prod(t,s,msize)/a1 : 0;
+    /* x_{j+1} = x_j + alpha_j*M^{-1}*p_j + omega_j*M^{-1}*s_j */
+    for (i = 0; i < msize; ++ i)
+      x[i] += alpha*ph[i] + omega*sh[i];
+    /* r_{j+1} = s_j - omega_j*A*s_j */
+    for (i = 0; i < msize; ++ i)
+      r[i] = s[i] - omega*t[i];
+    residn = norm2(r,msize);
+    rho1 = prod(r,r1,msize);
+    /* breakdown of the method */
+    if (omega == 0 || rho1 == 0)
+    {
+      ++ j;
+      break;
+    }
+    /* beta_j = (r_{j+1},r^*_0)/(r_j,r^*_0) * alpha_j/omega_j */
+    beta = rho1/rho*alpha/omega;
+    rho = rho1;
+    /* p_{j+1} = r_{j+1} + beta_j*(p_j - omega_j*A*p_j) */
+    for (i = 0; i < msize; ++ i)
+      p[i] = r[i] + beta*(p[i] - omega*v[i]);
+  }
+  solver->stats.iterations = j;
+  solver->stats.residual = residn;
+}
 
-  for (i = 0; i < self->parent.rows_count; ++ i)
-    y[i] = x[i]*self->ilu_diag[i];
-  for (i = 0; i < self->parent.rows_count; ++ i)
+void sp_matrix_yale_solve_pbicgstab(sp_matrix_yale_ptr self,
+                                    sp_preconditioner_ptr precond,
+                                    double* b,
+                                    double* x0,
+                                    int* max_iter,
+                                    double* tolerance,
+                                    double* x)
+{
+  sp_iter_solve_once(ITER_BICGSTAB,self,precond,0,GMRES_MGS,
+                     b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_yale_solve_bicgstab(sp_matrix_yale_ptr self,
+                                   double* b,
+                                   double* x0,
+                                   int* max_iter,
+                                   double* tolerance,
+                                   double* x)
+{
+  sp_matrix_yale_solve_pbicgstab(self,0,b,x0,max_iter,tolerance,x);
+}
+
+/*
+ * Orthogonalizes the vector w against the columns 0..j of the
+ * Krylov basis V (leading dimension ld) and writes the projections
+ * to h. Modified Gram-Schmidt subtracts projections one by one,
+ * classical Gram-Schmidt with reorthogonalization (CGS2) calculates
+ * all projections at once and repeats the process twice
+ */
+static void sp_gmres_orthogonalize(sp_gmres_orthogonalization type,
+                                   double* V,
+                                   int ld,
+                                   int size,
+                                   int j,
+                                   double* w,
+                                   double* h,
+                                   double* c)
+{
+  int i,k,pass;
+  if (type == GMRES_MGS)
+  {
+    for (i = 0; i <= j; ++ i)
+    {
+      h[i] = prod(V+i*ld,w,size);
+      for (k = 0; k < size; ++ k)
+        w[k] -= h[i]*V[i*ld+k];
+    }
+    return;
+  }
+  for (i = 0; i <= j; ++ i)
+    h[i] = 0;
+  for (pass = 0; pass < 2; ++ pass)
+  {
+    /* c = V'*w, w = w - V*c */
+    for (i = 0; i <= j; ++ i)
+      c[i] = prod(V+i*ld,w,size);
+    for (i = 0; i <= j; ++ i)
+    {
+      for (k = 0; k < size; ++ k)
+        w[k] -= c[i]*V[i*ld+k];
+      h[i] += c[i];
+    }
+  }
+}
+
+static void sp_iter_gmres(sp_iter_solver_ptr solver,
+                          sp_matrix_yale_ptr self,
+                          sp_preconditioner_ptr precond,
+                          double* b,
+                          double* x0,
+                          double* x)
+{
+  /* Restarted Generalized Minimal Residual Algorithm */
+  /*
+   * Based on the book:
+   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
+   * pages 172, 284
+   *
+   * Right preconditioned GMRES(m) minimizes the true residual
+   * norm(b-A*x) with x = x_0 + M^{-1}*V_m*y_m.
+   * The Hessenberg matrix is reduced to the upper triangular one by
+   * Givens rotations, so the residual norm is known on every step
+   */
+  int i,j,k,iter = 0;
+  int m = sp_iter_restart(&solver->options);
+  int msize = self->rows_count;
+  /* columns of the basis are aligned to the cache line */
+  int ld = solver->ld;
+  int max_iterations = solver->options.max_iter;
+  double tol = solver->options.tolerance;
+  sp_gmres_orthogonalization type = solver->options.orthogonalization;
+  double residn, beta, t;
+  double* V = sp_iter_vector(solver,0);    /* basis */
+  double* z = sp_iter_vector(solver,m+1);  /* M^{-1}*v */
+  double* H = solver->small;               /* Hessenberg, by columns */
+  double* cs = H + (m+1)*m;                /* Givens rotations */
+  double* sn = cs + m;
+  double* g = sn + m;                      /* rotated beta*e_1 */
+  double* c = g + m + 1;                   /* workspace for CGS2 */
+  double* h;
+
+  memcpy(x,x0,msize*sizeof(double));
+  while (1)
+  {
+    /* r_0 = b - A*x_0, v_0 = r_0/norm(r_0) */
+    sp_matrix_yale_mv(self,x,V);
+    for (i = 0; i < msize; ++ i)
+      V[i] = b[i] - V[i];
+    residn = beta = norm2(V,msize);
+    if (residn < tol || iter >= max_iterations)
+      break;
+    for (i = 0; i < msize; ++ i)
+      V[i] /= beta;
+    memset(g,0,(m+1)*sizeof(double));
+    g[0] = beta;
+    /* Arnoldi process */
+    for (j = 0; j < m && iter < max_iterations; ++ j)
+    {
+      ++ iter;
+      h = H + j*(m+1);
+      /* v_{j+1} = A*M^{-1}*v_j orthogonalized by v_0..v_j */
+      sp_precond_mv(self,precond,V+j*ld,z,V+(j+1)*ld);
+      sp_gmres_orthogonalize(type,V,ld,msize,j,V+(j+1)*ld,h,c);
+      h[j+1] = norm2(V+(j+1)*ld,msize);
+      if (h[j+1] != 0)
+        for (i = 0; i < msize; ++ i)
+          V[(j+1)*ld+i] /= h[j+1];
+      /* apply previous rotations to the new column of H */
+      for (i = 0; i < j; ++ i)
+      {
+        t = cs[i]*h[i] + sn[i]*h[i+1];
+        h[i+1] = -sn[i]*h[i] + cs[i]*h[i+1];
+        h[i] = t;
+      }
+      /* rotation eliminating h_{j+1,j} */
+      t = sqrt(h[j]*h[j] + h[j+1]*h[j+1]);
+      cs[j] = t != 0 ? h[j]/t : 1;
+      sn[j] = t != 0 ? h[j+1]/t : 0;
+      h[j] = t;
+      h[j+1] = 0;
+      g[j+1] = -sn[j]*g[j];
+      g[j] *= cs[j];
+      residn = fabs(g[j+1]);
+      if (residn < tol)
+      {
+        ++ j;
+        break;
+      }
+    }
+    /* y = R^{-1}*g stored in g, x = x + M^{-1}*V*y */
+    for (i = j-1; i >= 0; -- i)
+    {
+      for (k = i+1; k < j; ++ k)
+        g[i] -= H[k*(m+1)+i]*g[k];
+      g[i] = H[i*(m+1)+i] != 0 ? g[i]/H[i*(m+1)+i] : 0;
+    }
+    memset(z,0,msize*sizeof(double));
+    for (i = 0; i < j; ++ i)
+      for (k = 0; k < msize; ++ k)
+        z[k] += g[i]*V[i*ld+k];
+    if (precond)
+    {
+      /* V_{m} is not needed anymore: its first column is a workspace */
+      precond->apply(precond->state,z,V);
+      for (k = 0; k < msize; ++ k)
+        x[k] += V[k];
+    }
+    else
+      for (k = 0; k < msize; ++ k)
+        x[k] += z[k];
+    if (residn < tol)
+      break;
+  }
+  solver->stats.iterations = iter;
+  solver->stats.residual = residn;
+}
+
+void sp_matrix_yale_solve_pgmres(sp_matrix_yale_ptr self,
+                                 sp_preconditioner_ptr precond,
+                                 int restart,
+                                 sp_gmres_orthogonalization type,
+                                 double* b,
+                                 double* x0,
+                                 int* max_iter,
+                                 double* tolerance,
+                                 double* x)
+{
+  sp_iter_solve_once(ITER_GMRES,self,precond,restart,type,
+                     b,x0,max_iter,tolerance,x);
+}
+
+void sp_matrix_yale_solve_gmres(sp_matrix_yale_ptr self,
+                                int restart,
+                                double* b,
+                                double* x0,
+                                int* max_iter,
+                                double* tolerance,
+                                double* x)
+{
+  sp_matrix_yale_solve_pgmres(self,0,restart,GMRES_MGS,
+                              b,x0,max_iter,tolerance,x);
+}
+
+/*
+ * Number of power iterations used to estimate the largest eigenvalue
+ * of D^{-1}A on every level of the algebraic multigrid
+ */
+#define SP_AMG_POWER_ITERATIONS 15
+/*
+ * Ratio of the largest and the smallest eigenvalues of D^{-1}A
+ * damped by the Chebyshev smoother
+ */
+#define SP_AMG_CHEBYSHEV_RATIO 30
+
+/*
+ * Calculates the inverted diagonal of the level operator and
+ * the estimate of the largest eigenvalue of D^{-1}A:
+ * 1.1 times the Rayleigh quotient after power iterations,
+ * but not more than the Gershgorin bound
+ * Returns 0 if nonpositive diagonal element found
+ */
+static int sp_amg_level_diag(sp_amg_level* level, int l)
+{
+  int i,k,p;
+  unsigned int seed;
+  sp_matrix_yale_ptr A = &level->A;
+  int n = A->rows_count;
+  double *dinv = level->dinv, *v = level->r, *w = level->w;
+  double bound = 0, sum, vAv, vDv;
+  for (i = 0; i < n; ++ i)
+  {
+    dinv[i] = 0;
+    for (sum = 0, p = A->offsets[i]; p < A->offsets[i+1]; ++ p)
+    {
+      if (A->indicies[p] == i)
+        dinv[i] += A->values[p];
+      sum += fabs(A->values[p]);
+    }
+    if (dinv[i] <= 0)
+    {
+      LOGERROR("AMG: nonpositive diagonal element in %d row of level %d",
+               i,l);
+      return 0;
+    }
+    dinv[i] = 1/dinv[i];
+    bound = FMAX(bound,sum*dinv[i]);
+  }
+  /* power iterations v = D^{-1}Av */
+  /* pseudo-random start to contain all eigenvectors */
+  for (seed = 1, i = 0; i < n; ++ i)
+  {
+    seed = (seed*1103515245u + 12345u) & 0x7fffffffu;
+    v[i] = (double)seed/0x7fffffff - 0.5;
+  }
+  vAv = vDv = 0;
+  for (k = 0; k < SP_AMG_POWER_ITERATIONS; ++ k)
+  {
+    sp_matrix_yale_mv(A,v,w);
+    for (vAv = 0, vDv = 0, i = 0; i < n; ++ i)
+    {
+      vAv += v[i]*w[i];
+      vDv += v[i]*v[i]/dinv[i];
+    }
+    sum = norm2(w,n);
+    if (sum == 0)
+      break;
+    for (i = 0; i < n; ++ i)
+      v[i] = dinv[i]*w[i]/sum;
+  }
+  level->lambda = bound;
+  if (vDv > 0 && 1.1*vAv/vDv < bound)
+    level->lambda = 1.1*vAv/vDv;
+  return 1;
+}
+
+/*
+ * Strength of connection between i and the column of p-th element:
+ * a_ij^2 >= theta^2*a_ii*a_jj
+ */
+static int sp_amg_strong(sp_amg_level* level, double theta, int i, int p)
+{
+  int j = level->A.indicies[p];
+  double a = level->A.values[p];
+  return j != i && a != 0 &&
+    a*a*level->dinv[i]*level->dinv[j] >= theta*theta;
+}
+
+/*
+ * Aggregation of the nodes of the level by the strength graph:
+ * 1. nodes with all strong neighbours free form aggregates
+ * with these neighbours;
+ * 2. remaining nodes join the aggregate of the strongest neighbour
+ * aggregated on the first pass;
+ * 3. the rest form aggregates with their free strong neighbours.
+ * Vanek P., Mandel J., Brezina M. Algebraic multigrid by smoothed
+ * aggregation for second and fourth order elliptic problems (1996)
+ * Returns the number of aggregates
+ */
+static int sp_amg_aggregate(sp_amg_level* level,
+                            double theta,
+                            int* aggregates)
+{
+  int i,j,p,best,count = 0;
+  int n = level->A.rows_count;
+  int *offsets = level->A.offsets, *indicies = level->A.indicies;
+  double strength;
+  for (i = 0; i < n; ++ i)
+    aggregates[i] = -1;
+  /* 1. roots */
+  for (i = 0; i < n; ++ i)
+  {
+    if (aggregates[i] != -1)
+      continue;
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      if (sp_amg_strong(level,theta,i,p) && aggregates[indicies[p]] != -1)
+        break;
+    if (p != offsets[i+1])
+      continue;
+    aggregates[i] = count;
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      if (sp_amg_strong(level,theta,i,p))
+        aggregates[indicies[p]] = count;
+    count ++;
+  }
+  /*
+   * 2. nodes joined on this pass are marked as -2-aggregate
+   * not to be taken as neighbours aggregated on the first pass
+   */
+  for (i = 0; i < n; ++ i)
+  {
+    if (aggregates[i] != -1)
+      continue;
+    for (best = -1, strength = 0, p = offsets[i]; p < offsets[i+1]; ++ p)
+    {
+      j = indicies[p];
+      if (sp_amg_strong(level,theta,i,p) && aggregates[j] >= 0 &&
+          fabs(level->A.values[p]) > strength)
+      {
+        best = aggregates[j];
+        strength = fabs(level->A.values[p]);
+      }
+    }
+    if (best != -1)
+      aggregates[i] = -2 - best;
+  }
+  for (i = 0; i < n; ++ i)
+    if (aggregates[i] < -1)
+      aggregates[i] = -2 - aggregates[i];
+  /* 3. remaining nodes */
+  for (i = 0; i < n; ++ i)
+  {
+    if (aggregates[i] != -1)
+      continue;
+    aggregates[i] = count;
+    for (p = offsets[i]; p < offsets[i+1]; ++ p)
+      if (sp_amg_strong(level,theta,i,p) && aggregates[indicies[p]] == -1)
+        aggregates[indicies[p]] = count;
+    count ++;
+  }
+  return count;
+}
+
+/*
+ * Creates the smoothed prolongation P = (I - omega*D^{-1}A)*T and the
+ * restriction R = P' of the level, where T is the tentative
+ * prolongation interpolating constants on count aggregates
+ * (columns of T are normalized), omega = 4/(3*lambda)
+ */
+static void sp_amg_prolongation(sp_amg_level* level,
+                                int* aggregates,
+                                int count)
+{
+  int i,p;
+  int n = level->A.rows_count;
+  double omega = 4/(3*level->lambda);
+  double* sizes = spcalloc(count,sizeof(double));
+  sp_matrix_yale T;
+  T.storage_type = CRS;
+  T.rows_count = n;
+  T.cols_count = count;
+  T.nonzeros = n;
+  T.offsets = spalloc((n+1)*sizeof(int));
+  T.indicies = memdup(aggregates,n*sizeof(int));
+  T.values = spalloc((n ? n : 1)*sizeof(double));
+  for (i = 0; i < n; ++ i)
+    sizes[aggregates[i]] += 1;
+  for (i = 0; i < n; ++ i)
+  {
+    T.offsets[i] = i;
+    T.values[i] = 1/sqrt(sizes[aggregates[i]]);
+  }
+  T.offsets[n] = n;
+  /*
+   * A*T contains the element (i,aggregates[i]) since the
+   * diagonal of A is nonzero, therefore P has the portrait of A*T
+   */
+  sp_matrix_yale_mm(&level->A,&T,&level->P);
+  for (i = 0; i < n; ++ i)
+    for (p = level->P.offsets[i]; p < level->P.offsets[i+1]; ++ p)
+    {
+      level->P.values[p] *= -omega*level->dinv[i];
+      if (level->P.indicies[p] == aggregates[i])
+        level->P.values[p] += T.values[i];
+    }
+  sp_matrix_yale_transpose(&level->P,&level->R);
+  sp_matrix_yale_free(&T);
+  spfree(sizes);
+}
+
+/*
+ * Smoothing of the solution x of the level with the right-hand side b
+ * by damped Jacobi sweeps or by the Chebyshev polynomial of D^{-1}A
+ * on the interval [lambda/SP_AMG_CHEBYSHEV_RATIO, lambda].
+ * Both smoothers are symmetric in A-norm.
+ */
+static void sp_amg_smooth(sp_amg_ptr self,
+                          sp_amg_level* level,
+                          double* b,
+                          double* x)
+{
+  int i,k;
+  int n = level->A.rows_count;
+  double *r = level->r, *d = level->d, *w = level->w, *dinv = level->dinv;
+  double omega, theta, delta, sigma, rho, rho_new;
+  if (self->smoother == AMG_SMOOTHER_JACOBI)
+  {
+    omega = 4/(3*level->lambda);
+    for (k = 0; k < self->sweeps; ++ k)
+    {
+      sp_matrix_yale_mv(&level->A,x,w);
+      for (i = 0; i < n; ++ i)
+        x[i] += omega*dinv[i]*(b[i]-w[i]);
+    }
+    return;
+  }
+  /* Saad Y. Iterative methods for sparse linear systems, page 399 */
+  theta = level->lambda*(1 + 1./SP_AMG_CHEBYSHEV_RATIO)/2;
+  delta = level->lambda*(1 - 1./SP_AMG_CHEBYSHEV_RATIO)/2;
+  sigma = theta/delta;
+  rho = 1/sigma;
+  sp_matrix_yale_mv(&level->A,x,w);
+  for (i = 0; i < n; ++ i)
+  {
+    r[i] = dinv[i]*(b[i]-w[i]);
+    d[i] = r[i]/theta;
+  }
+  for (k = 0; ; ++ k)
+  {
+    for (i = 0; i < n; ++ i)
+      x[i] += d[i];
+    if (k == self->sweeps-1)
+      break;
+    sp_matrix_yale_mv(&level->A,d,w);
+    rho_new = 1/(2*sigma - rho);
+    for (i = 0; i < n; ++ i)
+    {
+      r[i] -= dinv[i]*w[i];
+      d[i] = rho_new*rho*d[i] + 2*rho_new/delta*r[i];
+    }
+    rho = rho_new;
+  }
+}
+
+/*
+ * V-cycle on the level l with zero initial approximation
+ */
+static void sp_amg_cycle(sp_amg_ptr self, int l, double* b, double* x)
+{
+  int i;
+  sp_amg_level* level = self->levels + l;
+  sp_amg_level* next = level + 1;
+  int n = level->A.rows_count;
+  if (l == self->levels_count - 1)
+  {
+    sp_chol_factor_solve(&self->coarse,b,x);
+    return;
+  }
+  memset(x,0,n*sizeof(double));
+  sp_amg_smooth(self,level,b,x);
+  /* restriction of the residual */
+  sp_matrix_yale_mv(&level->A,x,level->r);
+  for (i = 0; i < n; ++ i)
+    level->r[i] = b[i] - level->r[i];
+  sp_matrix_yale_mv(&level->R,level->r,next->b);
+  sp_amg_cycle(self,l+1,next->b,next->x);
+  /* coarse grid correction */
+  sp_matrix_yale_mv(&level->P,next->x,level->r);
+  for (i = 0; i < n; ++ i)
+    x[i] += level->r[i];
+  sp_amg_smooth(self,level,b,x);
+}
+
+int sp_amg_init(sp_amg_ptr self,
+                sp_matrix_yale_ptr A,
+                double theta,
+                sp_amg_smoother_type smoother,
+                int sweeps)
+{
+  int l,n,count;
+  int* aggregates;
+  sp_amg_level* level;
+  sp_matrix_yale AP;
+  memset(self,0,sizeof(sp_amg));
+  if (A->rows_count != A->cols_count)
+  {
+    LOGERROR("AMG: matrix shall be square");
+    return 0;
+  }
+  self->smoother = smoother;
+  self->sweeps = sweeps > 0 ? sweeps : 1;
+  /* operator of the finest level in CRS format */
+  if (!sp_matrix_yale_convert(A,&self->levels[0].A,CRS))
+    sp_matrix_yale_copy(A,&self->levels[0].A);
+  aggregates = spalloc((A->rows_count ? A->rows_count : 1)*sizeof(int));
+  for (l = 0; ; ++ l)
+  {
+    level = self->levels + l;
+    self->levels_count = l + 1;
+    n = level->A.rows_count;
+    if (l > 0)
+    {
+      level->b = spalloc(n*sizeof(double));
+      level->x = spalloc(n*sizeof(double));
+    }
+    if (n <= SP_AMG_COARSE_SIZE || l == SP_AMG_MAX_LEVELS - 1)
+      break;
+    level->dinv = spalloc(n*sizeof(double));
+    level->r = spalloc(n*sizeof(double));
+    level->d = spalloc(n*sizeof(double));
+    level->w = spalloc(n*sizeof(double));
+    if (!sp_amg_level_diag(level,l))
+    {
+      spfree(aggregates);
+      sp_amg_free(self);
+      return 0;
+    }
+    count = sp_amg_aggregate(level,theta,aggregates);
+    /* aggregation doesn't reduce the size: level becomes the coarsest */
+    if (count == n)
+      break;
+    /* Galerkin coarse operator R*A*P */
+    sp_amg_prolongation(level,aggregates,count);
+    sp_matrix_yale_mm(&level->A,&level->P,&AP);
+    sp_matrix_yale_mm(&level->R,&AP,&self->levels[l+1].A);
+    sp_matrix_yale_free(&AP);
+  }
+  spfree(aggregates);
+  /* direct solver on the coarsest level */
+  if (!sp_chol_factor_init(&self->coarse,&level->A,ORDER_NESTED_DISSECTION))
   {
-    for ( j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++j )
-      y[self->parent.jptr[j]] += x[i]*self->ilu_uppertr[j];
+    LOGERROR("AMG: Cholesky decomposition of the coarsest level failed");
+    sp_amg_free(self);
+    return 0;
   }
+  return 1;
 }
 
-void sp_matrix_skyline_ilu_lower_solve(sp_matrix_skyline_ilu_ptr self,
-                                       double* b,
-                                       double* x)
+void sp_amg_solve(sp_amg_ptr self, double* b, double* x)
 {
-  int i,j;
-  memset(x,0,sizeof(double)*self->parent.rows_count);
-  
-  for ( i = 0; i < self->parent.rows_count; ++ i)
-  {
-    for (j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++ j)
-      b[i] -= x[self->parent.jptr[j]]*self->ilu_lowertr[j];
-    x[i] = b[i];
-  }
+  sp_amg_cycle(self,0,b,x);
 }
 
-void sp_matrix_skyline_ilu_upper_solve(sp_matrix_skyline_ilu_ptr self,
-                                       double* b,
-                                       double* x)
+void sp_amg_free(sp_amg_ptr self)
 {
-  int i,j;
-  memset(x,0,sizeof(double)*self->parent.rows_count);
-
-  for ( i = self->parent.rows_count-1; i >= 0; -- i)
+  int l;
+  sp_amg_level* level;
+  for (l = 0; l < self->levels_count; ++ l)
   {
-    x[i] = b[i]/self->ilu_diag[i];
-    for (j = self->parent.iptr[i]; j < self->parent.iptr[i+1]; ++ j)
-      b[self->parent.jptr[j]] -= x[i]*self->ilu_uppertr[j];
+    level = self->levels + l;
+    if (level->A.offsets) sp_matrix_yale_free(&level->A);
+    if (level->P.offsets) sp_matrix_yale_free(&level->P);
+    if (level->R.offsets) sp_matrix_yale_free(&level->R);
+    if (level->dinv) spfree(level->dinv);
+    if (level->b) spfree(level->b);
+    if (level->x) spfree(level->x);
+    if (level->r) spfree(level->r);
+    if (level->d) spfree(level->d);
+    if (level->w) spfree(level->w);
   }
+  if (self->coarse.L.offsets)
+    sp_chol_factor_free(&self->coarse);
+  memset(self,0,sizeof(sp_amg));
 }
 
 
-void sp_matrix_yale_solve_tfqmr(sp_matrix_yale_ptr self,
-                                double* b,
-                                double* x0,
-                                int* max_iter,
-                                double* tolerance,
-                                double* x)
+/* State of the Jacobi preconditioner */
+typedef struct
 {
-  /* Transpose-Free Quasi-Minimal Residual Algorithm */
-  /*
-   * Based on the book:
-   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
-   * page 235
-   */
+  int size;
+  double* dinv;                 /* inverted diagonal of A */
+} sp_jacobi_state;
 
-  /* variables */
-  int i,m;
-  double alpha, beta;
-  double residn = 0;
-  double theta = 0, eta = 0;
-  double rho[2] = {0};
+/* State of the ILU(0) or ILUT preconditioner */
+typedef struct
+{
+  sp_matrix_yale_ilu ilu;
+  int threshold;                /* nonzero for ILUT */
   double tau;
-  int size = sizeof(double)*self->rows_count;
-  int msize = self->rows_count;
-  int max_iterations = *max_iter;
-  double tol = *tolerance;
-  double c;
-  double* r;              /* residual */
-  double* r1;              /* r^*_0 */
-  double* temp;
-  double* d;
-  double* v[2];
-  double* w;
-  double* u[2];
-  
-  /* allocate memory for vectors */
-  r = (double*)spalloc(size);
-  r1 = (double*)spalloc(size);
-  temp = (double*)spalloc(size);
-  d = (double*)spcalloc(msize,sizeof(double));
-  v[0] = (double*)spcalloc(msize,sizeof(double));
-  v[1] = (double*)spcalloc(msize,sizeof(double));
-  w = (double*)spcalloc(msize,sizeof(double));
-  u[0] = (double*)spcalloc(msize,sizeof(double));
-  u[1] = (double*)spcalloc(msize,sizeof(double));
+  int fill;
+} sp_ilu_state;
 
-  /* d = 0 */
-  memset(d,0,size);
-
-  /* x = x_0 */
-  memcpy(x,x0,size);
+/* State of the IC(0) or IC(tau) preconditioner */
+typedef struct
+{
+  sp_matrix_yale_ic ic;
+  int threshold;                /* nonzero for IC(tau) */
+  double tau;
+  int fill;
+} sp_ic_state;
 
-  /* r_0 = b - A*x_0 */
-  sp_matrix_yale_mv(self,x0,r);
-  for ( i = 0; i < msize; ++ i)
-    r[i] = b[i] - r[i];
+/* State of the algebraic multigrid preconditioner */
+typedef struct
+{
+  sp_amg amg;
+  double theta;
+  sp_amg_smoother_type smoother;
+  int sweeps;
+} sp_amg_state;
 
-  /* w_0 = r_0 */
-  memcpy(w,r,size);
-  /* u_0 = r_0 */
-  memcpy(u[1],r,size);
-  /* v_0 = A*u_0 */
-  sp_matrix_yale_mv(self,u[1],v[1]);
+static void sp_jacobi_clear(void* data)
+{
+  sp_jacobi_state* state = (sp_jacobi_state*)data;
+  if (state->dinv)
+    spfree(state->dinv);
+  state->dinv = 0;
+}
 
-  tau = norm2(r,msize);
-  
-  /* choose r^*_0 that rho_0 = (r^*_0,r_0) != 0 */
-  memcpy(r1,r,size);
-  r1[0] = 1;
-  /* rho_0 = (r^*_0,r_0) */
-  rho[0] = rho[1] = prod(r1,r,msize);
-  /* QMR loop */
-  for ( m = 0; m < max_iterations; m ++ )
+static int sp_jacobi_setup(void* data, sp_matrix_yale_ptr A)
+{
+  int i,p;
+  sp_jacobi_state* state = (sp_jacobi_state*)data;
+  int n = A->storage_type == CRS ? A->rows_count : A->cols_count;
+  sp_jacobi_clear(state);
+  state->size = n;
+  state->dinv = spcalloc(n ? n : 1,sizeof(double));
+  for (i = 0; i < n; ++ i)
+    for (p = A->offsets[i]; p < A->offsets[i+1]; ++ p)
+      if (A->indicies[p] == i)
+        state->dinv[i] += A->values[p];
+  for (i = 0; i < n; ++ i)
   {
-    /* store values from previous iterations */
-    memcpy(u[0],u[1],size);
-    /* if m is even */
-    if ((m&1) == 0)
+    if (state->dinv[i] == 0)
     {
-
-      /* alpha_{m+1} = alpha_m = rho_m/(v_m,r^*_0) */
-      alpha = rho[1]/prod(v[1],r1,msize);
-      /* u_{m+1} = u_m - alpha_m*v_m */
-      for (i = 0; i < msize; ++ i)
-        u[1][i] = u[0][i]-alpha*v[1][i]; /* u from old ? shall be u[1] */
+      LOGERROR("Jacobi preconditioner: zero diagonal element in %d row",i);
+      sp_jacobi_clear(state);
+      return 0;
     }
+    state->dinv[i] = 1/state->dinv[i];
+  }
+  return 1;
+}
 
-    /* temp = A*u_m */
-    sp_matrix_yale_mv(self,u[0],temp);
+static void sp_jacobi_apply(void* data, double* r, double* z)
+{
+  int i;
+  sp_jacobi_state* state = (sp_jacobi_state*)data;
+  for (i = 0; i < state->size; ++ i)
+    z[i] = state->dinv[i]*r[i];
+}
 
-    /* w_{m+1} = w_m - alpha_m*A*u_m */
-    for (i = 0; i < msize; ++ i)
-      w[i] -= alpha*temp[i];
+static void sp_jacobi_release(void* data)
+{
+  sp_jacobi_clear(data);
+  spfree(data);
+}
 
-    /* d_{m+1} = u_m + (theta^2_m/alpha_m)*eta_m*d_m */
-    c = theta*theta/alpha*eta;
-    for (i = 0; i < msize; ++ i)
-      d[i] = u[0][i] + c*d[i];
-    
-    /* theta_{m+1} = norm2(w_{m+1})/tau_m */
-    theta = norm2(w,msize)/tau;
+static void sp_ilu_clear(void* data)
+{
+  sp_ilu_state* state = (sp_ilu_state*)data;
+  if (state->ilu.LU.offsets)
+    sp_matrix_yale_ilu_free(&state->ilu);
+}
 
-    /* c_{m+1} = (1+theta^2_{m+1})^(-1/2) */
-    c = 1./sqrt(1+theta*theta);
+static int sp_ilu_setup(void* data, sp_matrix_yale_ptr A)
+{
+  sp_ilu_state* state = (sp_ilu_state*)data;
+  sp_ilu_clear(state);
+  return state->threshold ?
+    sp_matrix_yale_ilut_init(&state->ilu,A,state->tau,state->fill) :
+    sp_matrix_yale_ilu_init(&state->ilu,A);
+}
 
-    /* tau_{m+1} = tau_m*theta_{m+1}*c_{m+1} */
-    tau *= theta*c;
+static void sp_ilu_apply(void* data, double* r, double* z)
+{
+  sp_matrix_yale_ilu_solve(&((sp_ilu_state*)data)->ilu,r,z);
+}
 
-    /* eta_{m+1} = c^2_{m+1}*alpha_m */
-    eta = c*c*alpha;
-    
-    /* x_{m+1} = x_m+eta_{m+1}*d_{m+1} */
-    for (i = 0; i < msize; ++ i)
-      x[i] += eta*d[i];
+static void sp_ilu_release(void* data)
+{
+  sp_ilu_clear(data);
+  spfree(data);
+}
 
-    /* check for convergence */
-    /*
-     * residual estimation:
-     * norm(b-A*x_m) <= sqrt(m+1)*tau_m
-     */
-    residn = sqrt(m+1)*tau;
-    if ( residn < tol )
-      break;
+static void sp_ic_clear(void* data)
+{
+  sp_ic_state* state = (sp_ic_state*)data;
+  if (state->ic.L.offsets)
+    sp_matrix_yale_ic_free(&state->ic);
+}
 
-    /* store values from previous iterations */
-    memcpy(v[0],v[1],size);
-    /* if m is odd */
-    if ( m&1 )
-    {
-      rho[0] = rho[1];
-      /* rho_{m+1} = w_{m+1}*r^*_0 */
-      rho[1] = prod(w,r1,msize);
-      /* beta_{m-1} = rho_{m+1}/rho_{m-1} */
-      beta = rho[1]/rho[0];
-      /* u_{m+1} = w_{m+1} + beta_{m-1}*u_m */
-      for (i = 0; i < msize; ++ i)
-        u[1][i] = w[i] + beta*u[1][i];
-      /* v_{m+1} = A*u_{m+1} + beta_{m-1}*(A*u_m+beta_{m-1}*v_{m-1}) */
-      for ( i = 0; i < msize; ++ i)
-        v[1][i] = beta*(temp[i]+beta*v[0][i]);
-      /* temp = A*u_{m+1} */
-      sp_matrix_yale_mv(self,u[1],temp);
-      for (i = 0; i < msize; ++ i)
-        v[1][i] += temp[i];
-    }
-  }
-  *max_iter = m;
-  *tolerance = residn;
-  
-  spfree(r);
-  spfree(r1);
-  spfree(temp);
-  spfree(d);
-  spfree(v[0]);
-  spfree(v[1]);
-  spfree(w);
-  spfree(u[0]);
-  spfree(u[1]);
+static int sp_ic_setup(void* data, sp_matrix_yale_ptr A)
+{
+  sp_ic_state* state = (sp_ic_state*)data;
+  sp_ic_clear(state);
+  return state->threshold ?
+    sp_matrix_yale_ict_init(&state->ic,A,state->tau,state->fill) :
+    sp_matrix_yale_ic0_init(&state->ic,A);
 }
 
+static void sp_ic_apply(void* data, double* r, double* z)
+{
+  sp_matrix_yale_ic_solve(&((sp_ic_state*)data)->ic,r,z);
+}
 
-void sp_matrix_yale_solve_cgs(sp_matrix_yale_ptr self,
-                              double* b,
-                              double* x0,
-                              int* max_iter,
-                              double* tolerance,
-                              double* x)
+static void sp_ic_release(void* data)
 {
-  /* Conjugate Gradient Squared Algorithm */
-  /*
-   * Based on the book:
-   * Saad Y. Iterative methods for sparse linear systems (2ed., 2003)
-   * page 229
-   */
-   
-  /* variables */
-  int i,j;
-  double alpha, beta,a1,a2;
-  double residn = 0;
-  int size = sizeof(double)*self->rows_count;
-  int msize = self->rows_count;
-  int max_iterations = *max_iter;
-  double tol = *tolerance;
-  double* r;              /* residual */
-  double* r1;             /* r^*_0 */
-  double* p;              /* search direction */
-  double* q;
-  double* u;
-  double* temp;
-
-  /* allocate memory for vectors */
-  r = (double*)spcalloc(msize,sizeof(double));
-  r1 = (double*)spcalloc(msize,sizeof(double));
-  p = (double*)spcalloc(msize,sizeof(double));
-  temp = (double*)spcalloc(msize,sizeof(double));
-  q = (double*)spcalloc(msize,sizeof(double));
-  u = (double*)spcalloc(msize,sizeof(double));
+  sp_ic_clear(data);
+  spfree(data);
+}
 
+static void sp_amg_clear(void* data)
+{
+  sp_amg_state* state = (sp_amg_state*)data;
+  if (state->amg.levels_count)
+    sp_amg_free(&state->amg);
+}
 
-  /* x = x_0 */
-  memcpy(x,x0,size);
+static int sp_amg_setup(void* data, sp_matrix_yale_ptr A)
+{
+  sp_amg_state* state = (sp_amg_state*)data;
+  sp_amg_clear(state);
+  return sp_amg_init(&state->amg,A,state->theta,state->smoother,
+                     state->sweeps);
+}
 
-  /* r_0 = b - A*x_0 */
-  sp_matrix_yale_mv(self,x0,r);
-  for ( i = 0; i < msize; ++ i)
-    r[i] = b[i] - r[i];
-  /* r1 - arbitrary */
-  memcpy(r1,r,size);
-  r1[0] = 1;
-  
-  /* p_0 = r_0 */
-  memcpy(p,r,size);
+static void sp_amg_apply(void* data, double* r, double* z)
+{
+  sp_amg_solve(&((sp_amg_state*)data)->amg,r,z);
+}
 
-  /* u_0 = r_0 */
-  memcpy(u,r,size);
-  
-  /* CGS loop */
-  for ( j = 0; j < max_iterations; j ++ )
-  {
-    /* temp = A*p_j */
-    sp_matrix_yale_mv(self,p,temp);
-    /* compute (r_j,r^*_0) and (A*p_j,r^*_0) */
-    a1 = prod(r,r1,msize);      /* (r_j,r^*_0) */
-    a2 = prod(temp,r1,msize);   /* (A*p_j,r^*_0) */
-    /*                  
-     *            (r_j,r^*_0) 
-     * alpha_j = -----------
-     *           (A*p_j,r^*_0)
-     */                     
-    alpha = a1/a2;              
+static void sp_amg_release(void* data)
+{
+  sp_amg_clear(data);
+  spfree(data);
+}
 
-    /*
-     * q_j = u_j - alpha_j*A*p_j
-     */
-    for (i = 0; i < msize; ++ i)
-      q[i] = u[i] - alpha*temp[i];
-           
-    /* x_{j+1} = x_j+alpha_j(u_j+q_j) */
-    for (i = 0; i < msize; ++ i)
-      x[i] += alpha*(u[i] + q[i]);
+void sp_preconditioner_jacobi_init(sp_preconditioner_ptr self)
+{
+  self->setup = sp_jacobi_setup;
+  self->apply = sp_jacobi_apply;
+  self->release = sp_jacobi_release;
+  self->state = spcalloc(1,sizeof(sp_jacobi_state));
+}
 
-    /* temp = A*(u_j+q_j) */
-    sp_matrix_yale_mvsum(self,u,q,temp);
-    
-    /* r_{j+1} = r_j-alpha_j*A*(u_j+q_j) */
-    for (i = 0; i < msize; ++ i)
-      r[i] -= alpha*temp[i]; 
+void sp_preconditioner_ilu0_init(sp_preconditioner_ptr self)
+{
+  self->setup = sp_ilu_setup;
+  self->apply = sp_ilu_apply;
+  self->release = sp_ilu_release;
+  self->state = spcalloc(1,sizeof(sp_ilu_state));
+}
 
-    /* check for convergence */
-    residn = norm2(r,msize);
-    if (residn < tol )
-      break;
+void sp_preconditioner_ilut_init(sp_preconditioner_ptr self,
+                                 double tau,
+                                 int fill)
+{
+  sp_ilu_state* state;
+  sp_preconditioner_ilu0_init(self);
+  state = (sp_ilu_state*)self->state;
+  state->threshold = 1;
+  state->tau = tau;
+  state->fill = fill;
+}
 
-    /* compute (r_{j+1},r^*_0) */
-    a2 = prod(r,r1,msize);
+void sp_preconditioner_ic0_init(sp_preconditioner_ptr self)
+{
+  self->setup = sp_ic_setup;
+  self->apply = sp_ic_apply;
+  self->release = sp_ic_release;
+  self->state = spcalloc(1,sizeof(sp_ic_state));
+}
 
-    /* b_j = (r_{j+1},r^*_0)/(r_j,r^*_0) */
-    beta = a2/a1;
+void sp_preconditioner_ict_init(sp_preconditioner_ptr self,
+                                double tau,
+                                int fill)
+{
+  sp_ic_state* state;
+  sp_preconditioner_ic0_init(self);
+  state = (sp_ic_state*)self->state;
+  state->threshold = 1;
+  state->tau = tau;
+  state->fill = fill;
+}
 
-    /* u_{j+1} = r_{j+1} + b_j*q_j */
-    for (i = 0; i < msize; ++ i)
-      u[i] = r[i] + beta*q[i];
-    
-    /* p_{j+1} = u_{j+1} + beta_j*(q_j + b_j*p_j) */
-    for (i = 0; i < msize; ++ i)
-      p[i] = u[i] + beta*(q[i] + beta*p[i]);
-  }
-  *max_iter = j;
-  *tolerance = residn;
-  
-  spfree(r);
-  spfree(p);
-  spfree(temp);
-  spfree(r1);
-  spfree(q);
-  spfree(u);
+void sp_preconditioner_amg_init(sp_preconditioner_ptr self,
+                                double theta,
+                                sp_amg_smoother_type smoother,
+                                int sweeps)
+{
+  sp_amg_state* state;
+  self->setup = sp_amg_setup;
+  self->apply = sp_amg_apply;
+  self->release = sp_amg_release;
+  self->state = state = spcalloc(1,sizeof(sp_amg_state));
+  state->theta = theta;
+  state->smoother = smoother;
+  state->sweeps = sweeps;
+}
+
+void sp_preconditioner_user_init(sp_preconditioner_ptr self,
+                                 sp_precond_func apply,
+                                 void* data)
+{
+  self->setup = 0;
+  self->apply = apply;
+  self->release = 0;
+  self->state = data;
+}
+
+int sp_preconditioner_setup(sp_preconditioner_ptr self,
+                            sp_matrix_yale_ptr A)
+{
+  return self->setup ? self->setup(self->state,A) : 1;
+}
+
+void sp_preconditioner_free(sp_preconditioner_ptr self)
+{
+  if (self->release)
+    self->release(self->state);
+  memset(self,0,sizeof(sp_preconditioner));
 }
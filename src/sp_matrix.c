@@ -19,6 +19,7 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include <math.h>
 #include <assert.h>
@@ -491,7 +492,9 @@ void sp_matrix_yale_free(sp_matrix_yale_ptr self)
 {
   spfree(self->offsets);
   spfree(self->indicies);
-  spfree(self->values);
+  /* values could be not allocated for the portrait-only matrix */
+  if (self->values)
+    spfree(self->values);
   memset(self,sizeof(sp_matrix_yale),0);
 }
 
@@ -759,6 +762,45 @@ void sp_matrix_yale_mvsum(sp_matrix_yale_ptr self,
   }
 }
 
+void sp_matrix_yale_mv_block(sp_matrix_yale_ptr self,
+                             int k,
+                             double* X,
+                             double* Y)
+{
+  int i,j,c;
+  double value;
+  double *x, *y;
+  memset(Y,0,sizeof(double)*self->rows_count*k);
+  if (self->storage_type == CRS)
+  {
+    for ( i = 0; i < self->rows_count; ++ i)
+    {
+      y = Y + i*k;
+      for ( j = self->offsets[i]; j < self->offsets[i+1]; ++ j)
+      {
+        value = self->values[j];
+        x = X + self->indicies[j]*k;
+        for (c = 0; c < k; ++ c)
+          y[c] += value*x[c];
+      }
+    }
+  }
+  else                          /* CCS */
+  {
+    for ( i = 0; i < self->cols_count; ++ i)
+    {
+      x = X + i*k;
+      for ( j = self->offsets[i]; j < self->offsets[i+1]; ++ j)
+      {
+        value = self->values[j];
+        y = Y + self->indicies[j]*k;
+        for (c = 0; c < k; ++ c)
+          y[c] += value*x[c];
+      }
+    }
+  }
+}
+
 
 void sp_matrix_printf2(sp_matrix_ptr self)
 {
@@ -797,7 +839,9 @@ void sp_matrix_yale_transpose(sp_matrix_yale_ptr self,
                        self->nonzeros,offsets+1);
 
   /* 3. offsets - partial sums of counts of row/columns */
-  memcpy(offsets,to->offsets,(n+1)*sizeof(int));
+  memcpy(offsets,to->offsets,
+         ((self->storage_type == CRS ? self->cols_count : self->rows_count)+1)*
+         sizeof(int));
   for ( i = 0; i < n; ++i)
   {
     for ( p = self->offsets[i]; p < self->offsets[i+1]; ++p )
@@ -843,6 +887,93 @@ int sp_matrix_yale_convert_inplace(sp_matrix_yale_ptr self,
   return 0;
 }
 
+static int int_compare(const void* a, const void* b)
+{
+  return *(const int*)a - *(const int*)b;
+}
+
+int sp_matrix_yale_mm(sp_matrix_yale_ptr A,
+                      sp_matrix_yale_ptr B,
+                      sp_matrix_yale_ptr C)
+{
+  int i,j,k,p,q,count,nonzeros;
+  int n, m;
+  int *counts, *marker;
+  double* w;
+  sp_matrix_yale_ptr first, second;
+  if (A->storage_type != B->storage_type || A->cols_count != B->rows_count)
+  {
+    LOGERROR("sp_matrix_yale_mm: incompatible matricies %dx%d and %dx%d",
+             A->rows_count,A->cols_count,B->rows_count,B->cols_count);
+    return 0;
+  }
+  /*
+   * Gustavson's algorithm: in CRS i-th row of C is a linear combination
+   * of rows of B with coefficients from i-th row of A;
+   * in CCS j-th column of C is a combination of columns of A
+   * with coefficients from j-th column of B
+   */
+  first  = A->storage_type == CRS ? A : B;
+  second = A->storage_type == CRS ? B : A;
+  n = A->storage_type == CRS ? A->rows_count : B->cols_count;
+  m = A->storage_type == CRS ? B->cols_count : A->rows_count;
+  counts = spalloc((n ? n : 1)*sizeof(int));
+  marker = spalloc((m ? m : 1)*sizeof(int));
+  w = spcalloc(m ? m : 1,sizeof(double));
+  for (j = 0; j < m; ++ j)
+    marker[j] = -1;
+  /* 1. symbolic product: number of nonzeros in every row/column */
+  for (nonzeros = 0, i = 0; i < n; ++ i)
+  {
+    for (count = 0, p = first->offsets[i]; p < first->offsets[i+1]; ++ p)
+    {
+      k = first->indicies[p];
+      for (q = second->offsets[k]; q < second->offsets[k+1]; ++ q)
+        if (marker[j = second->indicies[q]] != i)
+        {
+          marker[j] = i;
+          count ++;
+        }
+    }
+    counts[i] = count;
+    nonzeros += count;
+  }
+  sp_matrix_yale_init2(C,A->storage_type,A->rows_count,B->cols_count,
+                       nonzeros,counts);
+  /* 2. numeric product accumulated in the dense vector w */
+  for (j = 0; j < m; ++ j)
+    marker[j] = -1;
+  for (i = 0; i < n; ++ i)
+  {
+    count = C->offsets[i];
+    for (p = first->offsets[i]; p < first->offsets[i+1]; ++ p)
+    {
+      k = first->indicies[p];
+      for (q = second->offsets[k]; q < second->offsets[k+1]; ++ q)
+      {
+        j = second->indicies[q];
+        if (marker[j] != i)
+        {
+          marker[j] = i;
+          C->indicies[count++] = j;
+        }
+        w[j] += first->values[p]*second->values[q];
+      }
+    }
+    qsort(C->indicies+C->offsets[i],C->offsets[i+1]-C->offsets[i],
+          sizeof(int),int_compare);
+    for (p = C->offsets[i]; p < C->offsets[i+1]; ++ p)
+    {
+      C->values[p] = w[C->indicies[p]];
+      w[C->indicies[p]] = 0;
+    }
+  }
+  spfree(counts);
+  spfree(marker);
+  spfree(w);
+  return 1;
+}
+
 
 
 
@@ -851,36 +982,82 @@ int sp_matrix_yale_permute(sp_matrix_yale_ptr self,
                            int* p,
                            int* q)
 {
-  int i,j,n;
+  int i,j,k,n;
   int result = 1;
-  sp_matrix mtx;
-  /* init matrix with average bandwidth */
+  int *counts, *major, *minor;
+  sp_matrix_yale mtx, transposed;
   n = self->storage_type == CRS ? self->rows_count : self->cols_count;
-  sp_matrix_init(&mtx,
-                 self->rows_count,self->cols_count,
-                 (int)(n/(double)self->nonzeros),
-                 self->storage_type);
-  
+  /* rows are permuted by p and columns by q */
+  major = self->storage_type == CRS ? p : q;
+  minor = self->storage_type == CRS ? q : p;
+  /* 1. number of nonzeros in every permuted row/column */
+  counts = spalloc(n*sizeof(int));
+  for (i = 0; i < n; ++ i)
+    counts[major[i]] = self->offsets[i+1] - self->offsets[i];
+  sp_matrix_yale_init2(&mtx,self->storage_type,
+                       self->rows_count,self->cols_count,
+                       self->nonzeros,counts);
+  /* 2. scatter rows/columns to their new places, indicies unsorted */
   for (i = 0; i < n; ++ i)
   {
-    for (j = self->offsets[i]; j < self->offsets[i+1]; ++ j)
+    k = mtx.offsets[major[i]];
+    for (j = self->offsets[i]; j < self->offsets[i+1]; ++ j, ++ k)
     {
-      if ( self->storage_type == CRS )
-      {
-        MTX(&mtx,p[i],q[self->indicies[j]],self->values[j]);
-      }
-      else
-      {
-        MTX(&mtx,p[self->indicies[j]],q[i],self->values[j]);
-      }
+      mtx.indicies[k] = minor[self->indicies[j]];
+      mtx.values[k]   = self->values[j];
     }
   }
-  sp_matrix_yale_init(permuted,&mtx);
-  sp_matrix_free(&mtx);
+  /*
+   * 3. sort indicies in every row/column: the transposition
+   * always produces sorted indicies, so transpose twice
+   */
+  sp_matrix_yale_transpose(&mtx,&transposed);
+  sp_matrix_yale_free(&mtx);
+  sp_matrix_yale_transpose(&transposed,permuted);
+  sp_matrix_yale_free(&transposed);
+  spfree(counts);
   return result;
 }
 
 
+int sp_matrix_yale_bandwidth(sp_matrix_yale_ptr self)
+{
+  int i,p,n;
+  int bandwidth = 0;
+  n = self->storage_type == CRS ? self->rows_count : self->cols_count;
+  for (i = 0; i < n; ++ i)
+    for (p = self->offsets[i]; p < self->offsets[i+1]; ++ p)
+      bandwidth = int_max(bandwidth,abs(self->indicies[p] - i));
+  return bandwidth;
+}
+
+long sp_matrix_yale_profile(sp_matrix_yale_ptr self)
+{
+  int i,j,p,n;
+  long profile = 0;
+  int* first = spalloc(self->rows_count*sizeof(int));
+  for (i = 0; i < self->rows_count; ++ i)
+    first[i] = i;
+  n = self->storage_type == CRS ? self->rows_count : self->cols_count;
+  for (i = 0; i < n; ++ i)
+    for (p = self->offsets[i]; p < self->offsets[i+1]; ++ p)
+    {
+      j = self->indicies[p];
+      /* element a_ij for CRS or a_ji for CCS */
+      if (self->storage_type == CRS)
+      {
+        if (j < first[i])
+          first[i] = j;
+      }
+      else if (i < first[j])
+        first[j] = i;
+    }
+  for (i = 0; i < self->rows_count; ++ i)
+    profile += i - first[i];
+  spfree(first);
+  return profile;
+}
+
 matrix_properties sp_matrix_yale_properites(sp_matrix_yale_ptr self)
 {
   matrix_properties props = PROP_GENERAL;
@@ -30,12 +30,24 @@
 #define CHUNK_PTR(x) ((size_t*)x+1)
 
 size_t allocated = 0;
+/* high-water mark of allocated */
+static size_t allocated_peak = 0;
 
 size_t spallocated()
 {
   return allocated;
 }
 
+size_t spallocated_peak()
+{
+  return allocated_peak;
+}
+
+void spallocated_reset_peak()
+{
+  allocated_peak = allocated;
+}
+
 void* spalloc(size_t size)
 {
   void* chunk = malloc(size+sizeof(size_t));
@@ -48,6 +60,8 @@ void* spalloc(size_t size)
   }
   *(size_t*)(chunk) = size;
   allocated += size;
+  if (allocated > allocated_peak)
+    allocated_peak = allocated;
   return CHUNK_PTR(chunk);
 }
 
@@ -77,6 +91,8 @@ void* sprealloc(void* ptr, size_t size)
   }
   *(size_t*)(chunk) = size;
   allocated += (size - old_sz); 
+  if (allocated > allocated_peak)
+    allocated_peak = allocated;
   
   return CHUNK_PTR(chunk);
 }
@@ -88,6 +104,21 @@ void spfree(void* ptr)
   free(CHUNK_HEAD(ptr));
 }
 
+void* spalloc_aligned(size_t size)
+{
+  /* pointer to the allocated chunk is stored before the aligned block */
+  char* chunk = spalloc(size+SP_MEM_ALIGNMENT+sizeof(void*));
+  char* ptr = chunk + sizeof(void*);
+  ptr += (SP_MEM_ALIGNMENT - (size_t)ptr % SP_MEM_ALIGNMENT) % SP_MEM_ALIGNMENT;
+  ((void**)ptr)[-1] = chunk;
+  return ptr;
+}
+
+void spfree_aligned(void* ptr)
+{
+  spfree(((void**)ptr)[-1]);
+}
+
 void* memdup(const void* src, size_t bytes)
 {
   void* result = spalloc(bytes);
@@ -18,7 +18,47 @@
  along with libspmatrix.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <limits.h>
+#include <string.h>
+
 #include "sp_perm.h"
+#include "sp_mem.h"
+#include "sp_log.h"
+
+/*
+ * Parameters of the nested dissection ordering
+ */
+/* graphs with this number of vertices or less are ordered by
+ * the minimum degree algorithm */
+#define SP_ND_LEAF_SIZE 128
+/* coarsening stops when the graph has this number of vertices */
+#define SP_ND_COARSE_SIZE 64
+/* maximum number of coarsening levels */
+#define SP_ND_MAX_LEVELS 64
+/* number of tries of the initial bisection of the coarsest graph */
+#define SP_ND_BISECTION_TRIES 8
+/* allowed imbalance of the bisection, in percents */
+#define SP_ND_IMBALANCE 10
+/* maximum number of passes of the boundary refinement */
+#define SP_ND_REFINE_PASSES 8
+
+/* number of bits in the word of the bit set */
+#define SP_WORD_BITS (int)(sizeof(unsigned)*CHAR_BIT)
+
+/*
+ * Undirected weighted graph in adjacency (CRS-like) format
+ * used by the ordering algorithms
+ */
+typedef struct
+{
+  int n;                        /* number of vertices */
+  int* xadj;                    /* offsets of adjacency lists, n+1 */
+  int* adjncy;                  /* adjacent vertices */
+  int* vwgt;                    /* vertex weights */
+  int* adjwgt;                  /* edge weights */
+  int* label;                   /* vertex number in the original graph */
+} sp_graph;
+typedef sp_graph* sp_graph_ptr;
 
 void sp_perm_inverse(int* perm, int n, int* pinv)
 {
@@ -28,3 +68,799 @@ void sp_perm_inverse(int* perm, int n, int* pinv)
 }
 
     
+
+void sp_perm_vector(int* perm, int n, double* x, double* y)
+{
+  int i;
+  for ( i = 0; i < n; ++ i )
+    y[i] = x[perm[i]];
+}
+
+void sp_perm_inverse_vector(int* perm, int n, double* x, double* y)
+{
+  int i;
+  for ( i = 0; i < n; ++ i )
+    y[perm[i]] = x[i];
+}
+
+/* simple linear congruential generator, returns the value in [0,n) */
+static int sp_perm_rand(unsigned* seed, int n)
+{
+  *seed = *seed * 1664525u + 1013904223u;
+  return (int)((*seed >> 8) % (unsigned)n);
+}
+
+static void sp_graph_init(sp_graph_ptr self, int n, int nedges)
+{
+  self->n = n;
+  self->xadj   = spcalloc(n+1,sizeof(int));
+  self->adjncy = spalloc(nedges*sizeof(int));
+  self->adjwgt = spalloc(nedges*sizeof(int));
+  self->vwgt   = spalloc(n*sizeof(int));
+  self->label  = spalloc(n*sizeof(int));
+}
+
+static void sp_graph_free(sp_graph_ptr self)
+{
+  spfree(self->xadj);
+  spfree(self->adjncy);
+  spfree(self->adjwgt);
+  spfree(self->vwgt);
+  spfree(self->label);
+  memset(self,0,sizeof(sp_graph));
+}
+
+/*
+ * Constructs the graph of the matrix A+A^T without diagonal
+ * Complexity: O(nonzeros)
+ */
+static void sp_graph_from_yale(sp_matrix_yale_ptr mtx, sp_graph_ptr self)
+{
+  int n = mtx->rows_count;
+  int i,j,p,k,start,end;
+  int *offsets, *adjncy, *marker;
+  /* 1. degrees counting both a_ij and a_ji, with duplicates */
+  offsets = spcalloc(n+1,sizeof(int));
+  for (i = 0; i < n; ++ i)
+    for (p = mtx->offsets[i]; p < mtx->offsets[i+1]; ++ p)
+      if ((j = mtx->indicies[p]) != i)
+      {
+        offsets[i+1]++;
+        offsets[j+1]++;
+      }
+  for (i = 0; i < n; ++ i)
+    offsets[i+1] += offsets[i];
+  /* 2. fill the adjacency lists */
+  sp_graph_init(self,n,offsets[n]);
+  memcpy(self->xadj,offsets,(n+1)*sizeof(int));
+  adjncy = self->adjncy;
+  for (i = 0; i < n; ++ i)
+    for (p = mtx->offsets[i]; p < mtx->offsets[i+1]; ++ p)
+      if ((j = mtx->indicies[p]) != i)
+      {
+        adjncy[offsets[i]++] = j;
+        adjncy[offsets[j]++] = i;
+      }
+  /* 3. remove duplicates inplace */
+  marker = offsets;
+  for (i = 0; i < n; ++ i)
+    marker[i] = -1;
+  k = 0;
+  start = 0;
+  for (i = 0; i < n; ++ i)
+  {
+    end = self->xadj[i+1];
+    self->xadj[i] = k;
+    for (p = start; p < end; ++ p)
+    {
+      j = adjncy[p];
+      if (marker[j] != i)
+      {
+        marker[j] = i;
+        adjncy[k++] = j;
+      }
+    }
+    start = end;
+  }
+  self->xadj[n] = k;
+  for (p = 0; p < k; ++ p)
+    self->adjwgt[p] = 1;
+  for (i = 0; i < n; ++ i)
+  {
+    self->vwgt[i] = 1;
+    self->label[i] = i;
+  }
+  spfree(offsets);
+}
+
+/*
+ * Constructs the coarse graph by the heavy edge matching.
+ * cmap - output array, cmap[i] is the vertex in the coarse graph
+ * containing the vertex i of the graph self
+ */
+static void sp_graph_coarsen(sp_graph_ptr self,
+                             sp_graph_ptr coarse,
+                             int* cmap,
+                             unsigned* seed)
+{
+  int n = self->n;
+  int i,j,k,p,u,v,w,c,maxwgt,nedges;
+  int *order, *match, *htable;
+  /* 1. visit vertices in random order */
+  order = spalloc(n*sizeof(int));
+  match = spalloc(n*sizeof(int));
+  for (i = 0; i < n; ++ i)
+  {
+    order[i] = i;
+    match[i] = -1;
+  }
+  for (i = n-1; i > 0; -- i)
+  {
+    j = sp_perm_rand(seed,i+1);
+    k = order[i]; order[i] = order[j]; order[j] = k;
+  }
+  /* 2. match every vertex with the unmatched neighbor
+   * connected by the heaviest edge */
+  for (k = 0; k < n; ++ k)
+  {
+    u = order[k];
+    if (match[u] != -1)
+      continue;
+    v = u;
+    maxwgt = -1;
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+    {
+      j = self->adjncy[p];
+      if (match[j] == -1 && self->adjwgt[p] > maxwgt)
+      {
+        maxwgt = self->adjwgt[p];
+        v = j;
+      }
+    }
+    match[u] = v;
+    match[v] = u;
+  }
+  /* 3. number coarse vertices in order of their smallest fine vertex */
+  c = 0;
+  for (u = 0; u < n; ++ u)
+    if (match[u] >= u)
+      cmap[u] = cmap[match[u]] = c++;
+  /* 4. construct the coarse graph merging adjacency lists */
+  sp_graph_init(coarse,c,self->xadj[n]);
+  htable = order;
+  for (i = 0; i < c; ++ i)
+    htable[i] = -1;
+  nedges = 0;
+  for (u = 0; u < n; ++ u)
+  {
+    v = match[u];
+    if (v < u)
+      continue;
+    c = cmap[u];
+    coarse->xadj[c] = nedges;
+    coarse->vwgt[c] = self->vwgt[u] + (v != u ? self->vwgt[v] : 0);
+    coarse->label[c] = -1;
+    for (w = u; ; w = v)
+    {
+      for (p = self->xadj[w]; p < self->xadj[w+1]; ++ p)
+      {
+        j = cmap[self->adjncy[p]];
+        if (j == c)
+          continue;
+        if (htable[j] == -1)
+        {
+          htable[j] = nedges;
+          coarse->adjncy[nedges] = j;
+          coarse->adjwgt[nedges] = self->adjwgt[p];
+          nedges++;
+        }
+        else
+          coarse->adjwgt[htable[j]] += self->adjwgt[p];
+      }
+      if (w == v)
+        break;
+    }
+    for (p = coarse->xadj[c]; p < nedges; ++ p)
+      htable[coarse->adjncy[p]] = -1;
+  }
+  coarse->xadj[coarse->n] = nedges;
+  spfree(order);
+  spfree(match);
+}
+
+/* moves the vertex u to the other part updating gains */
+static void sp_graph_move(sp_graph_ptr self, int u,
+                          int* where, int* pwgt,
+                          int* id, int* ed)
+{
+  int p,j,w;
+  int to = 1 - where[u];
+  pwgt[where[u]] -= self->vwgt[u];
+  pwgt[to] += self->vwgt[u];
+  where[u] = to;
+  w = id[u]; id[u] = ed[u]; ed[u] = w;
+  for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+  {
+    j = self->adjncy[p];
+    w = self->adjwgt[p];
+    if (where[j] == to)
+    {
+      id[j] += w;
+      ed[j] -= w;
+    }
+    else
+    {
+      id[j] -= w;
+      ed[j] += w;
+    }
+  }
+}
+
+/*
+ * Greedy boundary refinement of the bisection where.
+ * At first restores the balance: weights of both parts shall not
+ * exceed maxpwgt; then moves boundary vertices which reduce the
+ * edge cut (or keep it and improve the balance)
+ */
+static void sp_graph_refine(sp_graph_ptr self, int* where, int maxpwgt)
+{
+  int n = self->n;
+  int u,p,from,to,gain,pass,moved;
+  int pwgt[2] = {0,0};
+  int *id = spcalloc(n,sizeof(int));
+  int *ed = spcalloc(n,sizeof(int));
+  /* internal and external degrees */
+  for (u = 0; u < n; ++ u)
+  {
+    pwgt[where[u]] += self->vwgt[u];
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+      if (where[self->adjncy[p]] == where[u])
+        id[u] += self->adjwgt[p];
+      else
+        ed[u] += self->adjwgt[p];
+  }
+  /* restore the balance: boundary vertices first, then the rest */
+  for (pass = 0; pass < 2; ++ pass)
+  {
+    for (u = 0; u < n; ++ u)
+    {
+      from = pwgt[0] > pwgt[1] ? 0 : 1;
+      if (pwgt[from] <= maxpwgt)
+        break;
+      if (where[u] == from && (pass || ed[u] > 0) &&
+          pwgt[1-from] + self->vwgt[u] <= maxpwgt)
+        sp_graph_move(self,u,where,pwgt,id,ed);
+    }
+  }
+  /* reduce the edge cut */
+  for (pass = 0; pass < SP_ND_REFINE_PASSES; ++ pass)
+  {
+    moved = 0;
+    for (u = 0; u < n; ++ u)
+    {
+      if (ed[u] == 0)           /* not on the boundary */
+        continue;
+      from = where[u];
+      to = 1 - from;
+      if (pwgt[to] + self->vwgt[u] > maxpwgt)
+        continue;
+      gain = ed[u] - id[u];
+      if (gain > 0 ||
+          (gain == 0 && pwgt[from] > pwgt[to] + self->vwgt[u]))
+      {
+        sp_graph_move(self,u,where,pwgt,id,ed);
+        moved++;
+      }
+    }
+    if (!moved)
+      break;
+  }
+  spfree(id);
+  spfree(ed);
+}
+
+/* returns the weight of the edge cut of the bisection where */
+static int sp_graph_cut(sp_graph_ptr self, int* where)
+{
+  int u,p;
+  int cut = 0;
+  for (u = 0; u < self->n; ++ u)
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+      if (where[self->adjncy[p]] != where[u])
+        cut += self->adjwgt[p];
+  return cut/2;
+}
+
+/*
+ * Initial bisection of the (coarse) graph by the graph growing:
+ * the part 0 is grown by breadth first search from the random vertex
+ * until it contains the half of the graph weight. The best of
+ * several refined tries is taken
+ */
+static void sp_graph_grow_bisection(sp_graph_ptr self,
+                                    int* where,
+                                    int maxpwgt,
+                                    unsigned* seed)
+{
+  int n = self->n;
+  int u,j,p,t,head,tail,next,cut;
+  int total = 0, grown = 0, best = INT_MAX;
+  int *trial = spalloc(n*sizeof(int));
+  int *queue = spalloc(n*sizeof(int));
+  for (u = 0; u < n; ++ u)
+  {
+    total += self->vwgt[u];
+    where[u] = 0;
+  }
+  for (t = 0; t < SP_ND_BISECTION_TRIES && n > 1; ++ t)
+  {
+    for (u = 0; u < n; ++ u)
+      trial[u] = 1;
+    head = tail = next = 0;
+    u = sp_perm_rand(seed,n);
+    trial[u] = 0;
+    grown = self->vwgt[u];
+    queue[tail++] = u;
+    while (2*grown < total)
+    {
+      if (head == tail)
+      {
+        /* disconnected graph: continue from the next component */
+        while (next < n && trial[next] == 0)
+          next++;
+        if (next == n)
+          break;
+        trial[next] = 0;
+        grown += self->vwgt[next];
+        queue[tail++] = next;
+        continue;
+      }
+      u = queue[head++];
+      for (p = self->xadj[u]; p < self->xadj[u+1] && 2*grown < total; ++ p)
+      {
+        j = self->adjncy[p];
+        if (trial[j] == 1)
+        {
+          trial[j] = 0;
+          grown += self->vwgt[j];
+          queue[tail++] = j;
+        }
+      }
+    }
+    sp_graph_refine(self,trial,maxpwgt);
+    cut = sp_graph_cut(self,trial);
+    if (cut < best)
+    {
+      best = cut;
+      memcpy(where,trial,n*sizeof(int));
+    }
+  }
+  spfree(trial);
+  spfree(queue);
+}
+
+/*
+ * Multilevel bisection of the graph:
+ * coarsening, initial bisection of the coarsest graph and
+ * refinement during uncoarsening
+ */
+static void sp_graph_bisect(sp_graph_ptr self, int* where, unsigned* seed)
+{
+  sp_graph_ptr levels[SP_ND_MAX_LEVELS+1];
+  int* cmaps[SP_ND_MAX_LEVELS];
+  int *fine_where, *coarse_where;
+  int nlevels = 0;
+  int i,u,maxpwgt;
+  int total = 0;
+  sp_graph_ptr coarse;
+  for (u = 0; u < self->n; ++ u)
+    total += self->vwgt[u];
+  maxpwgt = total*(100 + SP_ND_IMBALANCE)/200 + 1;
+  /* 1. coarsening */
+  levels[0] = self;
+  while (nlevels < SP_ND_MAX_LEVELS &&
+         levels[nlevels]->n > SP_ND_COARSE_SIZE)
+  {
+    coarse = spalloc(sizeof(sp_graph));
+    cmaps[nlevels] = spalloc(levels[nlevels]->n*sizeof(int));
+    sp_graph_coarsen(levels[nlevels],coarse,cmaps[nlevels],seed);
+    /* stop if the matching doesn't reduce the graph anymore */
+    if ((double)coarse->n > 0.95*levels[nlevels]->n)
+    {
+      sp_graph_free(coarse);
+      spfree(coarse);
+      spfree(cmaps[nlevels]);
+      break;
+    }
+    levels[++nlevels] = coarse;
+  }
+  /* 2. initial bisection */
+  coarse_where = nlevels ? spalloc(levels[nlevels]->n*sizeof(int)) : where;
+  sp_graph_grow_bisection(levels[nlevels],coarse_where,maxpwgt,seed);
+  /* 3. uncoarsening with refinement */
+  for (i = nlevels-1; i >= 0; -- i)
+  {
+    fine_where = i ? spalloc(levels[i]->n*sizeof(int)) : where;
+    for (u = 0; u < levels[i]->n; ++ u)
+      fine_where[u] = coarse_where[cmaps[i][u]];
+    spfree(coarse_where);
+    spfree(cmaps[i]);
+    sp_graph_free(levels[i+1]);
+    spfree(levels[i+1]);
+    sp_graph_refine(levels[i],fine_where,maxpwgt);
+    coarse_where = fine_where;
+  }
+}
+
+/*
+ * Extracts the subgraph induced by vertices of the graph self
+ * with where[u] == part
+ * map - workspace of self->n elements
+ */
+static void sp_graph_subgraph(sp_graph_ptr self, int* where, int part,
+                              int* map, sp_graph_ptr sub)
+{
+  int u,j,p,m = 0,nedges = 0;
+  for (u = 0; u < self->n; ++ u)
+  {
+    map[u] = -1;
+    if (where[u] == part)
+    {
+      map[u] = m++;
+      for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+        if (where[self->adjncy[p]] == part)
+          nedges++;
+    }
+  }
+  sp_graph_init(sub,m,nedges);
+  nedges = 0;
+  for (u = 0; u < self->n; ++ u)
+  {
+    if ((m = map[u]) == -1)
+      continue;
+    sub->xadj[m] = nedges;
+    sub->vwgt[m] = self->vwgt[u];
+    sub->label[m] = self->label[u];
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+      if ((j = map[self->adjncy[p]]) != -1)
+      {
+        sub->adjncy[nedges] = j;
+        sub->adjwgt[nedges] = self->adjwgt[p];
+        nedges++;
+      }
+  }
+  sub->xadj[sub->n] = nedges;
+}
+
+/* number of bits set in the bit set of size words */
+static int sp_bitset_count(unsigned* set, int words)
+{
+  int i,count = 0;
+  unsigned x;
+  for (i = 0; i < words; ++ i)
+    for (x = set[i]; x; x &= x - 1)
+      count++;
+  return count;
+}
+
+/*
+ * Minimum degree ordering of the small graph.
+ * The elimination graph is stored as the dense bit matrix,
+ * so the complexity is O(n^2) memory and O(n^2 + n*|L|/wordsize) time
+ * order - output array: order[k] = u means vertex u is eliminated k-th
+ */
+static void sp_graph_min_degree(sp_graph_ptr self, int* order)
+{
+  int n = self->n;
+  int words = (n + SP_WORD_BITS - 1)/SP_WORD_BITS;
+  int i,j,k,p,u,best;
+  unsigned bits;
+  unsigned *rows, *pivot, *row;
+  int* degree;
+  char* eliminated;
+  if (!n)
+    return;
+  rows = spcalloc(n*words,sizeof(unsigned));
+  degree = spalloc(n*sizeof(int));
+  eliminated = spcalloc(n,sizeof(char));
+#define _SP_BIT(i) (1u << ((i) % SP_WORD_BITS))
+  for (u = 0; u < n; ++ u)
+  {
+    row = rows + u*words;
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+    {
+      j = self->adjncy[p];
+      row[j/SP_WORD_BITS] |= _SP_BIT(j);
+    }
+    degree[u] = self->xadj[u+1] - self->xadj[u];
+  }
+  for (k = 0; k < n; ++ k)
+  {
+    /* select the vertex of minimum degree */
+    best = -1;
+    for (u = 0; u < n; ++ u)
+      if (!eliminated[u] && (best == -1 || degree[u] < degree[best]))
+        best = u;
+    order[k] = best;
+    eliminated[best] = 1;
+    /* eliminate: neighbors of the pivot become a clique */
+    pivot = rows + best*words;
+    for (i = 0; i < words; ++ i)
+    {
+      for (bits = pivot[i], j = 0; bits; bits >>= 1, ++ j)
+      {
+        if (!(bits & 1u))
+          continue;
+        u = i*SP_WORD_BITS + j;
+        row = rows + u*words;
+        for (p = 0; p < words; ++ p)
+          row[p] |= pivot[p];
+        row[u/SP_WORD_BITS] &= ~_SP_BIT(u);
+        row[best/SP_WORD_BITS] &= ~_SP_BIT(best);
+        degree[u] = sp_bitset_count(row,words);
+      }
+    }
+  }
+#undef _SP_BIT
+  spfree(rows);
+  spfree(degree);
+  spfree(eliminated);
+}
+
+/*
+ * Recursive nested dissection of the graph self.
+ * Writes original numbers of vertices to the perm array
+ * starting from the position first: both parts first,
+ * the separator last
+ */
+static void sp_graph_nested_dissection(sp_graph_ptr self,
+                                       int* perm,
+                                       int first,
+                                       unsigned* seed)
+{
+  int n = self->n;
+  int u,p,k,sep;
+  int counts[3] = {0,0,0};
+  int boundary[2] = {0,0};
+  int *where, *map;
+  sp_graph parts[2];
+  if (n <= SP_ND_LEAF_SIZE)
+  {
+    map = spalloc(n*sizeof(int));
+    sp_graph_min_degree(self,map);
+    for (k = 0; k < n; ++ k)
+      perm[first+k] = self->label[map[k]];
+    spfree(map);
+    return;
+  }
+  where = spalloc(n*sizeof(int));
+  sp_graph_bisect(self,where,seed);
+  /* the vertex separator is the smaller boundary of two parts */
+  for (u = 0; u < n; ++ u)
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+      if (where[self->adjncy[p]] != where[u])
+      {
+        boundary[where[u]]++;
+        break;
+      }
+  sep = boundary[0] <= boundary[1] ? 0 : 1;
+  for (u = 0; u < n; ++ u)
+  {
+    if (where[u] == sep)
+      for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+        if (where[self->adjncy[p]] == 1 - sep)
+        {
+          where[u] = 2;
+          break;
+        }
+    counts[where[u]]++;
+  }
+  if (counts[0] == n || counts[1] == n || counts[2] == n)
+  {
+    /* the bisection failed, keep the natural order */
+    for (u = 0; u < n; ++ u)
+      perm[first+u] = self->label[u];
+    spfree(where);
+    return;
+  }
+  /* extract parts and put the separator to the end */
+  map = spalloc(n*sizeof(int));
+  sp_graph_subgraph(self,where,0,map,&parts[0]);
+  sp_graph_subgraph(self,where,1,map,&parts[1]);
+  k = first + counts[0] + counts[1];
+  for (u = 0; u < n; ++ u)
+    if (where[u] == 2)
+      perm[k++] = self->label[u];
+  spfree(map);
+  spfree(where);
+  /* order parts recursively */
+  sp_graph_nested_dissection(&parts[0],perm,first,seed);
+  sp_graph_free(&parts[0]);
+  sp_graph_nested_dissection(&parts[1],perm,first+counts[0],seed);
+  sp_graph_free(&parts[1]);
+}
+
+int sp_matrix_yale_nested_dissection(sp_matrix_yale_ptr self, int* perm)
+{
+  sp_graph graph;
+  unsigned seed = 1;
+  if (!self || !perm || self->rows_count != self->cols_count)
+  {
+    LOGERROR("Nested dissection: square matrix expected");
+    return 0;
+  }
+  sp_graph_from_yale(self,&graph);
+  sp_graph_nested_dissection(&graph,perm,0,&seed);
+  sp_graph_free(&graph);
+  return 1;
+}
+
+/* number of vertices adjacent to u */
+static int sp_graph_degree(sp_graph_ptr self, int u)
+{
+  return self->xadj[u+1] - self->xadj[u];
+}
+
+/*
+ * Breadth first search from the root.
+ * Fills the queue with visited vertices in BFS order and
+ * the level array with their distances from the root
+ * (not visited vertices shall have level -1);
+ * nlevels - output number of levels in the level structure
+ * returns the number of visited vertices
+ */
+static int sp_graph_level_structure(sp_graph_ptr self,
+                                    int root,
+                                    int* queue,
+                                    int* level,
+                                    int* nlevels)
+{
+  int head = 0, tail = 0;
+  int u,j,p;
+  queue[tail++] = root;
+  level[root] = 0;
+  while (head < tail)
+  {
+    u = queue[head++];
+    for (p = self->xadj[u]; p < self->xadj[u+1]; ++ p)
+    {
+      j = self->adjncy[p];
+      if (level[j] == -1)
+      {
+        level[j] = level[u] + 1;
+        queue[tail++] = j;
+      }
+    }
+  }
+  *nlevels = level[queue[tail-1]] + 1;
+  return tail;
+}
+
+/*
+ * Finds the pseudo-peripheral vertex in the connected component
+ * of the root by George-Liu algorithm: repeat BFS from the vertex of
+ * minimum degree in the last level while the number of levels grows
+ * queue and level - workspaces, all levels shall be -1
+ */
+static int sp_graph_pseudo_peripheral(sp_graph_ptr self,
+                                      int root,
+                                      int* queue,
+                                      int* level)
+{
+  int k,u,best,count,nlevels,new_nlevels;
+  count = sp_graph_level_structure(self,root,queue,level,&nlevels);
+  while(1)
+  {
+    /* vertex of minimum degree in the last level */
+    best = queue[count-1];
+    for (k = count-1; k >= 0 && level[u = queue[k]] == nlevels-1; -- k)
+      if (sp_graph_degree(self,u) < sp_graph_degree(self,best))
+        best = u;
+    for (k = 0; k < count; ++ k)
+      level[queue[k]] = -1;
+    count = sp_graph_level_structure(self,best,queue,level,&new_nlevels);
+    if (new_nlevels <= nlevels)
+      break;
+    root = best;
+    nlevels = new_nlevels;
+  }
+  for (k = 0; k < count; ++ k)
+    level[queue[k]] = -1;
+  return root;
+}
+
+int sp_matrix_yale_rcm(sp_matrix_yale_ptr self, int* perm)
+{
+  sp_graph graph;
+  int n,i,j,k,p,u,head,first;
+  int *queue, *level;
+  char* ordered;
+  if (!self || !perm || self->rows_count != self->cols_count)
+  {
+    LOGERROR("Reverse Cuthill-McKee: square matrix expected");
+    return 0;
+  }
+  n = self->rows_count;
+  sp_graph_from_yale(self,&graph);
+  queue = spalloc(n*sizeof(int));
+  level = spalloc(n*sizeof(int));
+  ordered = spcalloc(n,sizeof(char));
+  for (i = 0; i < n; ++ i)
+    level[i] = -1;
+  k = 0;
+  for (i = 0; i < n; ++ i)
+  {
+    if (ordered[i])
+      continue;
+    /* Cuthill-McKee: BFS from the pseudo-peripheral vertex,
+     * neighbors are visited in order of increasing degree.
+     * perm array itself is used as a queue */
+    u = sp_graph_pseudo_peripheral(&graph,i,queue,level);
+    head = k;
+    perm[k++] = u;
+    ordered[u] = 1;
+    while (head < k)
+    {
+      u = perm[head++];
+      first = k;
+      for (p = graph.xadj[u]; p < graph.xadj[u+1]; ++ p)
+      {
+        j = graph.adjncy[p];
+        if (!ordered[j])
+        {
+          ordered[j] = 1;
+          perm[k++] = j;
+        }
+      }
+      /* insertion sort of new vertices by degree */
+      for (p = first+1; p < k; ++ p)
+      {
+        u = perm[p];
+        for (j = p;
+             j > first &&
+               sp_graph_degree(&graph,perm[j-1]) > sp_graph_degree(&graph,u);
+             -- j)
+          perm[j] = perm[j-1];
+        perm[j] = u;
+      }
+    }
+  }
+  /* reverse the order */
+  for (i = 0; i < n/2; ++ i)
+  {
+    u = perm[i];
+    perm[i] = perm[n-1-i];
+    perm[n-1-i] = u;
+  }
+  spfree(queue);
+  spfree(level);
+  spfree(ordered);
+  sp_graph_free(&graph);
+  return 1;
+}
+
+int sp_matrix_yale_ordering(sp_matrix_yale_ptr self,
+                            sp_ordering_type type,
+                            int* perm)
+{
+  int i;
+  int result = 0;
+  switch(type)
+  {
+  case ORDER_NATURAL:
+    for (i = 0; i < self->rows_count; ++ i)
+      perm[i] = i;
+    result = 1;
+    break;
+  case ORDER_NESTED_DISSECTION:
+    result = sp_matrix_yale_nested_dissection(self,perm);
+    break;
+  case ORDER_REVERSE_CUTHILL_MCKEE:
+    result = sp_matrix_yale_rcm(self,perm);
+    break;
+  default:
+    LOGERROR("Unknown ordering type: %d",type);
+    break;
+  }
+  return result;
+}
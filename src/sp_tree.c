@@ -95,23 +95,27 @@ void tree_postorder_perm(int* tree, int size, int* postorder)
    *   dfstree(i)
    * post[k] = j
    * k = k + 1
+   *
+   * Children are stored as linked lists in head/next arrays,
+   * complexity: O(size)
    */
   int counter = 0;
-  int i,child,current;
-  int_stack_ptr* children;
-  /* initialize stack for DFS procedure */
-  int_stack_ptr stack = int_stack_alloc(size,1);
-  /* allocate memory for childen
-   * children of every node stored in the stack */
-  children = spalloc(sizeof(int_stack_ptr)*size);
+  int i,child,current,top;
+  int *workspace, *head, *next, *stack;
+  workspace = spalloc(3*size*sizeof(int));
+  head = workspace;
+  next = workspace + size;
+  stack = workspace + 2*size;
   for ( i = 0; i < size; ++ i)
-    children[i] = int_stack_alloc(1,2);
-  /* now fill the stacks of children with the actual children
-   * in reverse order to keep children in the stack in ascending order
-   * i.e. ->[1 2 3] */
+    head[i] = -1;
+  /* now fill lists of children in reverse order to keep
+   * children in the list in ascending order i.e. ->[1 2 3] */
   for ( i = size -1 ; i >= 0; -- i)
     if (tree[i] != -1)
-      int_stack_push(children[tree[i]],i);
+    {
+      next[i] = head[tree[i]];
+      head[tree[i]] = i;
+    }
 
   /* loop by all roots in the forest */
   for ( i = 0; i < size; ++ i)
@@ -120,50 +124,50 @@ void tree_postorder_perm(int* tree, int size, int* postorder)
      * root will exist */
     if (tree[i] == -1)
     {
-      int_stack_push(stack,i);
+      top = 0;
+      stack[top] = i;
       /* start to walk through the tree starting with roots */
-      while (!int_stack_isempty(stack))
+      while (top >= 0)
       {
-        current = int_stack_top(stack);
+        current = stack[top];
+        child = head[current];
         /* if exist not visited children */
-        if (!int_stack_isempty(children[current]))
+        if (child != -1)
         {
-          /* take the not visited child */
-          child = int_stack_top(children[current]);
-          /* and put it to the stack */
-          int_stack_push(stack,child);
           /* remove child from the list of not visited */
-          int_stack_pop(children[current]);
+          head[current] = next[child];
+          /* and put it to the stack */
+          stack[++top] = child;
         }
         else                    /* no more not visited children */
         {
           /* remove current from the stack to traverse up by the tree  */
-          int_stack_pop(stack);
+          top--;
           /* write the last visited node to the place
            * specified by the counter  */
-          postorder[counter] = current;
-          /* increase the counter for postordering */
-          counter++;
+          postorder[counter++] = current;
         }
       }
     }
   }
-  for ( i = 0; i < size; ++ i)
-    int_stack_free(children[i]);
-  int_stack_free(stack);
-  spfree(children);
+  spfree(workspace);
 }
 
 void tree_node_levels(int* tree, int size, int* level)
 {
-  int i,j;
+  int i,j,len;
+  for ( i = 0; i < size; ++ i)
+    level[i] = -1;
   for ( i = 0; i < size; ++ i)
   {
-    level[i] = 0;
-    /* calculate level of i-th node */
-    j = tree[i];
-    for ( ; j != -1; j = tree[j])
-      level[i] ++;
+    /* climb up to the root or to the node with known level */
+    len = 0;
+    for ( j = i; j != -1 && level[j] == -1; j = tree[j])
+      len ++;
+    len += j == -1 ? -1 : level[j];
+    /* assign levels on the path; every node is assigned only once */
+    for ( j = i; j != -1 && level[j] == -1; j = tree[j])
+      level[j] = len--;
   }
 }
 
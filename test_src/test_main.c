@@ -21,6 +21,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <memory.h>
+#include <time.h>
 #include "sp_mem.h"
 
 #include "sp_matrix.h"
@@ -746,6 +747,1684 @@ static void cholesky()
   sp_matrix_yale_free(&L);
 }
 
+/*
+ * Creates the matrix of the 5-point finite difference Laplacian
+ * on the nx x ny grid
+ */
+static void create_laplacian_2d(sp_matrix_yale_ptr yale,
+                                int nx, int ny,
+                                sparse_storage_type type)
+{
+  sp_matrix mtx;
+  int i,j,k;
+  sp_matrix_init(&mtx,nx*ny,nx*ny,5,type);
+  for (j = 0; j < ny; ++ j)
+    for (i = 0; i < nx; ++ i)
+    {
+      k = j*nx + i;
+      MTX(&mtx,k,k,4);
+      if (i > 0)
+        MTX(&mtx,k,k-1,-1);
+      if (i < nx-1)
+        MTX(&mtx,k,k+1,-1);
+      if (j > 0)
+        MTX(&mtx,k,k-nx,-1);
+      if (j < ny-1)
+        MTX(&mtx,k,k+nx,-1);
+    }
+  sp_matrix_yale_init(yale,&mtx);
+  sp_matrix_free(&mtx);
+}
+
+static void nested_dissection()
+{
+  const int nx = 40, ny = 30, n = 40*30;
+  sp_matrix_yale yale;
+  sp_chol_symbolic symb,symb_nd;
+  int* perm = spalloc(n*sizeof(int));
+  char* marked = spcalloc(n,sizeof(char));
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  int i;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  /* ordering shall be the permutation */
+  ASSERT_TRUE(sp_matrix_yale_nested_dissection(&yale,perm));
+  for (i = 0; i < n; ++ i)
+  {
+    ASSERT_TRUE(perm[i] >= 0 && perm[i] < n && !marked[perm[i]]);
+    marked[perm[i]] = 1;
+  }
+  /* and shall reduce the fill-in */
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic(&yale,&symb));
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic_ordered(&yale,&symb_nd,
+                                                   ORDER_NESTED_DISSECTION));
+  ASSERT_TRUE(symb_nd.perm && symb_nd.pinv);
+  printf("nonzeros in L: natural %d, nested dissection %d\n",
+         symb.nonzeros,symb_nd.nonzeros);
+  EXPECT_TRUE(symb_nd.nonzeros < symb.nonzeros);
+  /* solve with the reordered factorization */
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic_solve(&yale,&symb_nd,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+
+  sp_matrix_yale_symbolic_free(&symb);
+  sp_matrix_yale_symbolic_free(&symb_nd);
+  sp_matrix_yale_free(&yale);
+  spfree(perm);
+  spfree(marked);
+  spfree(x);
+  spfree(x_expected);
+  spfree(b);
+}
+
+static void rcm_ordering()
+{
+  const int nx = 40, ny = 30, n = 40*30;
+  sp_matrix_yale grid,scrambled,reordered;
+  sp_matrix_skyline skyline;
+  sp_matrix_skyline_ilu ilu;
+  int* p = spalloc(n*sizeof(int));
+  int* perm = spalloc(n*sizeof(int));
+  int* pinv = spalloc(n*sizeof(int));
+  char* marked = spcalloc(n,sizeof(char));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  double tolerance = 1e-12;
+  int max_iter = 1000;
+  int i;
+  create_laplacian_2d(&grid,nx,ny,CRS);
+  /* scramble the numbering of grid nodes */
+  for (i = 0; i < n; ++ i)
+    p[i] = (int)((7919L*i) % n);
+  ASSERT_TRUE(sp_matrix_yale_permute(&grid,&scrambled,p,p));
+  /* ordering shall be the permutation */
+  ASSERT_TRUE(sp_matrix_yale_rcm(&scrambled,perm));
+  for (i = 0; i < n; ++ i)
+  {
+    ASSERT_TRUE(perm[i] >= 0 && perm[i] < n && !marked[perm[i]]);
+    marked[perm[i]] = 1;
+  }
+  /* and shall reduce the bandwidth and profile */
+  sp_perm_inverse(perm,n,pinv);
+  ASSERT_TRUE(sp_matrix_yale_permute(&scrambled,&reordered,pinv,pinv));
+  printf("bandwidth: %d -> %d, profile: %ld -> %ld\n",
+         sp_matrix_yale_bandwidth(&scrambled),
+         sp_matrix_yale_bandwidth(&reordered),
+         sp_matrix_yale_profile(&scrambled),
+         sp_matrix_yale_profile(&reordered));
+  EXPECT_TRUE(sp_matrix_yale_bandwidth(&reordered) <= 2*ny);
+  EXPECT_TRUE(sp_matrix_yale_profile(&reordered) <
+              sp_matrix_yale_profile(&scrambled)/10);
+  /* PCG with ILU preconditioner on the reordered matrix */
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 5 - 2;
+  sp_matrix_yale_mv(&reordered,x_expected,b);
+  sp_matrix_skyline_yale_init(&skyline,&reordered);
+  sp_matrix_skyline_ilu_copy_init(&ilu,&skyline);
+  sp_matrix_yale_solve_pcg_ilu(&reordered,&ilu,b,x0,
+                               &max_iter,&tolerance,x);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+
+  sp_matrix_skyline_ilu_free(&ilu);
+  sp_matrix_yale_free(&grid);
+  sp_matrix_yale_free(&scrambled);
+  sp_matrix_yale_free(&reordered);
+  spfree(p);
+  spfree(perm);
+  spfree(pinv);
+  spfree(marked);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+  spfree(b);
+}
+
+static void cholesky_refactor()
+{
+  const int nx = 20, ny = 15, n = 20*15;
+  sp_matrix_yale yale, other;
+  sp_chol_factor factor;
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  size_t allocated;
+  int i,p;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 9 - 4;
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* change values keeping the portrait: A = 2A + I */
+  for (i = 0; i < n; ++ i)
+    for (p = yale.offsets[i]; p < yale.offsets[i+1]; ++ p)
+      yale.values[p] = 2*yale.values[p] + (yale.indicies[p] == i);
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  /* refactorization and solution shall not allocate memory */
+  allocated = spallocated();
+  ASSERT_TRUE(sp_chol_factor_refactor(&factor,&yale));
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,b));
+  ASSERT_TRUE(allocated == spallocated());
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(b[i]-x_expected[i]) < 1e-8);
+  /* matrix with different portrait shall be rejected */
+  create_laplacian_2d(&other,ny,nx,CCS);
+  other.indicies[1] = other.indicies[1] == 1 ? 2 : 1;
+  EXPECT_TRUE(!sp_chol_factor_refactor(&factor,&other));
+  sp_matrix_yale_free(&other);
+
+  sp_chol_factor_free(&factor);
+  /* failed decomposition of the negative definite matrix -A
+   * shall not leave allocated memory */
+  for (p = 0; p < yale.nonzeros; ++ p)
+    yale.values[p] = -yale.values[p];
+  allocated = spallocated();
+  EXPECT_TRUE(!sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  ASSERT_TRUE(allocated == spallocated());
+  sp_matrix_yale_free(&yale);
+  spfree(x);
+  spfree(x_expected);
+  spfree(b);
+}
+
+static void level_schedule()
+{
+  const int nx = 30, ny = 30, n = 30*30;
+  sp_matrix_yale grid,L_crs;
+  sp_chol_factor factor;
+  sp_level_schedule schedule;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int* level = spalloc(n*sizeof(int));
+  int i,k,p;
+  create_laplacian_2d(&grid,nx,ny,CCS);
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&grid,ORDER_NESTED_DISSECTION));
+  /* rows depend only on rows of previous levels */
+  schedule = factor.schedule;
+  ASSERT_TRUE(schedule.levels_count > 1 && schedule.levels_count < n);
+  for (k = 0; k < schedule.levels_count; ++ k)
+    for (p = schedule.levels[k]; p < schedule.levels[k+1]; ++ p)
+      level[schedule.rows[p]] = k;
+  for (i = 0; i < n; ++ i)
+    for (p = factor.L.offsets[i]+1; p < factor.L.offsets[i+1]; ++ p)
+      ASSERT_TRUE(level[factor.L.indicies[p]] > level[i]);
+  printf("levels in L of %dx%d grid: %d\n",nx,ny,schedule.levels_count);
+  /* compare with sequential solvers for CCS and CRS formats */
+  for (i = 0; i < n; ++ i)
+    b[i] = i % 13 - 6;
+  ASSERT_TRUE(sp_matrix_yale_lower_solve(&factor.L,b,x_expected));
+  ASSERT_TRUE(sp_matrix_yale_lower_solve_scheduled(&factor.L,&schedule,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  ASSERT_TRUE(sp_matrix_yale_lower_trans_solve(&factor.L,b,x_expected));
+  ASSERT_TRUE(sp_matrix_yale_lower_trans_solve_scheduled(&factor.L,
+                                                         &schedule,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_matrix_yale_convert(&factor.L,&L_crs,CRS);
+  ASSERT_TRUE(sp_level_schedule_init(&schedule,n,L_crs.offsets,
+                                     L_crs.indicies,CRS));
+  ASSERT_TRUE(schedule.levels_count == factor.schedule.levels_count);
+  ASSERT_TRUE(sp_matrix_yale_lower_solve_scheduled(&L_crs,&schedule,b,x));
+  ASSERT_TRUE(sp_matrix_yale_lower_solve(&factor.L,b,x_expected));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  ASSERT_TRUE(sp_matrix_yale_lower_trans_solve_scheduled(&L_crs,&schedule,
+                                                         b,x));
+  ASSERT_TRUE(sp_matrix_yale_lower_trans_solve(&factor.L,b,x_expected));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  
+  sp_level_schedule_free(&schedule);
+  sp_matrix_yale_free(&L_crs);
+  sp_chol_factor_free(&factor);
+  sp_matrix_yale_free(&grid);
+  spfree(b);
+  spfree(x);
+  spfree(x_expected);
+  spfree(level);
+}
+
+static void sparse_lower_solve()
+{
+  const int nx = 30, ny = 20, n = 30*20;
+  sp_matrix_yale grid;
+  sp_chol_factor factor;
+  double *b = spcalloc(n,sizeof(double));
+  double *x = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int* xi = spalloc(n*sizeof(int));
+  int* workspace = spcalloc(2*n,sizeof(int));
+  char* in_portrait = spcalloc(n,sizeof(char));
+  int bi[3] = {n-40, 3, n-40};
+  double bx[3] = {2, -1, 0.5};
+  int i,count;
+  create_laplacian_2d(&grid,nx,ny,CCS);
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&grid,ORDER_NATURAL));
+  for (i = 0; i < 3; ++ i)
+    b[bi[i]] += bx[i];
+  ASSERT_TRUE(sp_matrix_yale_lower_solve(&factor.L,b,x_expected));
+  /* right-hand side with a single element touches the tail only */
+  ASSERT_TRUE(sp_matrix_yale_lower_solve_sparse(&factor.L,1,bi,bx,x,xi,
+                                                workspace,&count));
+  ASSERT_TRUE(count > 0 && count <= 40);
+  for (i = 0; i < count; ++ i)
+    x[xi[i]] = 0;
+  ASSERT_TRUE(sp_matrix_yale_lower_solve_sparse(&factor.L,3,bi,bx,x,xi,
+                                                workspace,&count));
+  ASSERT_TRUE(count > 0 && count < n);
+  for (i = 0; i < count; ++ i)
+    in_portrait[xi[i]] = 1;
+  for (i = 0; i < n; ++ i)
+  {
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+    ASSERT_TRUE(in_portrait[i] || x[i] == 0);
+    ASSERT_TRUE(workspace[n+i] == 0);
+  }
+  /* only CCS format is accepted */
+  factor.L.storage_type = CRS;
+  EXPECT_TRUE(!sp_matrix_yale_lower_solve_sparse(&factor.L,1,bi,bx,x,xi,
+                                                 workspace,&count));
+  factor.L.storage_type = CCS;
+  sp_chol_factor_free(&factor);
+  sp_matrix_yale_free(&grid);
+  spfree(b);
+  spfree(x);
+  spfree(x_expected);
+  spfree(xi);
+  spfree(workspace);
+  spfree(in_portrait);
+}
+
+/*
+ * Creates the symmetric indefinite saddle point matrix
+ * [K B'; B 0] where K is the 5-point Laplacian on the nx x ny grid
+ * and the constraints B equal unknowns 2i and 2i+1.
+ * Diagonal elements of the zero block are absent
+ */
+static void create_saddle_point(sp_matrix_yale_ptr yale,
+                                int nx, int ny,
+                                sparse_storage_type type)
+{
+  sp_matrix mtx;
+  int i,j,k;
+  int n = nx*ny, m = nx*ny/2;
+  sp_matrix_init(&mtx,n+m,n+m,5,type);
+  for (j = 0; j < ny; ++ j)
+    for (i = 0; i < nx; ++ i)
+    {
+      k = j*nx + i;
+      MTX(&mtx,k,k,4);
+      if (i > 0)
+        MTX(&mtx,k,k-1,-1);
+      if (i < nx-1)
+        MTX(&mtx,k,k+1,-1);
+      if (j > 0)
+        MTX(&mtx,k,k-nx,-1);
+      if (j < ny-1)
+        MTX(&mtx,k,k+nx,-1);
+    }
+  for (i = 0; i < m; ++ i)
+  {
+    MTX(&mtx,n+i,2*i,1);
+    MTX(&mtx,2*i,n+i,1);
+    MTX(&mtx,n+i,2*i+1,-1);
+    MTX(&mtx,2*i+1,n+i,-1);
+  }
+  sp_matrix_yale_init(yale,&mtx);
+  sp_matrix_free(&mtx);
+}
+
+static void ldl_indefinite()
+{
+  const int nx = 20, ny = 16, n = 20*16 + 20*16/2;
+  sp_matrix_yale yale;
+  sp_ldl_factor ldl;
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  size_t allocated;
+  int i,p,ordering;
+  create_saddle_point(&yale,nx,ny,CRS);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  for (ordering = ORDER_NATURAL;
+       ordering <= ORDER_REVERSE_CUTHILL_MCKEE;
+       ++ ordering)
+  {
+    ASSERT_TRUE(sp_ldl_factor_init(&ldl,&yale,(sp_ordering_type)ordering));
+    ASSERT_TRUE(sp_ldl_factor_solve(&ldl,b,x));
+    EXPECT_TRUE(ldl.converged);
+    EXPECT_TRUE(ldl.residual <= 1e-14);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+    printf("LDL' ordering %d: %d perturbed pivots, %d refinement steps\n",
+           ordering,ldl.perturbed,ldl.refinement_iterations);
+    sp_ldl_factor_free(&ldl);
+  }
+  /* zero pivots on natural ordering require the perturbation */
+  for (i = 0; i < n; ++ i)
+    for (p = yale.offsets[i]; p < yale.offsets[i+1]; ++ p)
+      if (yale.indicies[p] == i)
+        yale.values[p] = 0;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_ldl_factor_init(&ldl,&yale,ORDER_NATURAL));
+  EXPECT_TRUE(ldl.perturbed > 0);
+  /* the perturbation is compensated by the refinement, and its
+   * result is reported */
+  ASSERT_TRUE(sp_ldl_factor_solve(&ldl,b,x));
+  EXPECT_TRUE(ldl.refinement_iterations > 0);
+  EXPECT_TRUE(!ldl.converged == (ldl.residual > 1e-14));
+  /* refactorization and solution shall not allocate memory */
+  for (i = 0; i < n; ++ i)
+    for (p = yale.offsets[i]; p < yale.offsets[i+1]; ++ p)
+      if (yale.indicies[p] == i)
+        yale.values[p] = 4;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  allocated = spallocated();
+  ASSERT_TRUE(sp_ldl_factor_refactor(&ldl,&yale));
+  ASSERT_TRUE(sp_ldl_factor_solve(&ldl,b,b));
+  ASSERT_TRUE(allocated == spallocated());
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(b[i]-x_expected[i]) < 1e-8);
+  sp_ldl_factor_free(&ldl);
+  /* one-shot solver */
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_ldl_solve(&yale,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* zero matrix can't be perturbed: failure shall free everything */
+  memset(yale.values,0,yale.nonzeros*sizeof(double));
+  allocated = spallocated();
+  EXPECT_TRUE(!sp_ldl_factor_init(&ldl,&yale,ORDER_NATURAL));
+  EXPECT_TRUE(!sp_matrix_yale_ldl_solve(&yale,b,x));
+  ASSERT_TRUE(allocated == spallocated());
+  
+  sp_matrix_yale_free(&yale);
+  spfree(x);
+  spfree(x_expected);
+  spfree(b);
+}
+
+/*
+ * Creates the unsymmetric matrix of the convection-diffusion problem
+ * on the nx x ny grid with upwind differences of the convection
+ * term with velocity c along x. Rows are shifted cyclically by shift,
+ * so the pivoting is required
+ */
+static void create_convection_diffusion(sp_matrix_yale_ptr yale,
+                                        int nx, int ny,
+                                        double c,
+                                        int shift)
+{
+  sp_matrix mtx;
+  int i,j,k,r;
+  int n = nx*ny;
+  sp_matrix_init(&mtx,n,n,5,CCS);
+  for (j = 0; j < ny; ++ j)
+    for (i = 0; i < nx; ++ i)
+    {
+      k = j*nx + i;
+      r = (k + shift) % n;
+      MTX(&mtx,r,k,4+c);
+      if (i > 0)
+        MTX(&mtx,r,k-1,-1-c);
+      if (i < nx-1)
+        MTX(&mtx,r,k+1,-1);
+      if (j > 0)
+        MTX(&mtx,r,k-nx,-1);
+      if (j < ny-1)
+        MTX(&mtx,r,k+nx,-1);
+    }
+  sp_matrix_yale_init(yale,&mtx);
+  sp_matrix_free(&mtx);
+}
+
+static void yale_ilu0()
+{
+  sp_matrix mtx;
+  sp_matrix_yale yale;
+  sp_matrix_yale_ilu ilu0;
+  sp_matrix_skyline m;
+  sp_matrix_skyline_ilu ilu;
+  const int n = 40*30;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x1 = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,p,k,iter,iter0;
+  double tolerance;
+  /* the same matrix as in ilu_and_skyline */
+  double lu_diag_expected[] = {9.000000, 11.000000, 9.818182, 7.888889,
+                               11.823161, 8.000000, 7.205303};
+  sp_matrix_init(&mtx,7,7,5,CRS);
+  MTX(&mtx,0,0,9);MTX(&mtx,0,3,3);MTX(&mtx,0,4,1);MTX(&mtx,0,6,1);
+  MTX(&mtx,1,1,11);MTX(&mtx,1,2,2);MTX(&mtx,1,3,1);MTX(&mtx,1,6,2);
+  MTX(&mtx,2,1,1);MTX(&mtx,2,2,10);MTX(&mtx,2,3,2);
+  MTX(&mtx,3,0,2);MTX(&mtx,3,1,1);MTX(&mtx,3,2,2);MTX(&mtx,3,3,9);
+  MTX(&mtx,3,4,1);
+  MTX(&mtx,4,0,1);MTX(&mtx,4,3,1);MTX(&mtx,4,4,12);MTX(&mtx,4,6,1);
+  MTX(&mtx,5,5,8);
+  MTX(&mtx,6,0,2);MTX(&mtx,6,1,2);MTX(&mtx,6,4,3);MTX(&mtx,6,6,8);
+  sp_matrix_reorder(&mtx);
+  sp_matrix_yale_init(&yale,&mtx);
+  sp_matrix_skyline_yale_init(&m,&yale);
+  sp_matrix_skyline_ilu_copy_init(&ilu,&m);
+  ASSERT_TRUE(sp_matrix_yale_ilu_init(&ilu0,&yale));
+  /* the same factors as the skyline decomposition */
+  for (i = 0; i < 7; ++ i)
+  {
+    ASSERT_TRUE(fabs(ilu0.LU.values[ilu0.diag[i]] -
+                     lu_diag_expected[i]) < 1e-5);
+    for (p = ilu0.LU.offsets[i], k = ilu.parent.iptr[i];
+         p < ilu0.diag[i]; ++ p, ++ k)
+      ASSERT_TRUE(fabs(ilu0.LU.values[p] - ilu.ilu_lowertr[k]) < 1e-10);
+  }
+  sp_matrix_yale_ilu_free(&ilu0);
+  sp_matrix_skyline_ilu_free(&ilu);
+  sp_matrix_yale_free(&yale);
+  sp_matrix_free(&mtx);
+
+  /* tridiagonal matrix: ILU(0) is exact, CCS input */
+  create_convection_diffusion(&yale,n,1,0.5,0);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_ilu_init(&ilu0,&yale));
+  EXPECT_TRUE(ilu0.LU.storage_type == CRS);
+  sp_matrix_yale_ilu_solve(&ilu0,b,x);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_matrix_yale_ilu_free(&ilu0);
+  sp_matrix_yale_free(&yale);
+
+  /* PCG with both decompositions of the Laplacian */
+  create_laplacian_2d(&yale,40,30,CRS);
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  memset(x1,0,n*sizeof(double));
+  sp_matrix_skyline_yale_init(&m,&yale);
+  sp_matrix_skyline_ilu_copy_init(&ilu,&m);
+  ASSERT_TRUE(sp_matrix_yale_ilu_init(&ilu0,&yale));
+  iter = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcg_ilu(&yale,&ilu,b,x1,&iter,&tolerance,x);
+  iter0 = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcg_ilu0(&yale,&ilu0,b,x1,&iter0,&tolerance,x1);
+  EXPECT_TRUE(iter0 == iter);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x1[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ilu_free(&ilu0);
+  sp_matrix_skyline_ilu_free(&ilu);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x1);
+  spfree(x_expected);
+}
+
+static void yale_ic()
+{
+  const int nx = 40, ny = 30, n = 40*30;
+  sp_matrix_yale yale;
+  sp_matrix_yale_ilu ilu0;
+  sp_matrix_yale_ic ic;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,iter,iter_ilu0,iter_ic0;
+  double tolerance;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  /* PCG-ILU(0) as a reference */
+  ASSERT_TRUE(sp_matrix_yale_ilu_init(&ilu0,&yale));
+  iter_ilu0 = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcg_ilu0(&yale,&ilu0,b,x0,&iter_ilu0,&tolerance,x);
+  /* IC(0): portrait of the lower triangle, the same preconditioner */
+  ASSERT_TRUE(sp_matrix_yale_ic0_init(&ic,&yale));
+  EXPECT_TRUE(ic.L.nonzeros == (yale.nonzeros + n)/2);
+  iter_ic0 = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcg_ic(&yale,&ic,b,x0,&iter_ic0,&tolerance,x);
+  EXPECT_TRUE(iter_ic0 == iter_ilu0);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ic_free(&ic);
+  /* IC(tau) with fill-in needs less iterations */
+  ASSERT_TRUE(sp_matrix_yale_ict_init(&ic,&yale,1e-3,10));
+  EXPECT_TRUE(ic.L.nonzeros > (yale.nonzeros + n)/2);
+  iter = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcg_ic(&yale,&ic,b,x0,&iter,&tolerance,x);
+  EXPECT_TRUE(iter < iter_ic0);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ic_free(&ic);
+  /* no dropping: complete Cholesky decomposition */
+  ASSERT_TRUE(sp_matrix_yale_ict_init(&ic,&yale,0,n));
+  sp_matrix_yale_ic_solve(&ic,b,x);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ic_free(&ic);
+  sp_matrix_yale_ilu_free(&ilu0);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void yale_ilut()
+{
+  const int nx = 30, ny = 20, n = 30*20;
+  sp_matrix_yale yale;
+  sp_matrix_yale_ilu ilu;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,iter,iter_ilut;
+  double tolerance;
+  create_convection_diffusion(&yale,nx,ny,2,0);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  /* no dropping: complete LU decomposition */
+  ASSERT_TRUE(sp_matrix_yale_ilut_init(&ilu,&yale,0,n));
+  sp_matrix_yale_ilu_solve(&ilu,b,x);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_matrix_yale_ilu_free(&ilu);
+  /* ILUT(5,1e-3) as the right preconditioner of TFQMR and CGS */
+  ASSERT_TRUE(sp_matrix_yale_ilut_init(&ilu,&yale,1e-3,5));
+  sp_preconditioner_user_init(&precond,sp_matrix_yale_ilu_precond,&ilu);
+  EXPECT_TRUE(ilu.LU.nonzeros <= n*11);
+  iter = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_tfqmr(&yale,b,x0,&iter,&tolerance,x);
+  iter_ilut = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_ptfqmr(&yale,&precond,b,x0,&iter_ilut,&tolerance,x);
+  EXPECT_TRUE(iter_ilut < iter);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  iter = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_cgs(&yale,b,x0,&iter,&tolerance,x);
+  iter_ilut = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pcgs(&yale,&precond,b,x0,&iter_ilut,&tolerance,x);
+  EXPECT_TRUE(iter_ilut < iter);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ilu_free(&ilu);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void yale_ilut_scaled()
+{
+  const int nx = 30, ny = 20, n = 30*20;
+  const double scale = 1e9;
+  const double taus[] = {1e-1, 1e-2, 1e-3};
+  sp_matrix_yale yale;
+  sp_matrix_yale_ilu ilu;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,t,iter,iter_prev = 1001,lower;
+  double tolerance;
+  /* entries of the order of a FEM stiffness matrix */
+  create_convection_diffusion(&yale,nx,ny,2,0);
+  for (i = 0; i < yale.nonzeros; ++ i)
+    yale.values[i] *= scale;
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  /* the dropping must not depend on the scale of the matrix */
+  for (t = 0; t < 3; ++ t)
+  {
+    ASSERT_TRUE(sp_matrix_yale_ilut_init(&ilu,&yale,taus[t],n));
+    for (i = 0, lower = 0; i < n; ++ i)
+      lower += ilu.diag[i] - ilu.LU.offsets[i];
+    EXPECT_TRUE(lower > 0);
+    sp_preconditioner_user_init(&precond,sp_matrix_yale_ilu_precond,&ilu);
+    iter = 1000;
+    tolerance = 1e-10*scale;
+    sp_matrix_yale_solve_ptfqmr(&yale,&precond,b,x0,&iter,&tolerance,x);
+    EXPECT_TRUE(iter < iter_prev);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-6);
+    iter_prev = iter;
+    sp_matrix_yale_ilu_free(&ilu);
+  }
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void bicgstab_gmres_solvers()
+{
+  const int nx = 30, ny = 20, n = 30*20;
+  sp_matrix_yale yale;
+  sp_matrix_yale_ilu ilu;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *block;
+  int i,type,iter,iter_ilu;
+  double tolerance;
+  size_t allocated = spallocated();
+  /* aligned allocation */
+  block = spalloc_aligned(3*sizeof(double));
+  ASSERT_TRUE((size_t)block % SP_MEM_ALIGNMENT == 0);
+  spfree_aligned(block);
+  ASSERT_TRUE(allocated == spallocated());
+  create_convection_diffusion(&yale,nx,ny,2,0);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_ilu_init(&ilu,&yale));
+  sp_preconditioner_user_init(&precond,sp_matrix_yale_ilu_precond,&ilu);
+  /* BiCGSTAB */
+  iter = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_bicgstab(&yale,b,x0,&iter,&tolerance,x);
+  ASSERT_TRUE(tolerance < 1e-10);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  iter_ilu = 1000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pbicgstab(&yale,&precond,b,x0,&iter_ilu,&tolerance,x);
+  EXPECT_TRUE(iter_ilu < iter);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* GMRES(30): both orthogonalizations, with and without restarts */
+  iter = 2000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_gmres(&yale,30,b,x0,&iter,&tolerance,x);
+  ASSERT_TRUE(tolerance < 1e-10);
+  ASSERT_TRUE(iter > 30);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  for (type = GMRES_MGS; type <= GMRES_CGS2; ++ type)
+  {
+    iter_ilu = 2000;
+    tolerance = 1e-10;
+    sp_matrix_yale_solve_pgmres(&yale,&precond,30,
+                                (sp_gmres_orthogonalization)type,
+                                b,x0,&iter_ilu,&tolerance,x);
+    EXPECT_TRUE(iter_ilu < iter);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  }
+  /* full GMRES converges in at most n iterations */
+  iter = 2000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_pgmres(&yale,0,n,GMRES_CGS2,
+                              b,x0,&iter,&tolerance,x);
+  ASSERT_TRUE(iter <= n);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_ilu_free(&ilu);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void yale_matrix_product()
+{
+  const int nx = 6, ny = 5, n = 6*5;
+  sp_matrix mtx;
+  sp_matrix_yale A,B,C,AC,BC,CC;
+  double x[7], y[30], z[30], t[30];
+  matrix_comparison comparison;
+  int i,p,type;
+  for (type = CRS; type <= CCS; ++ type)
+  {
+    create_laplacian_2d(&A,nx,ny,(sparse_storage_type)type);
+    /* rectangular B: n x 7 */
+    sp_matrix_init(&mtx,n,7,3,(sparse_storage_type)type);
+    for (i = 0; i < n; ++ i)
+    {
+      MTX(&mtx,i,i % 7,1 + i % 3);
+      MTX(&mtx,i,(i*5) % 7,-0.5);
+    }
+    sp_matrix_yale_init(&B,&mtx);
+    sp_matrix_free(&mtx);
+    ASSERT_TRUE(sp_matrix_yale_mm(&A,&B,&C));
+    ASSERT_TRUE(C.storage_type == (sparse_storage_type)type);
+    ASSERT_TRUE(C.rows_count == n && C.cols_count == 7);
+    /* indicies are sorted */
+    for (i = 0; i < (type == CRS ? n : 7); ++ i)
+      for (p = C.offsets[i]+1; p < C.offsets[i+1]; ++ p)
+        ASSERT_TRUE(C.indicies[p-1] < C.indicies[p]);
+    /* (A*B)*x = A*(B*x) */
+    for (i = 0; i < 7; ++ i)
+      x[i] = i - 2.5;
+    sp_matrix_yale_mv(&C,x,y);
+    sp_matrix_yale_mv(&B,x,t);
+    sp_matrix_yale_mv(&A,t,z);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(y[i]-z[i]) < 1e-12);
+    /* incompatible sizes */
+    ASSERT_FALSE(sp_matrix_yale_mm(&B,&A,&AC));
+    /* transpose of the rectangular matrix */
+    sp_matrix_yale_transpose(&C,&CC);
+    sp_matrix_yale_transpose(&B,&BC);
+    ASSERT_TRUE(sp_matrix_yale_mm(&BC,&A,&AC));
+    comparison = sp_matrix_yale_cmp(&AC,&CC);
+    ASSERT_TRUE(comparison == MTX_SAME || comparison == MTX_EQUAL);
+    sp_matrix_yale_free(&A);
+    sp_matrix_yale_free(&B);
+    sp_matrix_yale_free(&C);
+    sp_matrix_yale_free(&AC);
+    sp_matrix_yale_free(&BC);
+    sp_matrix_yale_free(&CC);
+  }
+}
+
+static void yale_amg()
+{
+  const int sizes[2] = {32, 64};
+  sp_matrix_yale yale;
+  sp_amg amg;
+  double *b, *x, *x0, *x_expected;
+  int i,k,n,smoother,iter,iter_cg,iter_amg[2];
+  double tolerance;
+  size_t allocated;
+  for (smoother = AMG_SMOOTHER_JACOBI;
+       smoother <= AMG_SMOOTHER_CHEBYSHEV;
+       ++ smoother)
+  {
+    for (k = 0; k < 2; ++ k)
+    {
+      n = sizes[k]*sizes[k];
+      create_laplacian_2d(&yale,sizes[k],sizes[k],CCS);
+      b = spalloc(n*sizeof(double));
+      x = spalloc(n*sizeof(double));
+      x0 = spcalloc(n,sizeof(double));
+      x_expected = spalloc(n*sizeof(double));
+      for (i = 0; i < n; ++ i)
+        x_expected[i] = i % 7 - 3;
+      sp_matrix_yale_mv(&yale,x_expected,b);
+      ASSERT_TRUE(sp_amg_init(&amg,&yale,0.08,
+                              (sp_amg_smoother_type)smoother,2));
+      ASSERT_TRUE(amg.levels_count > 1);
+      ASSERT_TRUE(amg.levels[amg.levels_count-1].A.rows_count <
+                  SP_AMG_COARSE_SIZE);
+      /* V-cycle doesn't allocate memory */
+      allocated = spallocated();
+      sp_amg_solve(&amg,b,x);
+      ASSERT_TRUE(allocated == spallocated());
+      iter_cg = 1000;
+      tolerance = 1e-10;
+      sp_matrix_yale_solve_cg(&yale,b,x0,&iter_cg,&tolerance,x);
+      iter = 1000;
+      tolerance = 1e-10;
+      sp_matrix_yale_solve_pcg_amg(&yale,&amg,b,x0,&iter,&tolerance,x);
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+      EXPECT_TRUE(iter*4 < iter_cg);
+      iter_amg[k] = iter;
+      sp_amg_free(&amg);
+      sp_matrix_yale_free(&yale);
+      spfree(b);
+      spfree(x);
+      spfree(x0);
+      spfree(x_expected);
+    }
+    /* number of iterations almost doesn't depend on the mesh size */
+    EXPECT_TRUE(iter_amg[1] <= iter_amg[0] + 3);
+  }
+}
+
+/*
+ * Solves the SLAE by the solver number k with preconditioner precond
+ * Returns the number of iterations
+ */
+static int solve_preconditioned(sp_matrix_yale_ptr A,
+                                sp_preconditioner_ptr precond,
+                                int k,
+                                double* b,
+                                double* x0,
+                                double* x)
+{
+  int iter = 2000;
+  double tolerance = 1e-10;
+  switch (k)
+  {
+  case 0:
+    sp_matrix_yale_solve_pcg(A,precond,b,x0,&iter,&tolerance,x);
+    break;
+  case 1:
+    sp_matrix_yale_solve_pbicgstab(A,precond,b,x0,&iter,&tolerance,x);
+    break;
+  case 2:
+    sp_matrix_yale_solve_pgmres(A,precond,40,GMRES_CGS2,
+                                b,x0,&iter,&tolerance,x);
+    break;
+  case 3:
+    sp_matrix_yale_solve_ptfqmr(A,precond,b,x0,&iter,&tolerance,x);
+    break;
+  default:
+    sp_matrix_yale_solve_pcgs(A,precond,b,x0,&iter,&tolerance,x);
+  }
+  return iter;
+}
+
+static void preconditioner_objects()
+{
+  const int nx = 32, ny = 32, n = 32*32, count = 7, solvers = 5;
+  sp_matrix_yale yale;
+  sp_matrix_yale_ic ic;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,k,p,iter,iter_cg,plain[5];
+  double tolerance;
+  size_t allocated;
+  create_laplacian_2d(&yale,nx,ny,CRS);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  /* solvers without preconditioner */
+  iter_cg = 2000;
+  tolerance = 1e-10;
+  sp_matrix_yale_solve_cg(&yale,b,x0,&iter_cg,&tolerance,x);
+  for (k = 0; k < solvers; ++ k)
+    plain[k] = solve_preconditioned(&yale,0,k,b,x0,x);
+  EXPECT_TRUE(plain[0] == iter_cg);
+  ASSERT_TRUE(sp_matrix_yale_ic0_init(&ic,&yale));
+  allocated = spallocated();
+  for (p = 0; p < count; ++ p)
+  {
+    switch (p)
+    {
+    case 0: sp_preconditioner_jacobi_init(&precond); break;
+    case 1: sp_preconditioner_ilu0_init(&precond); break;
+    case 2: sp_preconditioner_ilut_init(&precond,1e-3,10); break;
+    case 3: sp_preconditioner_ic0_init(&precond); break;
+    case 4: sp_preconditioner_ict_init(&precond,1e-3,10); break;
+    case 5: sp_preconditioner_amg_init(&precond,0.08,
+                                       AMG_SMOOTHER_CHEBYSHEV,2); break;
+    default:
+      sp_preconditioner_user_init(&precond,sp_matrix_yale_ic_precond,&ic);
+    }
+    /* setup could be repeated */
+    ASSERT_TRUE(sp_preconditioner_setup(&precond,&yale));
+    ASSERT_TRUE(sp_preconditioner_setup(&precond,&yale));
+    for (k = 0; k < solvers; ++ k)
+    {
+      /* PCG only with symmetric preconditioners */
+      if (k == 0 && p == 2)
+        continue;
+      iter = solve_preconditioned(&yale,&precond,k,b,x0,x);
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+      EXPECT_TRUE(iter <= plain[k]);
+    }
+    sp_preconditioner_free(&precond);
+    ASSERT_TRUE(allocated == spallocated());
+  }
+  sp_matrix_yale_ic_free(&ic);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void iter_solver_context()
+{
+  const int nx = 24, ny = 24, n = 24*24, solves = 4;
+  const sp_iter_method methods[] = {ITER_CG, ITER_CGS, ITER_TFQMR,
+                                    ITER_BICGSTAB, ITER_GMRES};
+  sp_matrix_yale yale, small;
+  sp_iter_solver solver;
+  sp_iter_options options;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,k,m,iter,total;
+  double tolerance;
+  size_t allocated;
+  create_laplacian_2d(&yale,nx,ny,CRS);
+  create_laplacian_2d(&small,nx/2,ny/2,CRS);
+  sp_preconditioner_ilu0_init(&precond);
+  ASSERT_TRUE(sp_preconditioner_setup(&precond,&yale));
+  sp_iter_options_default(&options);
+  options.tolerance = 1e-10;
+  options.restart = 40;
+  EXPECT_FALSE(sp_iter_solver_init(&solver,ITER_CG,0,&options));
+  for (m = 0; m < 5; ++ m)
+  {
+    ASSERT_TRUE(sp_iter_solver_init(&solver,methods[m],n,&options));
+    total = 0;
+    allocated = spallocated();
+    for (k = 0; k < solves; ++ k)
+    {
+      for (i = 0; i < n; ++ i)
+        x_expected[i] = (i+k) % 7 - 3;
+      sp_matrix_yale_mv(&yale,x_expected,b);
+      EXPECT_TRUE(sp_iter_solver_solve(&solver,&yale,k&1 ? &precond : 0,
+                                       b,x0,x));
+      /* no memory allocated by solves */
+      ASSERT_TRUE(allocated == spallocated());
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+      EXPECT_TRUE(solver.stats.converged);
+      EXPECT_TRUE(solver.stats.residual < options.tolerance);
+      total += solver.stats.iterations;
+    }
+    EXPECT_TRUE(solver.stats.solves == solves);
+    EXPECT_TRUE(solver.stats.total_iterations == total);
+    /* same number of iterations as the solver function */
+    iter = options.max_iter;
+    tolerance = options.tolerance;
+    if (methods[m] == ITER_CG)
+      sp_matrix_yale_solve_pcg(&yale,&precond,b,x0,&iter,&tolerance,x);
+    else if (methods[m] == ITER_CGS)
+      sp_matrix_yale_solve_pcgs(&yale,&precond,b,x0,&iter,&tolerance,x);
+    else if (methods[m] == ITER_TFQMR)
+      sp_matrix_yale_solve_ptfqmr(&yale,&precond,b,x0,&iter,&tolerance,x);
+    else if (methods[m] == ITER_BICGSTAB)
+      sp_matrix_yale_solve_pbicgstab(&yale,&precond,b,x0,&iter,&tolerance,x);
+    else
+      sp_matrix_yale_solve_pgmres(&yale,&precond,options.restart,
+                                  GMRES_MGS,b,x0,&iter,&tolerance,x);
+    EXPECT_TRUE(iter == solver.stats.iterations);
+    EXPECT_TRUE(tolerance == solver.stats.residual);
+    /* the smaller system reuses the workspace */
+    allocated = spallocated();
+    sp_matrix_yale_mv(&small,x_expected,b);
+    EXPECT_TRUE(sp_iter_solver_solve(&solver,&small,0,b,x0,x));
+    ASSERT_TRUE(allocated == spallocated());
+    sp_iter_solver_free(&solver);
+  }
+  /* too few iterations: not converged */
+  options.max_iter = 5;
+  ASSERT_TRUE(sp_iter_solver_init(&solver,ITER_CG,n,&options));
+  EXPECT_FALSE(sp_iter_solver_solve(&solver,&yale,0,b,x0,x));
+  EXPECT_FALSE(solver.stats.converged);
+  EXPECT_TRUE(solver.stats.iterations == 5);
+  sp_iter_solver_free(&solver);
+
+  sp_preconditioner_free(&precond);
+  sp_matrix_yale_free(&small);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void cg_fused_kernels()
+{
+  const int nx = 40, ny = 30, n = 40*30;
+  sp_matrix_yale crs, ccs;
+  sp_preconditioner precond;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *y = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  int i,k,iter[2];
+  double tolerance[2], residn;
+  create_laplacian_2d(&crs,nx,ny,CRS);
+  create_laplacian_2d(&ccs,nx,ny,CCS);
+  sp_preconditioner_jacobi_init(&precond);
+  ASSERT_TRUE(sp_preconditioner_setup(&precond,&crs));
+  for (i = 0; i < n; ++ i)
+    b[i] = i % 5 - 2;
+  for (k = 0; k < 2; ++ k)
+  {
+    /* fused and not fused matrix-vector products */
+    iter[0] = iter[1] = 2000;
+    tolerance[0] = tolerance[1] = 1e-10;
+    if (k == 0)
+    {
+      sp_matrix_yale_solve_cg(&crs,b,x0,&iter[0],&tolerance[0],x);
+      sp_matrix_yale_solve_cg(&ccs,b,x0,&iter[1],&tolerance[1],y);
+    }
+    else
+    {
+      sp_matrix_yale_solve_pcg(&crs,&precond,b,x0,&iter[0],&tolerance[0],x);
+      sp_matrix_yale_solve_pcg(&ccs,&precond,b,x0,&iter[1],&tolerance[1],y);
+    }
+    EXPECT_TRUE(iter[0] == iter[1]);
+    EXPECT_TRUE(fabs(tolerance[0] - tolerance[1]) < 1e-12);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-y[i]) < 1e-10);
+    /* residual norm updated by the fused kernel is the true one */
+    sp_matrix_yale_mv(&crs,x,y);
+    for (i = 0; i < n; ++ i)
+      y[i] = b[i] - y[i];
+    residn = 0;
+    for (i = 0; i < n; ++ i)
+      residn += y[i]*y[i];
+    EXPECT_TRUE(tolerance[0] < 1e-10);
+    EXPECT_TRUE(fabs(sqrt(residn) - tolerance[0]) < 1e-11);
+  }
+  sp_preconditioner_free(&precond);
+  sp_matrix_yale_free(&crs);
+  sp_matrix_yale_free(&ccs);
+  spfree(b);
+  spfree(x);
+  spfree(y);
+  spfree(x0);
+}
+
+static void pipelined_cg()
+{
+  const int nx = 40, ny = 30, n = 40*30;
+  sp_matrix_yale yale;
+  sp_preconditioner precond;
+  sp_iter_solver solver;
+  sp_iter_options options;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *r = spalloc(n*sizeof(double));
+  double *x0 = spcalloc(n,sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  int i,k,iter,iter_pcg;
+  double tolerance, residn;
+  create_laplacian_2d(&yale,nx,ny,CRS);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 7 - 3;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  for (k = 0; k < 3; ++ k)
+  {
+    if (k == 1)
+      sp_preconditioner_jacobi_init(&precond);
+    else if (k == 2)
+      sp_preconditioner_ic0_init(&precond);
+    if (k > 0)
+      ASSERT_TRUE(sp_preconditioner_setup(&precond,&yale));
+    iter_pcg = 2000;
+    tolerance = 1e-10;
+    sp_matrix_yale_solve_pcg(&yale,k ? &precond : 0,b,x0,
+                             &iter_pcg,&tolerance,x);
+    iter = 2000;
+    tolerance = 1e-10;
+    sp_matrix_yale_solve_pipecg(&yale,k ? &precond : 0,b,x0,
+                                &iter,&tolerance,x);
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+    /* the same method in exact arithmetic */
+    EXPECT_TRUE(iter <= iter_pcg + 2 && iter_pcg <= iter + 2);
+    /* recursively updated residual is close to the true one */
+    sp_matrix_yale_mv(&yale,x,r);
+    residn = 0;
+    for (i = 0; i < n; ++ i)
+      residn += (b[i]-r[i])*(b[i]-r[i]);
+    EXPECT_TRUE(sqrt(residn) < 1e-9);
+    if (k > 0)
+      sp_preconditioner_free(&precond);
+  }
+  /* solver context: frequent residual replacement and none */
+  for (k = 0; k < 2; ++ k)
+  {
+    sp_iter_options_default(&options);
+    options.replacement = k ? 0 : 5;
+    ASSERT_TRUE(sp_iter_solver_init(&solver,ITER_PIPECG,n,&options));
+    EXPECT_TRUE(sp_iter_solver_solve(&solver,&yale,0,b,x0,x));
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+    sp_iter_solver_free(&solver);
+  }
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(r);
+  spfree(x0);
+  spfree(x_expected);
+}
+
+static void block_cg()
+{
+  const int nx = 32, ny = 32, n = 32*32, nrhs = 5;
+  sp_matrix_yale yale;
+  sp_preconditioner precond;
+  double *B = spalloc(n*nrhs*sizeof(double));
+  double *X = spalloc(n*nrhs*sizeof(double));
+  double *X0 = spcalloc(n*nrhs,sizeof(double));
+  double *X_expected = spalloc(n*nrhs*sizeof(double));
+  double *Y = spalloc(n*nrhs*sizeof(double));
+  double residuals[5], tolerance;
+  int iterations[5];
+  int i,c,k,iter,iter_cg,total_cg;
+  create_laplacian_2d(&yale,nx,ny,CRS);
+  for (c = 0; c < nrhs; ++ c)
+    for (i = 0; i < n; ++ i)
+      X_expected[c*n+i] = (i*(c+1)) % 7 - 3 + c;
+  /* column 3 depends on columns 0 and 1 */
+  for (i = 0; i < n; ++ i)
+    X_expected[3*n+i] = X_expected[i] - 2*X_expected[n+i];
+  /* block matrix-vector product */
+  for (c = 0; c < nrhs; ++ c)
+    sp_matrix_yale_mv(&yale,X_expected+c*n,B+c*n);
+  for (i = 0; i < n; ++ i)
+    for (c = 0; c < nrhs; ++ c)
+      X[i*nrhs+c] = X_expected[c*n+i];
+  sp_matrix_yale_mv_block(&yale,nrhs,X,Y);
+  for (i = 0; i < n; ++ i)
+    for (c = 0; c < nrhs; ++ c)
+      ASSERT_TRUE(EQL(Y[i*nrhs+c],B[c*n+i]));
+  /* column 4 starts from the exact solution */
+  memcpy(X0+4*n,X_expected+4*n,n*sizeof(double));
+  sp_preconditioner_jacobi_init(&precond);
+  ASSERT_TRUE(sp_preconditioner_setup(&precond,&yale));
+  for (k = 0; k < 2; ++ k)
+  {
+    iter = 2000;
+    EXPECT_TRUE(sp_matrix_yale_solve_block_cg(&yale,k ? &precond : 0,
+                                              nrhs,B,X0,&iter,1e-10,
+                                              iterations,residuals,X));
+    for (c = 0; c < nrhs; ++ c)
+    {
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(X[c*n+i]-X_expected[c*n+i]) < 1e-8);
+      EXPECT_TRUE(residuals[c] < 1e-10);
+      EXPECT_TRUE(iterations[c] <= iter);
+    }
+    EXPECT_TRUE(iterations[4] == 0);
+    /* block iterations versus CG for every not solved column */
+    total_cg = 0;
+    for (c = 0; c < nrhs-1; ++ c)
+    {
+      iter_cg = 2000;
+      tolerance = 1e-10;
+      sp_matrix_yale_solve_pcg(&yale,k ? &precond : 0,B+c*n,X0+c*n,
+                               &iter_cg,&tolerance,Y);
+      EXPECT_TRUE(iterations[c] <= iter_cg + 1);
+      total_cg += iter_cg;
+    }
+    EXPECT_TRUE(iter*2 < total_cg);
+  }
+  /* not enough iterations */
+  iter = 3;
+  EXPECT_FALSE(sp_matrix_yale_solve_block_cg(&yale,0,nrhs,B,X0,&iter,1e-10,
+                                             iterations,residuals,X));
+  EXPECT_TRUE(iter == 3 && iterations[0] == 3 && residuals[0] > 1e-10);
+  sp_preconditioner_free(&precond);
+  sp_matrix_yale_free(&yale);
+  spfree(B);
+  spfree(X);
+  spfree(X0);
+  spfree(X_expected);
+  spfree(Y);
+}
+
+static void lu_unsymmetric()
+{
+  const int nx = 25, ny = 20, n = 25*20;
+  sp_matrix_yale yale,other;
+  sp_lu_factor lu;
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  size_t allocated;
+  int i,p,shift,ordering;
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 11 - 5;
+  for (shift = 0; shift <= 7; shift += 7)
+  {
+    create_convection_diffusion(&yale,nx,ny,50,shift);
+    sp_matrix_yale_mv(&yale,x_expected,b);
+    for (ordering = ORDER_NATURAL;
+         ordering <= ORDER_REVERSE_CUTHILL_MCKEE;
+         ++ ordering)
+    {
+      ASSERT_TRUE(sp_lu_factor_init(&lu,&yale,(sp_ordering_type)ordering,
+                                    SP_LU_PIVOT_TOLERANCE));
+      ASSERT_TRUE(sp_lu_factor_solve(&lu,b,x));
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+      sp_lu_factor_free(&lu);
+    }
+    sp_matrix_yale_free(&yale);
+  }
+  /* refactorization with the same pivots */
+  create_convection_diffusion(&yale,nx,ny,50,7);
+  ASSERT_TRUE(sp_lu_factor_init(&lu,&yale,ORDER_NESTED_DISSECTION,
+                                SP_LU_PIVOT_TOLERANCE));
+  for (i = 0; i < n; ++ i)
+    for (p = yale.offsets[i]; p < yale.offsets[i+1]; ++ p)
+      yale.values[p] *= 1 + (yale.indicies[p] % 3)*0.01;
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  allocated = spallocated();
+  ASSERT_TRUE(sp_lu_factor_refactor(&lu,&yale));
+  ASSERT_TRUE(sp_lu_factor_solve(&lu,b,b));
+  ASSERT_TRUE(allocated == spallocated());
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(b[i]-x_expected[i]) < 1e-8);
+  /* matrix with different portrait shall be rejected */
+  create_convection_diffusion(&other,ny,nx,50,7);
+  EXPECT_TRUE(!sp_lu_factor_refactor(&lu,&other));
+  sp_matrix_yale_free(&other);
+  sp_lu_factor_free(&lu);
+  /* one-shot solver */
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_lu_solve(&yale,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* singular matrix: zero column */
+  for (p = yale.offsets[3]; p < yale.offsets[4]; ++ p)
+    yale.values[p] = 0;
+  EXPECT_TRUE(!sp_lu_factor_init(&lu,&yale,ORDER_NATURAL,
+                                 SP_LU_PIVOT_TOLERANCE));
+  sp_matrix_yale_free(&yale);
+  spfree(x);
+  spfree(x_expected);
+  spfree(b);
+}
+
+static void cholesky_block_solve()
+{
+  const int nx = 20, ny = 15, n = 20*15, nrhs = 11;
+  sp_matrix_yale yale;
+  sp_chol_factor factor;
+  double *B = spalloc(n*nrhs*sizeof(double));
+  double *X = spalloc(n*nrhs*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *b = spcalloc(n,sizeof(double));
+  int bi[2] = {7, 250};
+  double bx[2] = {1.5, -2};
+  size_t allocated;
+  int i,r,ordering;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  for (i = 0; i < n*nrhs; ++ i)
+    B[i] = (i*7) % 17 - 8;
+  for (ordering = ORDER_NATURAL;
+       ordering <= ORDER_NESTED_DISSECTION;
+       ++ ordering)
+  {
+    ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,
+                                    (sp_ordering_type)ordering));
+    /* block solver shall give the same results as one by one */
+    allocated = spallocated();
+    ASSERT_TRUE(sp_chol_factor_solve_block(&factor,nrhs,B,X));
+    ASSERT_TRUE(allocated == spallocated());
+    for (r = 0; r < nrhs; ++ r)
+    {
+      ASSERT_TRUE(sp_chol_factor_solve(&factor,B+r*n,x));
+      for (i = 0; i < n; ++ i)
+        ASSERT_TRUE(fabs(x[i]-X[r*n+i]) < 1e-10);
+    }
+    /* sparse right-hand side */
+    b[bi[0]] = bx[0];
+    b[bi[1]] = bx[1];
+    ASSERT_TRUE(sp_chol_factor_solve(&factor,b,X));
+    ASSERT_TRUE(sp_chol_factor_solve_sparse(&factor,2,bi,bx,x));
+    ASSERT_TRUE(allocated == spallocated());
+    for (i = 0; i < n; ++ i)
+      ASSERT_TRUE(fabs(x[i]-X[i]) < 1e-10);
+    /* zero diagonal element is detected as in the single solver */
+    factor.L.values[factor.L.offsets[n/2]] = 0;
+    EXPECT_TRUE(!sp_chol_factor_solve(&factor,B,x));
+    EXPECT_TRUE(!sp_chol_factor_solve_block(&factor,nrhs,B,X));
+    sp_chol_factor_free(&factor);
+  }
+  sp_matrix_yale_free(&yale);
+  spfree(B);
+  spfree(X);
+  spfree(x);
+  spfree(b);
+}
+
+/*
+ * Calculates y = (A + sigma*WW')x
+ */
+static void updown_mv(sp_matrix_yale_ptr A, sp_matrix_yale_ptr W,
+                      int sigma, double* x, double* y)
+{
+  int c,p;
+  double t;
+  sp_matrix_yale_mv(A,x,y);
+  for (c = 0; c < W->cols_count; ++ c)
+  {
+    for (t = 0, p = W->offsets[c]; p < W->offsets[c+1]; ++ p)
+      t += W->values[p]*x[W->indicies[p]];
+    for (p = W->offsets[c]; p < W->offsets[c+1]; ++ p)
+      y[W->indicies[p]] += sigma*t*W->values[p];
+  }
+}
+
+static void cholesky_updown()
+{
+  const int nx = 20, ny = 15, n = 20*15;
+  sp_matrix mtx;
+  sp_matrix_yale yale,W,L;
+  sp_chol_symbolic symb;
+  sp_chol_factor factor;
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  double *b = spalloc(n*sizeof(double));
+  int i,nonzeros;
+  size_t allocated;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  /* W: springs between distant nodes introduce new fill */
+  sp_matrix_init(&mtx,n,2,2,CCS);
+  MTX(&mtx,5,0,1);
+  MTX(&mtx,n-3,0,-2);
+  MTX(&mtx,n/2,1,1.5);
+  MTX(&mtx,n/2+1,1,-0.5);
+  sp_matrix_yale_init(&W,&mtx);
+  sp_matrix_free(&mtx);
+  for (i = 0; i < n; ++ i)
+    x_expected[i] = i % 5 - 2;
+  
+  /* update and downdate of the factor L */
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic(&yale,&symb));
+  ASSERT_TRUE(sp_matrix_yale_chol_numeric(&yale,&symb,&L));
+  nonzeros = L.nonzeros;
+  ASSERT_TRUE(sp_matrix_yale_chol_updown(&L,1,&W));
+  ASSERT_TRUE(L.nonzeros > nonzeros);
+  updown_mv(&yale,&W,1,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_chol_numeric_solve(&L,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  ASSERT_TRUE(sp_matrix_yale_chol_updown(&L,-1,&W));
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_matrix_yale_chol_numeric_solve(&L,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  sp_matrix_yale_free(&L);
+  sp_matrix_yale_symbolic_free(&symb);
+
+  /* update of the reordered decomposition object */
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  ASSERT_TRUE(sp_chol_factor_updown(&factor,1,&W));
+  updown_mv(&yale,&W,1,x_expected,b);
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* refactorization restores the decomposition of A without allocations */
+  allocated = spallocated();
+  spallocated_reset_peak();
+  ASSERT_TRUE(sp_chol_factor_refactor(&factor,&yale));
+  EXPECT_TRUE(spallocated_peak() == allocated);
+  sp_matrix_yale_mv(&yale,x_expected,b);
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-8);
+  /* downdate to not positive-definite matrix shall fail */
+  for (i = 0; i < W.nonzeros; ++ i)
+    W.values[i] *= 10;
+  EXPECT_TRUE(!sp_chol_factor_updown(&factor,-1,&W));
+  sp_chol_factor_free(&factor);
+  
+  sp_matrix_yale_free(&yale);
+  sp_matrix_yale_free(&W);
+  spfree(x);
+  spfree(x_expected);
+  spfree(b);
+}
+
+static void cholesky_out_of_core()
+{
+  const int nx = 30, ny = 30, n = 30*30;
+  sp_matrix_yale yale;
+  sp_chol_factor factor;
+  sp_chol_ooc ooc;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  const char* filename = "cholesky_ooc.tmp";
+  size_t allocated;
+  int i;
+  FILE* f;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  for (i = 0; i < n; ++ i)
+    b[i] = (i*7) % 17 - 8;
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,x_expected));
+  /* budget of 160Kb is less than values and row indicies of L */
+  allocated = spallocated();
+  ASSERT_TRUE(sp_chol_ooc_init(&ooc,&yale,ORDER_NESTED_DISSECTION,
+                               160*1024,filename));
+  EXPECT_TRUE(spallocated() - allocated <= 160*1024);
+  EXPECT_TRUE(ooc.panels_count > 1);
+  EXPECT_TRUE(ooc.symb.nonzeros == factor.L.nonzeros);
+  allocated = spallocated();
+  ASSERT_TRUE(sp_chol_ooc_solve(&ooc,b,x));
+  ASSERT_TRUE(allocated == spallocated());
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_chol_ooc_free(&ooc);
+  /* scratch file shall be removed */
+  f = fopen(filename,"rb");
+  EXPECT_TRUE(!f);
+  if (f)
+    fclose(f);
+  /* anonymous scratch file, natural ordering: without temporaries
+   * of the ordering the peak memory usage is within the budget */
+  allocated = spallocated();
+  spallocated_reset_peak();
+  ASSERT_TRUE(sp_chol_ooc_init(&ooc,&yale,ORDER_NATURAL,64*1024,0));
+  EXPECT_TRUE(spallocated_peak() - allocated <= 64*1024);
+  EXPECT_TRUE(ooc.panels_count > 1);
+  ASSERT_TRUE(sp_chol_ooc_solve(&ooc,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_chol_ooc_free(&ooc);
+  /* budget less than workspaces is rejected */
+  allocated = spallocated();
+  EXPECT_TRUE(!sp_chol_ooc_init(&ooc,&yale,ORDER_NATURAL,16*1024,0));
+  ASSERT_TRUE(allocated == spallocated());
+  sp_chol_factor_free(&factor);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x_expected);
+}
+
+static void cholesky_mixed_precision()
+{
+  const int nx = 25, ny = 20, n = 25*20;
+  sp_matrix_yale yale;
+  sp_chol_factor factor;
+  sp_chol_mixed mixed;
+  double *b = spalloc(n*sizeof(double));
+  double *x = spalloc(n*sizeof(double));
+  double *x_expected = spalloc(n*sizeof(double));
+  size_t allocated;
+  int i;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  for (i = 0; i < n; ++ i)
+    b[i] = (i*7) % 17 - 8;
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  ASSERT_TRUE(sp_chol_factor_solve(&factor,b,x_expected));
+  ASSERT_TRUE(sp_chol_mixed_init(&mixed,&yale,ORDER_NESTED_DISSECTION,
+                                 SP_CHOL_MIXED_TOLERANCE));
+  /* factor in double precision is not allocated */
+  EXPECT_TRUE(!mixed.fallback && !mixed.chol.L.values);
+  allocated = spallocated();
+  ASSERT_TRUE(sp_chol_mixed_solve(&mixed,b,x));
+  ASSERT_TRUE(allocated == spallocated());
+  EXPECT_TRUE(!mixed.fallback && mixed.iterations > 0);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  /* unreachable tolerance: refinement stalls and falls back */
+  mixed.tolerance = 0;
+  ASSERT_TRUE(sp_chol_mixed_refactor(&mixed,&yale));
+  ASSERT_TRUE(sp_chol_mixed_solve(&mixed,b,x));
+  EXPECT_TRUE(mixed.fallback && !mixed.values);
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  /* refactorization after fallback stays in double precision */
+  ASSERT_TRUE(sp_chol_mixed_refactor(&mixed,&yale));
+  ASSERT_TRUE(sp_chol_mixed_solve(&mixed,b,x));
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(fabs(x[i]-x_expected[i]) < 1e-10);
+  sp_chol_mixed_free(&mixed);
+  sp_chol_factor_free(&factor);
+  sp_matrix_yale_free(&yale);
+  spfree(b);
+  spfree(x);
+  spfree(x_expected);
+}
+
+static void cholesky_estimate()
+{
+  const int nx = 30, ny = 25;
+  sp_matrix_yale yale;
+  sp_chol_symbolic symb;
+  sp_chol_factor factor;
+  sp_chol_mixed mixed;
+  sp_chol_estimate estimate;
+  size_t allocated,actual;
+  double flops;
+  int j;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic_ordered(&yale,&symb,
+                                                   ORDER_NESTED_DISSECTION));
+  allocated = spallocated();
+  sp_matrix_yale_chol_estimate(&yale,&symb,0,&estimate);
+  ASSERT_TRUE(allocated == spallocated());
+  for (flops = 0, j = 0; j < yale.rows_count; ++ j)
+    flops += (double)symb.colcounts[j]*symb.colcounts[j];
+  EXPECT_TRUE(estimate.flops == flops);
+  EXPECT_TRUE(estimate.solve_flops == 4.0*symb.nonzeros);
+  EXPECT_TRUE(estimate.time_numeric == flops/SP_CHOL_FLOPS_RATE);
+  EXPECT_TRUE(estimate.time_mixed < estimate.time_numeric);
+  /* resident memory estimates shall be within 10% of the memory
+   * allocated by the initialized objects */
+  ASSERT_TRUE(sp_chol_factor_init(&factor,&yale,ORDER_NESTED_DISSECTION));
+  actual = spallocated() - allocated;
+  EXPECT_TRUE(factor.L.nonzeros == symb.nonzeros);
+  EXPECT_TRUE(fabs((double)actual -
+                   (estimate.factor_bytes+estimate.resident_bytes)) <
+              0.1*actual);
+  sp_chol_factor_free(&factor);
+  ASSERT_TRUE(sp_chol_mixed_init(&mixed,&yale,ORDER_NESTED_DISSECTION,
+                                 SP_CHOL_MIXED_TOLERANCE));
+  actual = spallocated() - allocated;
+  EXPECT_TRUE(fabs((double)actual - estimate.mixed_bytes) < 0.1*actual);
+  EXPECT_TRUE(estimate.mixed_bytes <
+              estimate.factor_bytes+estimate.resident_bytes);
+  sp_chol_mixed_free(&mixed);
+  sp_matrix_yale_symbolic_free(&symb);
+  sp_matrix_yale_free(&yale);
+}
+
+static void cholesky_counts()
+{
+  const int nx = 30, ny = 20, n = 30*20;
+  sp_matrix_yale grid,yale;
+  int* p = spalloc(n*sizeof(int));
+  int* etree = spalloc(n*sizeof(int));
+  int* rowcounts = spalloc(n*sizeof(int));
+  int* colcounts = spalloc(n*sizeof(int));
+  int* expected_colcounts = spcalloc(n,sizeof(int));
+  int* reach = spalloc(n*sizeof(int));
+  int i,j,count;
+  create_laplacian_2d(&grid,nx,ny,CCS);
+  for (i = 0; i < n; ++ i)
+    p[i] = (int)((7919L*i) % n);
+  ASSERT_TRUE(sp_matrix_yale_permute(&grid,&yale,p,p));
+  ASSERT_TRUE(sp_matrix_yale_etree(&yale,etree));
+  ASSERT_TRUE(sp_matrix_yale_chol_counts(&yale,etree,rowcounts,colcounts));
+  /* compare with counts from portraits of rows of L */
+  for (i = 0; i < n; ++ i)
+  {
+    count = sp_matrix_yale_ereach(&yale,etree,i,reach);
+    ASSERT_TRUE(count == rowcounts[i]);
+    for (j = 0; j < count; ++ j)
+      expected_colcounts[reach[j]]++;
+  }
+  for (i = 0; i < n; ++ i)
+    ASSERT_TRUE(colcounts[i] == expected_colcounts[i]);
+
+  sp_matrix_yale_free(&grid);
+  sp_matrix_yale_free(&yale);
+  spfree(p);
+  spfree(etree);
+  spfree(rowcounts);
+  spfree(colcounts);
+  spfree(expected_colcounts);
+  spfree(reach);
+}
+
+
+static void cholesky_structure()
+{
+  const int nx = 300, ny = 300, n = 300*300;
+  sp_matrix_yale grid;
+  sp_chol_symbolic symb;
+  int* reach = spalloc(n*sizeof(int));
+  int i,j,p,count;
+  clock_t start;
+  create_laplacian_2d(&grid,nx,ny,CCS);
+  start = clock();
+  ASSERT_TRUE(sp_matrix_yale_chol_symbolic_ordered(&grid,&symb,
+                                                   ORDER_NESTED_DISSECTION));
+  printf("symbolic analysis of %dx%d grid: %d ms, nonzeros in L: %d\n",
+         nx,ny,(int)((clock()-start)*1000/CLOCKS_PER_SEC),symb.nonzeros);
+  for (i = 0; i < n; ++ i)
+  {
+    /* CRS: sorted, diagonal last */
+    p = symb.crs_offsets[i+1]-1;
+    ASSERT_TRUE(symb.crs_indicies[p] == i);
+    for (j = symb.crs_offsets[i]; j < p; ++ j)
+      ASSERT_TRUE(symb.crs_indicies[j] < symb.crs_indicies[j+1]);
+    /* CCS: sorted, diagonal first */
+    p = symb.ccs_offsets[i];
+    ASSERT_TRUE(symb.ccs_indicies[p] == i);
+    for (j = p; j < symb.ccs_offsets[i+1]-1; ++ j)
+      ASSERT_TRUE(symb.ccs_indicies[j] < symb.ccs_indicies[j+1]);
+  }
+  sp_matrix_yale_free(&grid);
+  /* compare rows with ereach for the reordered matrix */
+  create_laplacian_2d(&grid,nx,ny,CCS);
+  {
+    sp_matrix_yale yale;
+    ASSERT_TRUE(sp_matrix_yale_permute(&grid,&yale,symb.pinv,symb.pinv));
+    for (i = 0; i < n; i += 97)
+    {
+      count = sp_matrix_yale_ereach(&yale,symb.etree,i,reach);
+      ASSERT_TRUE(count == symb.rowcounts[i]);
+      for (j = 0; j < count; ++ j)
+        ASSERT_TRUE(reach[j] == symb.crs_indicies[symb.crs_offsets[i]+j]);
+    }
+    sp_matrix_yale_free(&yale);
+  }
+  sp_matrix_yale_free(&grid);
+  sp_matrix_yale_symbolic_free(&symb);
+  spfree(reach);
+}
+
 
 static void load_from_files()
 {
@@ -845,12 +2524,19 @@ static void etree_create_etree()
    */
   int etree_expected[] = {6,3,8,6,8,7,9,10,10,11,0};
   int etree[11];
+  sp_matrix_yale crs;
   ASSERT_TRUE(sp_matrix_yale_etree(&yale,etree));
   ASSERT_TRUE(etree[0] == etree_expected[0] - 1);
   
   for ( i = 1; i < 11; ++ i)
     ASSERT_TRUE(etree[i] == etree_expected[i] - 1);
   /* tree_dot_printf(etree,11); */
+  /* the same tree for the symmetric matrix in CRS format */
+  sp_matrix_yale_convert(&yale,&crs,CRS);
+  ASSERT_TRUE(sp_matrix_yale_etree(&crs,etree));
+  for ( i = 0; i < 11; ++ i)
+    ASSERT_TRUE(etree[i] == etree_expected[i] - 1);
+  sp_matrix_yale_free(&crs);
 }
 
 static void etree_postorder()
@@ -980,6 +2666,28 @@ static void etree_ereach()
   }
 }
 
+static void etree_ereach_marker()
+{
+  int i,j,count;
+  int etree[11], etree_copy[11];
+  int ereach[11], ereach_marker[11];
+  int marker[11];
+  ASSERT_TRUE(sp_matrix_yale_etree(&yale,etree));
+  memcpy(etree_copy,etree,sizeof(etree));
+  for (i = 0; i < 11; ++ i)
+    marker[i] = -1;
+  /* the same workspace for all rows, the etree is read only */
+  for (i = 0; i < 11; ++ i)
+  {
+    count = sp_matrix_yale_ereach(&yale,etree,i,ereach);
+    ASSERT_TRUE(sp_matrix_yale_ereach_marker(&yale,etree,i,marker,
+                                             ereach_marker) == count);
+    for (j = 0; j < count; ++ j)
+      ASSERT_TRUE(ereach[j] == ereach_marker[j]);
+    ASSERT_TRUE(!memcmp(etree,etree_copy,sizeof(etree)));
+  }
+}
+
 static void etree_rowcolcounts()
 {
   int i;
@@ -1599,6 +3307,7 @@ static void big_etree_postorder()
   int* post_expected = 0;
   int* post = 0;
   int size,i;
+  clock_t start;
   EXPECT_TRUE((result = sp_load_int_vector(&etree,
                                            &size,
                                            "data/big_etree.txt")));
@@ -1610,7 +3319,10 @@ static void big_etree_postorder()
     {
       ASSERT_TRUE(size == i);
       post = spcalloc(size, sizeof(int));
+      start = clock();
       tree_postorder_perm(etree,size,post);
+      printf("postorder of the tree with %d nodes: %.4f s\n",size,
+             (double)(clock()-start)/CLOCKS_PER_SEC);
       /* compare */
       for (i = 0; i < size; ++ i)
       {
@@ -1628,6 +3340,38 @@ static void big_etree_postorder()
   spfree(post);
 }
 
+static void big_etree_benchmark()
+{
+  const int nx = 400, ny = 400, n = 400*400;
+  sp_matrix_yale yale;
+  int* etree = spalloc(n*sizeof(int));
+  int* post = spalloc(n*sizeof(int));
+  int* pinv = spalloc(n*sizeof(int));
+  int i;
+  clock_t start;
+  create_laplacian_2d(&yale,nx,ny,CCS);
+  start = clock();
+  ASSERT_TRUE(sp_matrix_yale_etree(&yale,etree));
+  printf("elimination tree of the %dx%d grid: %.4f s\n",nx,ny,
+         (double)(clock()-start)/CLOCKS_PER_SEC);
+  start = clock();
+  tree_postorder_perm(etree,n,post);
+  printf("postorder of the elimination tree: %.4f s\n",
+         (double)(clock()-start)/CLOCKS_PER_SEC);
+  /* parents are numbered after children in both orders */
+  sp_perm_inverse(post,n,pinv);
+  for (i = 0; i < n; ++ i)
+    if (etree[i] != -1)
+    {
+      ASSERT_TRUE(etree[i] > i);
+      ASSERT_TRUE(pinv[etree[i]] > pinv[i]);
+    }
+  sp_matrix_yale_free(&yale);
+  spfree(etree);
+  spfree(post);
+  spfree(pinv);
+}
+
 #if 0
 static void lower_solve()
 {
@@ -1704,6 +3448,18 @@ int main(int argc, const char *argv[])
   SP_ADD_TEST(tfqmr_solver);  
   SP_ADD_TEST(ilu_and_skyline);
   SP_ADD_TEST(pcg_ilu_solver);
+  SP_ADD_TEST(yale_ilu0);
+  SP_ADD_TEST(yale_ic);
+  SP_ADD_TEST(yale_ilut);
+  SP_ADD_TEST(yale_ilut_scaled);
+  SP_ADD_TEST(bicgstab_gmres_solvers);
+  SP_ADD_TEST(yale_matrix_product);
+  SP_ADD_TEST(yale_amg);
+  SP_ADD_TEST(preconditioner_objects);
+  SP_ADD_TEST(iter_solver_context);
+  SP_ADD_TEST(cg_fused_kernels);
+  SP_ADD_TEST(pipelined_cg);
+  SP_ADD_TEST(block_cg);
   SP_ADD_TEST(load_from_files);
   SP_ADD_TEST(stack_container);
   SP_ADD_TEST(queue_container);
@@ -1711,15 +3467,31 @@ int main(int argc, const char *argv[])
   SP_ADD_TEST(yale_transpose_convert);
   SP_ADD_TEST(yale_properties);
   SP_ADD_TEST(big_etree_postorder);
+  SP_ADD_TEST(big_etree_benchmark);
   /* SP_ADD_TEST(lower_solve); */
   
   suite1 = sp_add_suite("etree",test_etree_init,test_etree_fini);
   SP_ADD_SUITE_TEST(suite1,etree_create_etree);
   SP_ADD_SUITE_TEST(suite1,etree_postorder);
   SP_ADD_SUITE_TEST(suite1,etree_ereach);
+  SP_ADD_SUITE_TEST(suite1,etree_ereach_marker);
   SP_ADD_SUITE_TEST(suite1,etree_rowcolcounts);
   /* SP_ADD_SUITE_TEST(suite1,etree_rowcount); */
   SP_ADD_TEST(cholesky);
+  SP_ADD_TEST(nested_dissection);
+  SP_ADD_TEST(rcm_ordering);
+  SP_ADD_TEST(cholesky_refactor);
+  SP_ADD_TEST(cholesky_block_solve);
+  SP_ADD_TEST(cholesky_updown);
+  SP_ADD_TEST(cholesky_out_of_core);
+  SP_ADD_TEST(cholesky_mixed_precision);
+  SP_ADD_TEST(cholesky_estimate);
+  SP_ADD_TEST(cholesky_counts);
+  SP_ADD_TEST(cholesky_structure);
+  SP_ADD_TEST(level_schedule);
+  SP_ADD_TEST(sparse_lower_solve);
+  SP_ADD_TEST(ldl_indefinite);
+  SP_ADD_TEST(lu_unsymmetric);
   SP_ADD_TEST(big_matrix_from_file1);
   SP_ADD_TEST(big_matrix_from_file2);
   SP_ADD_TEST(big_matrix_from_file3);